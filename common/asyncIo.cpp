@@ -0,0 +1,399 @@
+/**
+ * @file asyncIo.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация асинхронного ввода-вывода на io_uring и конвейера блоков
+ */
+
+#include "asyncIo.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+using namespace std;
+
+/// Наибольшая длина одной операции (поле len заявки 32-битное)
+static const size_t IO_MAX = size_t(1) << 30;
+
+/**
+ * @brief Конструктор очереди
+ * @param depth наибольшее количество одновременных операций
+ * @param useUring false — сразу синхронный режим
+ * @details При любой ошибке настройки io_uring очередь остается синхронной
+ */
+ 
+asyncIo::asyncIo(unsigned depth, bool useUring)
+{
+    if (!useUring)
+        return;
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = syscall(__NR_io_uring_setup, max(depth, 1u), &p);
+    if (fd < 0)
+        return;
+    
+    sqMapSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqMapSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+        sqMapSize = cqMapSize = max(sqMapSize, cqMapSize);
+    sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 fd, IORING_OFF_SQ_RING);
+    if (sqMap == MAP_FAILED) {
+        close(fd);
+        sqMap = nullptr;
+        return;
+    }
+    cqMap = single ? sqMap : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void* s = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   fd, IORING_OFF_SQES);
+    if (cqMap == MAP_FAILED || s == MAP_FAILED) {
+        if (cqMap != MAP_FAILED && !single)
+            munmap(cqMap, cqMapSize);
+        if (s != MAP_FAILED)
+            munmap(s, sqesSize);
+        munmap(sqMap, sqMapSize);
+        sqMap = cqMap = nullptr;
+        close(fd);
+        return;
+    }
+    
+    char* sq = static_cast<char*>(sqMap);
+    char* cq = static_cast<char*>(cqMap);
+    sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    sqes = static_cast<io_uring_sqe*>(s);
+    entries = p.sq_entries;
+    ring = fd;
+}
+
+/**
+ * @brief Деструктор: дожидается всех операций, чтобы ядро не писало в освобожденные буферы
+ */
+ 
+asyncIo::~asyncIo()
+{
+    while (active > 0) {
+        try {
+            wait();
+        } catch (const system_error&) {
+            break;
+        }
+    }
+    if (ring < 0)
+        return;
+    munmap(sqes, sqesSize);
+    if (cqMap != sqMap)
+        munmap(cqMap, cqMapSize);
+    munmap(sqMap, sqMapSize);
+    close(ring);
+}
+
+/**
+ * @brief Постановка операции
+ * @param write true — запись, false — чтение
+ * @param fd дескриптор файла
+ * @param buf буфер
+ * @param len длина
+ * @param off смещение в файле
+ * @param tag метка завершения
+ */
+ 
+void asyncIo::submit(bool write, int fd, void* buf, size_t len, off_t off, uint64_t tag)
+{
+    len = min(len, IO_MAX);
+    ++active;
+    if (ring < 0) {
+        ssize_t r = write ? pwrite(fd, buf, len, off) : pread(fd, buf, len, off);
+        done.push_back({tag, r < 0 ? -errno : r});
+        return;
+    }
+    
+    // Кольцо отправки заполнено заявками, еще не забранными ядром
+    if (*sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == entries)
+        enter(false);
+    unsigned tail = *sqTail;
+    unsigned idx = tail & *sqMask;
+    io_uring_sqe& e = sqes[idx];
+    memset(&e, 0, sizeof(e));
+    e.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    e.fd = fd;
+    e.addr = reinterpret_cast<uint64_t>(buf);
+    e.len = len;
+    e.off = off;
+    e.user_data = tag;
+    sqArray[idx] = idx;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++queued;
+}
+
+/**
+ * @brief Передача поставленных заявок ядру
+ * @param wait ждать хотя бы одно завершение
+ * @throw system_error при ошибке io_uring_enter
+ */
+ 
+void asyncIo::enter(bool wait)
+{
+    for (;;) {
+        int r = syscall(__NR_io_uring_enter, ring, queued, wait ? 1 : 0,
+                        wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (r >= 0) {
+            queued -= r;
+            return;
+        }
+        if (errno != EINTR)
+            throw system_error(errno, generic_category(), "io_uring_enter");
+    }
+}
+
+/**
+ * @brief Постановка чтения
+ * @param fd дескриптор файла
+ * @param buf буфер, живущий до завершения
+ * @param len длина
+ * @param off смещение в файле
+ * @param tag метка завершения
+ */
+ 
+void asyncIo::read(int fd, char* buf, size_t len, off_t off, uint64_t tag)
+{
+    submit(false, fd, buf, len, off, tag);
+}
+
+/**
+ * @brief Постановка записи
+ * @param fd дескриптор файла
+ * @param buf данные, живущие до завершения
+ * @param len длина
+ * @param off смещение в файле
+ * @param tag метка завершения
+ */
+ 
+void asyncIo::write(int fd, const char* buf, size_t len, off_t off, uint64_t tag)
+{
+    submit(true, fd, const_cast<char*>(buf), len, off, tag);
+}
+
+/**
+ * @brief Ожидание очередного завершения
+ * @return завершение в порядке готовности (не постановки)
+ * @throw system_error при ошибке io_uring_enter
+ */
+ 
+ioCompletion asyncIo::wait()
+{
+    if (ring < 0) {
+        ioCompletion c = done.front();
+        done.pop_front();
+        --active;
+        return c;
+    }
+    for (;;) {
+        unsigned head = *cqHead;
+        if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& e = cqes[head & *cqMask];
+            ioCompletion c {e.user_data, e.res};
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+            --active;
+            return c;
+        }
+        enter(true);
+    }
+}
+
+/**
+ * @brief Отчет одной строкой
+ * @return строка с движком, объемами, скоростью и глубиной очереди
+ */
+ 
+string pipelineStats::report() const
+{
+    char line[256];
+    snprintf(line, sizeof(line),
+             "%s: %.1f MB in, %.1f MB out, %.3f s, %.2f GB/s, queue depth %u"
+             " (max in flight %u, avg %.1f), block %zu KB",
+             uring ? "io_uring" : "pread/pwrite", bytesIn / 1e6, bytesOut / 1e6, seconds,
+             gbPerSec(), depth, maxInFlight, avgInFlight, block >> 10);
+    return line;
+}
+
+/**
+ * @brief Конструктор
+ * @param depth количество блоков, одновременно находящихся в чтении, обработке и записи
+ * @param block размер блока, байт
+ * @param useUring false — только pread/pwrite
+ */
+ 
+filePipeline::filePipeline(unsigned depth, size_t block, bool useUring):
+    depth(max(depth, 1u)), block(max<size_t>(block, 1)), useUring(useUring)
+{
+}
+
+/**
+ * @brief Состояние ячейки конвейера
+ */
+enum slotState { SLOT_FREE, SLOT_READING, SLOT_READY, SLOT_WRITING };
+
+/**
+ * @brief Ячейка конвейера: буфер чтения и результат одного блока
+ */
+struct pipelineSlot {
+    vector<char> in; ///< Прочитанные данные
+    size_t want = 0; ///< Длина блока
+    size_t got = 0; ///< Прочитано байтов
+    off_t offset = 0; ///< Смещение блока во входе
+    string out; ///< Результат обработки блока
+    size_t written = 0; ///< Записано байтов результата
+    off_t outOffset = 0; ///< Смещение результата в выходе
+    slotState state = SLOT_FREE; ///< Состояние
+};
+
+/**
+ * @brief Обработка файла
+ * @param inPath входной файл
+ * @param outPath выходной файл (создается или перезаписывается)
+ * @param fn обработчик блоков
+ * @return статистика прогона
+ * @details Блок k живет в ячейке k % depth. Чтения ставятся в свободные
+ * ячейки с опережением, обработка идет строго по порядку блоков, запись
+ * результата блока k начинается сразу после его обработки. Ячейка
+ * освобождается после записи и получает блок k + depth. Короткие чтения
+ * и записи дополняются повторной постановкой.
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+pipelineStats filePipeline::run(const string& inPath, const string& outPath, const blockFn& fn)
+{
+    auto t0 = chrono::steady_clock::now();
+    checkDistinctFiles(inPath, outPath);
+    int in = open(inPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        throw system_error(errno, generic_category(), "Cannot open " + inPath);
+    struct stat st;
+    if (fstat(in, &st) < 0) {
+        close(in);
+        throw system_error(errno, generic_category(), "Cannot stat " + inPath);
+    }
+    int out = open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        close(in);
+        throw system_error(errno, generic_category(), "Cannot create " + outPath);
+    }
+    
+    size_t size = st.st_size;
+    size_t blocks = max<size_t>(1, (size + block - 1) / block);
+    vector<pipelineSlot> slots(min<size_t>(depth, blocks));
+    pipelineStats stats;
+    stats.depth = depth;
+    stats.block = block;
+    stats.bytesIn = size;
+    size_t samples = 0;
+    double inFlightSum = 0;
+    
+    try {
+        // Очередь объявлена после ячеек и разрушается раньше них
+        asyncIo io(2 * slots.size(), useUring);
+        stats.uring = io.uring();
+        size_t nextRead = 0;
+        size_t nextProcess = 0;
+        size_t writing = 0;
+        off_t outPos = 0;
+        
+        auto startReads = [&] {
+            while (nextRead < blocks && slots[nextRead % slots.size()].state == SLOT_FREE) {
+                size_t i = nextRead % slots.size();
+                pipelineSlot& s = slots[i];
+                s.offset = nextRead * block;
+                s.want = min(block, size - s.offset);
+                s.got = 0;
+                s.in.resize(block);
+                s.state = SLOT_READING;
+                io.read(in, s.in.data(), s.want, s.offset, i);
+                ++nextRead;
+            }
+        };
+        
+        startReads();
+        while (nextProcess < blocks || writing > 0) {
+            while (nextProcess < blocks && slots[nextProcess % slots.size()].state == SLOT_READY) {
+                size_t i = nextProcess % slots.size();
+                pipelineSlot& s = slots[i];
+                s.out.clear();
+                fn(s.in.data(), s.got, ++nextProcess == blocks, s.out);
+                if (s.out.empty()) {
+                    s.state = SLOT_FREE;
+                    continue;
+                }
+                s.state = SLOT_WRITING;
+                s.written = 0;
+                s.outOffset = outPos;
+                outPos += s.out.size();
+                ++writing;
+                io.write(out, s.out.data(), s.out.size(), s.outOffset, i);
+            }
+            startReads();
+            if (nextProcess == blocks && writing == 0)
+                break;
+            
+            stats.maxInFlight = max(stats.maxInFlight, io.inFlight());
+            inFlightSum += io.inFlight();
+            ++samples;
+            ioCompletion c = io.wait();
+            pipelineSlot& s = slots[c.tag];
+            if (c.result < 0) {
+                throw system_error(-c.result, generic_category(),
+                                   s.state == SLOT_READING ? "read " + inPath : "write " + outPath);
+            }
+            if (s.state == SLOT_READING) {
+                s.got += c.result;
+                if (c.result == 0 || s.got == s.want) {
+                    s.state = SLOT_READY; // Файл мог укоротиться во время чтения
+                } else {
+                    io.read(in, s.in.data() + s.got, s.want - s.got, s.offset + s.got, c.tag);
+                }
+            } else {
+                s.written += c.result;
+                if (s.written < s.out.size()) {
+                    io.write(out, s.out.data() + s.written, s.out.size() - s.written,
+                             s.outOffset + s.written, c.tag);
+                } else {
+                    s.state = SLOT_FREE;
+                    --writing;
+                }
+            }
+        }
+        stats.bytesOut = outPos;
+    } catch (...) {
+        close(in);
+        close(out);
+        unlink(outPath.c_str());
+        throw;
+    }
+    close(in);
+    if (close(out) < 0)
+        throw system_error(errno, generic_category(), "Cannot close " + outPath);
+    stats.avgInFlight = samples ? inFlightSum / samples : 0;
+    chrono::duration<double> spent = chrono::steady_clock::now() - t0;
+    stats.seconds = spent.count();
+    return stats;
+}
@@ -0,0 +1,202 @@
+/**
+ * @file asyncIo.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Асинхронный ввод-вывод файлов на io_uring и конвейер блочной обработки
+ * @details asyncIo ставит чтения и записи в очередь io_uring через системные
+ * вызовы напрямую (без liburing). Если io_uring недоступен (старое ядро,
+ * запрет seccomp), операции выполняются сразу через pread/pwrite, интерфейс
+ * при этом не меняется. filePipeline держит несколько чтений в полете, пока
+ * предыдущие блоки обрабатываются шифром, так что вычисления идут
+ * одновременно с работой диска.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+using namespace std;
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * @brief Завершенная операция ввода-вывода
+ */
+struct ioCompletion {
+    uint64_t tag; ///< Метка, переданная при постановке операции
+    ssize_t result; ///< Количество байтов или -errno
+};
+
+/**
+ * @brief Очередь асинхронных операций чтения и записи
+ */
+class asyncIo
+{
+private:
+    int ring = -1; ///< Дескриптор io_uring, -1 — синхронный режим
+    unsigned entries = 0; ///< Размер очереди отправки
+    unsigned queued = 0; ///< Поставлено в очередь, но еще не передано ядру
+    unsigned active = 0; ///< Операции без полученного завершения
+    void* sqMap = nullptr; ///< Отображение кольца отправки
+    size_t sqMapSize = 0; ///< Размер отображения кольца отправки
+    void* cqMap = nullptr; ///< Отображение кольца завершений
+    size_t cqMapSize = 0; ///< Размер отображения кольца завершений
+    io_uring_sqe* sqes = nullptr; ///< Массив заявок
+    size_t sqesSize = 0; ///< Размер отображения массива заявок
+    unsigned* sqHead = nullptr; ///< Голова кольца отправки (двигает ядро)
+    unsigned* sqTail = nullptr; ///< Хвост кольца отправки
+    unsigned* sqMask = nullptr; ///< Маска индексов кольца отправки
+    unsigned* sqArray = nullptr; ///< Индексы заявок кольца отправки
+    unsigned* cqHead = nullptr; ///< Голова кольца завершений
+    unsigned* cqTail = nullptr; ///< Хвост кольца завершений (двигает ядро)
+    unsigned* cqMask = nullptr; ///< Маска индексов кольца завершений
+    io_uring_cqe* cqes = nullptr; ///< Массив завершений
+    deque<ioCompletion> done; ///< Завершения синхронного режима
+    
+    /**
+     * @brief Постановка операции
+     * @param write true — запись, false — чтение
+     * @param fd дескриптор файла
+     * @param buf буфер
+     * @param len длина
+     * @param off смещение в файле
+     * @param tag метка завершения
+     */
+    void submit(bool write, int fd, void* buf, size_t len, off_t off, uint64_t tag);
+    
+    /**
+     * @brief Передача поставленных заявок ядру
+     * @param wait ждать хотя бы одно завершение
+     * @throw system_error при ошибке io_uring_enter
+     */
+    void enter(bool wait);
+    
+public:
+    /**
+     * @brief Конструктор очереди
+     * @param depth наибольшее количество одновременных операций
+     * @param useUring false — сразу синхронный режим
+     */
+    explicit asyncIo(unsigned depth, bool useUring = true);
+    
+    /**
+     * @brief Деструктор: дожидается всех операций, чтобы ядро не писало в освобожденные буферы
+     */
+    ~asyncIo();
+    
+    asyncIo(const asyncIo&) = delete;
+    asyncIo& operator=(const asyncIo&) = delete;
+    
+    /**
+     * @brief Используется ли io_uring
+     * @return false в синхронном режиме pread/pwrite
+     */
+    bool uring() const { return ring >= 0; }
+    
+    /**
+     * @brief Количество операций без полученного завершения
+     * @return число операций
+     */
+    unsigned inFlight() const { return active; }
+    
+    /**
+     * @brief Постановка чтения
+     * @param fd дескриптор файла
+     * @param buf буфер, живущий до завершения
+     * @param len длина (не больше 1 ГБ)
+     * @param off смещение в файле
+     * @param tag метка завершения
+     */
+    void read(int fd, char* buf, size_t len, off_t off, uint64_t tag);
+    
+    /**
+     * @brief Постановка записи
+     * @param fd дескриптор файла
+     * @param buf данные, живущие до завершения
+     * @param len длина (не больше 1 ГБ)
+     * @param off смещение в файле
+     * @param tag метка завершения
+     */
+    void write(int fd, const char* buf, size_t len, off_t off, uint64_t tag);
+    
+    /**
+     * @brief Ожидание очередного завершения
+     * @return завершение в порядке готовности (не постановки)
+     * @throw system_error при ошибке io_uring_enter
+     */
+    ioCompletion wait();
+};
+
+/**
+ * @brief Статистика прогона конвейера
+ */
+struct pipelineStats {
+    bool uring = false; ///< Использовался io_uring
+    unsigned depth = 0; ///< Заданная глубина очереди
+    size_t block = 0; ///< Размер блока чтения, байт
+    size_t bytesIn = 0; ///< Прочитано, байт
+    size_t bytesOut = 0; ///< Записано, байт
+    double seconds = 0; ///< Время прогона, с
+    unsigned maxInFlight = 0; ///< Наибольшее число операций в полете
+    double avgInFlight = 0; ///< Среднее число операций в полете при ожидании
+    
+    /**
+     * @brief Достигнутая пропускная способность (чтение и запись)
+     * @return ГБ/с
+     */
+    double gbPerSec() const { return seconds > 0 ? (bytesIn + bytesOut) / seconds / 1e9 : 0; }
+    
+    /**
+     * @brief Отчет одной строкой
+     * @return строка с движком, объемами, скоростью и глубиной очереди
+     */
+    string report() const;
+};
+
+/**
+ * @brief Конвейер чтение — обработка — запись блоками файла
+ */
+class filePipeline
+{
+public:
+    /// Обработка блока: данные, длина, последний ли блок, результат (дописывается)
+    using blockFn = function<void(const char* data, size_t len, bool last, string& out)>;
+    
+    /// Глубина очереди по умолчанию
+    static const unsigned DEPTH = 8;
+    
+    /// Размер блока по умолчанию, байт
+    static const size_t BLOCK = size_t(1) << 20;
+    
+private:
+    unsigned depth; ///< Количество блоков в полете
+    size_t block; ///< Размер блока, байт
+    bool useUring; ///< Разрешен ли io_uring
+    
+public:
+    /**
+     * @brief Конструктор
+     * @param depth количество блоков, одновременно находящихся в чтении, обработке и записи
+     * @param block размер блока, байт
+     * @param useUring false — только pread/pwrite
+     */
+    filePipeline(unsigned depth = DEPTH, size_t block = BLOCK, bool useUring = true);
+    
+    /**
+     * @brief Обработка файла
+     * @param inPath входной файл
+     * @param outPath выходной файл (создается или перезаписывается)
+     * @param fn обработчик блоков; вызывается по порядку блоков, последний
+     * вызов имеет last = true (для пустого файла — единственный вызов с len = 0)
+     * @return статистика прогона
+     * @details Исключение обработчика прерывает прогон, выходной файл удаляется.
+     * Выход, совпадающий со входом, отвергается до открытия файлов
+     * @throw system_error при ошибке ввода-вывода
+     */
+    pipelineStats run(const string& inPath, const string& outPath, const blockFn& fn);
+};
@@ -0,0 +1,241 @@
+/**
+ * @file benchHarness.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация каркаса замеров производительности
+ */
+
+#include "benchHarness.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+using namespace std;
+
+/**
+ * @brief Конструктор набора
+ * @param name имя набора
+ * @param argc количество аргументов командной строки
+ * @param argv аргументы командной строки
+ */
+ 
+benchSuite::benchSuite(const string& name, int argc, char** argv):
+    suiteName(name)
+{
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--max-size") {
+            maxSize = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--min-time") {
+            minTime = strtod(value.c_str(), nullptr);
+        } else if (arg == "--filter") {
+            filter = value;
+        } else if (arg == "--json") {
+            jsonPath = value;
+        } else if (arg == "--compare") {
+            baselinePath = value;
+        } else if (arg == "--threshold") {
+            threshold = strtod(value.c_str(), nullptr);
+        } else {
+            cerr << "Usage: " << argv[0] << " [--max-size BYTES] [--min-time SEC]"
+                 << " [--filter TEXT] [--json FILE] [--compare BASELINE.json]"
+                 << " [--threshold FRACTION]" << endl
+                 << "  --max-size  largest message, default 16777216 (16 MB);"
+                 << " 1073741824 measures up to 1 GB" << endl;
+            exit(2);
+        }
+        ++i;
+    }
+}
+
+/**
+ * @brief Размеры сообщений от 16 байт до maxSize с шагом x16
+ * @return список размеров в байтах
+ * @details Последним всегда идет сам maxSize, даже если он не степень 16:
+ * --max-size 1073741824 замеряет 1 ГБ, а не останавливается на 256 МБ
+ */
+ 
+vector<size_t> benchSuite::sizes() const
+{
+    vector<size_t> list;
+    for (size_t s = 16; s <= maxSize; s *= 16) {
+        list.push_back(s);
+    }
+    if (maxSize > 0 && (list.empty() || list.back() != maxSize))
+        list.push_back(maxSize);
+    return list;
+}
+
+/**
+ * @brief Выполнение замера
+ * @param name имя замера
+ * @param bytes объем данных за одно выполнение
+ * @param fn измеряемое действие
+ * @details Действие повторяется до набора minTime, время делится на число
+ * повторов; из трех подходов берется лучший
+ */
+ 
+void benchSuite::run(const string& name, size_t bytes, const function<void()>& fn)
+{
+    if (!filter.empty() && name.find(filter) == string::npos)
+        return;
+    
+    fn();
+    double best = 1e300;
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        size_t repeats = 0;
+        auto t0 = chrono::steady_clock::now();
+        chrono::duration<double> spent {};
+        do {
+            fn();
+            ++repeats;
+            spent = chrono::steady_clock::now() - t0;
+        } while (spent.count() < minTime);
+        best = min(best, spent.count() / repeats);
+    }
+    
+    benchResult r;
+    r.name = name;
+    r.bytes = bytes;
+    r.seconds = best;
+    r.mbPerSec = bytes / best / 1e6;
+    results.push_back(r);
+    fprintf(stderr, "%-48s %12zu B %12.1f MB/s\n", name.c_str(), bytes, r.mbPerSec);
+}
+
+/**
+ * @brief Запись результатов в JSON
+ * @param out поток вывода
+ * @param name имя набора
+ * @param list результаты
+ */
+ 
+void benchSuite::writeJson(ostream& out, const string& name, const vector<benchResult>& list)
+{
+    out << "{\"suite\": \"" << name << "\", \"results\": [\n";
+    for (size_t i = 0; i < list.size(); ++i) {
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "  {\"name\": \"%s\", \"bytes\": %zu, \"seconds\": %.9g, \"mb_per_s\": %.6g}%s\n",
+                 list[i].name.c_str(), list[i].bytes, list[i].seconds, list[i].mbPerSec,
+                 i + 1 < list.size() ? "," : "");
+        out << line;
+    }
+    out << "]}\n";
+}
+
+/**
+ * @brief Значение поля из строки JSON, записанной writeJson
+ * @param line строка с одним замером
+ * @param key имя поля
+ * @return текст значения без кавычек, "" если поля нет
+ */
+ 
+static string jsonField(const string& line, const string& key)
+{
+    size_t p = line.find("\"" + key + "\":");
+    if (p == string::npos)
+        return "";
+    p = line.find_first_not_of(' ', p + key.size() + 3);
+    if (line[p] == '"') {
+        return line.substr(p + 1, line.find('"', p + 1) - p - 1);
+    }
+    return line.substr(p, line.find_first_of(",}", p) - p);
+}
+
+/**
+ * @brief Чтение результатов из JSON, записанного writeJson
+ * @param in поток ввода
+ * @return результаты
+ */
+ 
+vector<benchResult> benchSuite::readJson(istream& in)
+{
+    vector<benchResult> list;
+    string line;
+    while (getline(in, line)) {
+        string name = jsonField(line, "name");
+        if (name.empty())
+            continue;
+        benchResult r;
+        r.name = name;
+        r.bytes = strtoull(jsonField(line, "bytes").c_str(), nullptr, 10);
+        r.seconds = strtod(jsonField(line, "seconds").c_str(), nullptr);
+        r.mbPerSec = strtod(jsonField(line, "mb_per_s").c_str(), nullptr);
+        list.push_back(r);
+    }
+    return list;
+}
+
+/**
+ * @brief Вывод результатов и сравнение с базой
+ * @return 0 если регрессий нет, 1 если есть
+ */
+ 
+int benchSuite::finish()
+{
+    if (jsonPath.empty()) {
+        writeJson(cout, suiteName, results);
+    } else {
+        ofstream out(jsonPath);
+        writeJson(out, suiteName, results);
+    }
+    if (baselinePath.empty())
+        return 0;
+    
+    ifstream in(baselinePath);
+    if (!in) {
+        cerr << "Cannot read baseline " << baselinePath << endl;
+        return 2;
+    }
+    map<string, benchResult> base;
+    for (auto& r : readJson(in)) {
+        base[r.name] = r;
+    }
+    
+    int regressions = 0;
+    for (auto& r : results) {
+        auto it = base.find(r.name);
+        if (it == base.end() || it->second.mbPerSec <= 0)
+            continue;
+        double change = r.mbPerSec / it->second.mbPerSec - 1;
+        if (change < -threshold) {
+            ++regressions;
+            fprintf(stderr, "REGRESSION %-40s %10.1f -> %10.1f MB/s (%+.1f%%)\n",
+                    r.name.c_str(), it->second.mbPerSec, r.mbPerSec, change * 100);
+        }
+    }
+    fprintf(stderr, "%d regression(s) against %s (threshold %.0f%%)\n",
+            regressions, baselinePath.c_str(), threshold * 100);
+    return regressions ? 1 : 0;
+}
+
+/**
+ * @brief Тестовый русский текст заданного размера в UTF-8
+ * @param bytes размер в байтах
+ * @return текст из букв обоих регистров, пробелов, цифр и знаков препинания
+ */
+ 
+string benchText(size_t bytes)
+{
+    static const string sample =
+        "Съешь же ещё этих мягких французских булок, да выпей чаю. "
+        "ШИРОКАЯ ЭЛЕКТРИФИКАЦИЯ ЮЖНЫХ ГУБЕРНИЙ ДАСТ МОЩНЫЙ ТОЛЧОК ПОДЪЁМУ 2025! ";
+    string text;
+    text.reserve(bytes + sample.size());
+    while (text.size() < bytes) {
+        text += sample;
+    }
+    // Обрезка по границе символа UTF-8
+    size_t end = bytes;
+    while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+        --end;
+    }
+    text.resize(end);
+    return text;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file benchHarness.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Общий каркас замеров производительности шифров
+ * @details Каждый замер повторяется, пока не наберется заданное время, и
+ * сохраняется лучший из нескольких подходов. Результаты выводятся в JSON
+ * (по одному замеру в строке) и могут сравниваться с сохраненной базой:
+ * замер медленнее базы больше чем на порог считается регрессией.
+ */
+
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+using namespace std;
+
+/**
+ * @brief Результат одного замера
+ */
+struct benchResult {
+    string name; ///< Имя замера вида "операция/параметр=значение/size=N"
+    size_t bytes = 0; ///< Объем данных за одно выполнение, байт
+    double seconds = 0; ///< Лучшее время одного выполнения, с
+    double mbPerSec = 0; ///< Пропускная способность, МБ/с
+};
+
+/**
+ * @brief Набор замеров с разбором командной строки
+ */
+class benchSuite
+{
+private:
+    string suiteName; ///< Имя набора в JSON
+    size_t maxSize = size_t(16) << 20; ///< Наибольший размер сообщения, байт
+    double minTime = 0.1; ///< Минимальное время одного подхода, с
+    string filter; ///< Подстрока имени: замеры без нее пропускаются
+    string jsonPath; ///< Файл для JSON ("" — стандартный вывод)
+    string baselinePath; ///< Файл базы для сравнения ("" — без сравнения)
+    double threshold = 0.10; ///< Допустимое замедление относительно базы
+    vector<benchResult> results; ///< Выполненные замеры
+    
+public:
+    /**
+     * @brief Конструктор набора
+     * @param name имя набора
+     * @param argc количество аргументов командной строки
+     * @param argv аргументы: --max-size, --min-time, --filter, --json,
+     * --compare, --threshold
+     */
+    benchSuite(const string& name, int argc, char** argv);
+    
+    /**
+     * @brief Размеры сообщений от 16 байт до maxSize с шагом x16
+     * @return список размеров в байтах; последний всегда равен maxSize
+     */
+    vector<size_t> sizes() const;
+    
+    /**
+     * @brief Выполнение замера
+     * @param name имя замера
+     * @param bytes объем данных за одно выполнение
+     * @param fn измеряемое действие
+     */
+    void run(const string& name, size_t bytes, const function<void()>& fn);
+    
+    /**
+     * @brief Вывод результатов и сравнение с базой
+     * @return 0 если регрессий нет, 1 если есть
+     */
+    int finish();
+    
+    /**
+     * @brief Запись результатов в JSON
+     * @param out поток вывода
+     * @param name имя набора
+     * @param list результаты
+     */
+    static void writeJson(ostream& out, const string& name, const vector<benchResult>& list);
+    
+    /**
+     * @brief Чтение результатов из JSON, записанного writeJson
+     * @param in поток ввода
+     * @return результаты
+     */
+    static vector<benchResult> readJson(istream& in);
+};
+
+/**
+ * @brief Тестовый русский текст заданного размера в UTF-8
+ * @param bytes размер в байтах
+ * @return текст из букв обоих регистров, пробелов, цифр и знаков препинания
+ */
+string benchText(size_t bytes);
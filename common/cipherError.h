@@ -0,0 +1,35 @@
+/**
+ * @file cipherError.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Исключение для ошибок шифрования, общее для обоих шифров
+ * @details Вынесено из modAlphaCipher.h и table.h, чтобы оба шифра можно
+ * было подключить в одну программу (сервер шифрования).
+ */
+
+#pragma once
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+/**
+ * @brief Класс-исключение для ошибок шифрования
+ * @details Наследуется от std::invalid_argument
+ */
+class cipher_error: public invalid_argument {
+public:
+    /**
+     * @brief Конструктор с параметром string
+     * @param what_arg сообщение об ошибке
+     */
+    explicit cipher_error (const string& what_arg):
+        invalid_argument(what_arg) {}
+    
+    /**
+     * @brief Конструктор с параметром const char*
+     * @param what_arg сообщение об ошибке
+     */
+    explicit cipher_error (const char* what_arg):
+        invalid_argument(what_arg) {}
+};
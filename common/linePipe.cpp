@@ -0,0 +1,210 @@
+/**
+ * @file linePipe.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация пакетной обработки потока строк
+ */
+
+#include "linePipe.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <system_error>
+#include <vector>
+#include <unistd.h>
+using namespace std;
+
+/// Наибольшее количество потоков (-j)
+static const unsigned MAX_THREADS = 1024;
+/// Наибольшая глубина очереди io_uring (-q)
+static const unsigned MAX_QUEUE_DEPTH = 4096;
+
+/**
+ * @brief Строгий разбор неотрицательного целого аргумента
+ * @param s аргумент
+ * @param limit наибольшее допустимое значение
+ * @param v результат
+ * @return false если аргумент не десятичное число целиком или больше limit
+ */
+ 
+static bool parseCount(const char* s, unsigned limit, unsigned& v)
+{
+    const char* end = s + strlen(s);
+    auto [stop, ec] = from_chars(s, end, v);
+    return s != end && ec == errc() && stop == end && v <= limit;
+}
+
+/**
+ * @brief Разбор аргументов неинтерактивного режима
+ * @param argc количество аргументов
+ * @param argv аргументы: -k КЛЮЧ (-e|-d) [-j N] [-i ВХОД -o ВЫХОД [-q ГЛУБИНА | -p | -s]]
+ * @param args результат разбора
+ * @return true если аргументы корректны
+ * @details Числа -j и -q разбираются целиком: знак, лишние символы и
+ * значения больше MAX_THREADS и MAX_QUEUE_DEPTH отвергаются
+ */
+ 
+bool parsePipeArgs(int argc, char** argv, pipeArgs& args)
+{
+    bool haveKey = false, haveMode = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-e" || arg == "-d") {
+            args.decrypt = arg == "-d";
+            haveMode = true;
+        } else if (arg == "-k" && hasValue) {
+            args.key = argv[++i];
+            haveKey = true;
+        } else if (arg == "-j" && hasValue) {
+            if (!parseCount(argv[++i], MAX_THREADS, args.threads))
+                return false;
+        } else if (arg == "-i" && hasValue) {
+            args.inPath = argv[++i];
+        } else if (arg == "-o" && hasValue) {
+            args.outPath = argv[++i];
+        } else if (arg == "-q" && hasValue) {
+            if (!parseCount(argv[++i], MAX_QUEUE_DEPTH, args.queueDepth))
+                return false;
+        } else if (arg == "-p") {
+            args.packed = true;
+        } else if (arg == "-s") {
+            args.staged = true;
+        } else {
+            return false;
+        }
+    }
+    return haveKey && haveMode && args.inPath.empty() == args.outPath.empty()
+           && (args.queueDepth == 0 || !args.inPath.empty())
+           && (!args.packed || (!args.inPath.empty() && args.queueDepth == 0))
+           && (!args.staged || (!args.inPath.empty() && args.queueDepth == 0 && !args.packed));
+}
+
+/**
+ * @brief Конструктор
+ * @param fn обработчик записи
+ * @param threads количество потоков (1 — без пула, 0 — по числу ядер)
+ * @param chunk размер блока чтения и записи
+ */
+ 
+linePipe::linePipe(recordFn fn, unsigned threads, size_t chunk):
+    fn(std::move(fn)), threads(threads), chunk(chunk)
+{
+}
+
+/**
+ * @brief Запись всего буфера в дескриптор
+ * @param fd дескриптор
+ * @param data буфер
+ * @throw system_error при ошибке записи
+ */
+ 
+static void writeAll(int fd, const string& data)
+{
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t r = ::write(fd, data.data() + done, data.size() - done);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            throw system_error(errno, generic_category(), "write");
+        }
+        done += r;
+    }
+}
+
+/**
+ * @brief Обработка всех строк входа
+ * @param in дескриптор входа
+ * @param out дескриптор выхода
+ * @return количество записей с ошибкой
+ * @details Полные строки обрабатываются после каждого чтения, вернувшего
+ * данные, поэтому из канала ответ на строку приходит сразу, не дожидаясь
+ * заполнения блока. Незавершенный хвост переносится в следующее чтение.
+ * Результаты и ошибки пишутся по порядку после обработки прочитанных строк.
+ * Завершающий '\r' строк CRLF отбрасывается.
+ */
+ 
+size_t linePipe::run(int in, int out)
+{
+    unique_ptr<threadPool> pool;
+    if (threads != 1)
+        pool = make_unique<threadPool>(threads);
+    
+    string buffer, output;
+    vector<string> records, results, errors;
+    size_t lineNo = 0, failed = 0;
+    bool eof = false;
+    
+    while (!eof) {
+        // Одно чтение до chunk байт сверх перенесенного хвоста
+        size_t start = buffer.size();
+        buffer.resize(start + chunk);
+        ssize_t r;
+        do {
+            r = ::read(in, buffer.data() + start, chunk);
+        } while (r < 0 && errno == EINTR);
+        if (r < 0)
+            throw system_error(errno, generic_category(), "read");
+        eof = r == 0;
+        buffer.resize(start + r);
+        
+        // Разбиение на записи
+        records.clear();
+        size_t pos = 0;
+        for (size_t nl; (nl = buffer.find('\n', pos)) != string::npos; pos = nl + 1) {
+            records.emplace_back(buffer, pos, nl - pos);
+        }
+        if (eof && pos < buffer.size()) {
+            records.emplace_back(buffer, pos);
+            pos = buffer.size();
+        }
+        // Конец строки CRLF: '\r' не входит в запись
+        for (string& rec : records) {
+            if (!rec.empty() && rec.back() == '\r')
+                rec.pop_back();
+        }
+        buffer.erase(0, pos);
+        
+        results.assign(records.size(), string());
+        errors.assign(records.size(), string());
+        auto process = [&](size_t i) {
+            try {
+                results[i] = fn(records[i]);
+            } catch (const exception& e) {
+                errors[i] = e.what();
+            }
+        };
+        if (pool && records.size() > 1) {
+            // Записи делятся на участки, чтобы не ставить задачу на каждую строку
+            size_t parts = min<size_t>(records.size(), pool->size() * 4);
+            pool->parallelFor(parts, [&](size_t part) {
+                size_t from = records.size() * part / parts;
+                size_t to = records.size() * (part + 1) / parts;
+                for (size_t i = from; i < to; ++i)
+                    process(i);
+            });
+        } else {
+            for (size_t i = 0; i < records.size(); ++i)
+                process(i);
+        }
+        
+        for (size_t i = 0; i < records.size(); ++i) {
+            ++lineNo;
+            if (!errors[i].empty()) {
+                ++failed;
+                cerr << "Строка " << lineNo << ": " << errors[i] << '\n';
+            }
+            output += results[i];
+            output += '\n';
+        }
+        writeAll(out, output);
+        output.clear();
+    }
+    return failed;
+}
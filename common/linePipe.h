@@ -0,0 +1,77 @@
+/**
+ * @file linePipe.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Пакетная обработка потока строк для неинтерактивного режима программ
+ * @details Каждая строка входа — отдельная запись. Вход читается и выход
+ * пишется крупными блоками без сброса после каждой строки; записи блока
+ * могут обрабатываться пулом потоков, порядок вывода совпадает с порядком
+ * ввода. Строка с ошибкой выводится пустой, ошибка сообщается в stderr
+ * с номером строки.
+ */
+
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+using namespace std;
+
+/**
+ * @brief Параметры неинтерактивного режима из командной строки
+ */
+struct pipeArgs {
+    string key; ///< Ключ (-k)
+    bool decrypt = false; ///< Направление: -e шифрование, -d расшифрование
+    unsigned threads = 1; ///< Количество потоков (-j, 0 — по числу ядер)
+    string inPath; ///< Входной файл (-i); пусто — поток строк stdin
+    string outPath; ///< Выходной файл (-o), задается вместе с -i
+    unsigned queueDepth = 0; ///< Глубина очереди io_uring (-q); 0 — отображение файла в память
+    bool packed = false; ///< Шифртекст в упакованном формате packedText (-p), только с -i/-o
+    bool staged = false; ///< Конвейер стадий stagedPipeline с отчетом по стадиям (-s), только с -i/-o
+};
+
+/**
+ * @brief Разбор аргументов неинтерактивного режима
+ * @param argc количество аргументов
+ * @param argv аргументы: -k КЛЮЧ (-e|-d) [-j N] [-i ВХОД -o ВЫХОД [-q ГЛУБИНА | -p | -s]]
+ * @param args результат разбора
+ * @return true если аргументы корректны
+ */
+bool parsePipeArgs(int argc, char** argv, pipeArgs& args);
+
+/**
+ * @brief Построчная обработка потока
+ */
+class linePipe
+{
+public:
+    /// Обработка одной записи; исключение означает ошибку в записи
+    using recordFn = function<string(const string&)>;
+    
+    /// Размер блока чтения и записи по умолчанию, байт
+    static const size_t CHUNK = size_t(4) << 20;
+    
+private:
+    recordFn fn; ///< Обработчик записи (должен допускать параллельный вызов)
+    unsigned threads; ///< Количество потоков
+    size_t chunk; ///< Размер блока, байт
+    
+public:
+    /**
+     * @brief Конструктор
+     * @param fn обработчик записи
+     * @param threads количество потоков (1 — без пула, 0 — по числу ядер)
+     * @param chunk размер блока чтения и записи
+     */
+    linePipe(recordFn fn, unsigned threads = 1, size_t chunk = CHUNK);
+    
+    /**
+     * @brief Обработка всех строк входа
+     * @param in дескриптор входа
+     * @param out дескриптор выхода
+     * @return количество записей с ошибкой
+     * @throw system_error при ошибке чтения или записи
+     */
+    size_t run(int in = 0, int out = 1);
+};
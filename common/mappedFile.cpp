@@ -0,0 +1,220 @@
+/**
+ * @file mappedFile.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация отображения файла в память
+ */
+
+#include "mappedFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @brief Исключение с кодом errno
+ * @param what описание операции
+ * @param path путь к файлу
+ */
+ 
+[[noreturn]] static void fail(const char* what, const string& path)
+{
+    throw system_error(errno, generic_category(), string(what) + " " + path);
+}
+
+/**
+ * @brief Размер страницы памяти
+ * @return размер в байтах
+ */
+ 
+static size_t pageSize()
+{
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    return page;
+}
+
+/**
+ * @brief Проверка, что выходной файл не совпадает с входным
+ * @param inPath входной файл
+ * @param outPath выходной файл
+ * @details Если какой-либо из файлов не существует, проверять нечего:
+ * об отсутствии входа сообщит его открытие
+ * @throw system_error (EINVAL) если оба пути указывают на один файл
+ */
+ 
+void checkDistinctFiles(const string& inPath, const string& outPath)
+{
+    struct stat in, out;
+    if (stat(inPath.c_str(), &in) < 0 || stat(outPath.c_str(), &out) < 0)
+        return;
+    if (in.st_dev == out.st_dev && in.st_ino == out.st_ino)
+        throw system_error(EINVAL, generic_category(), "Output is the input file " + outPath);
+}
+
+/**
+ * @brief Открытие существующего файла только для чтения
+ * @param path путь к файлу
+ * @details Деструктор недостроенного объекта не вызывается, поэтому при
+ * ошибке после открытия дескриптор закрывается здесь
+ * @throw system_error если файл не удалось открыть или отобразить
+ */
+ 
+mappedFile::mappedFile(const string& path)
+{
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        fail("Cannot open", path);
+    try {
+        struct stat st;
+        if (fstat(fd, &st) < 0)
+            fail("Cannot stat", path);
+        length = st.st_size;
+        map(false, path);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+/**
+ * @brief Создание (или усечение) файла заданного размера для записи
+ * @param path путь к файлу
+ * @param size размер файла в байтах
+ * @details При ошибке после открытия дескриптор закрывается, а созданный
+ * или усеченный файл удаляется
+ * @throw system_error если файл не удалось создать или отобразить
+ */
+ 
+mappedFile::mappedFile(const string& path, size_t size)
+{
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        fail("Cannot create", path);
+    try {
+        if (ftruncate(fd, size) < 0)
+            fail("Cannot resize", path);
+        length = size;
+        map(true, path);
+    } catch (...) {
+        close(fd);
+        unlink(path.c_str());
+        throw;
+    }
+}
+
+/**
+ * @brief Создание безымянного временного файла для записи
+ * @param dir каталог временного файла
+ * @param size размер файла в байтах
+ * @return отображение файла, удаленного из каталога сразу после создания
+ * @throw system_error если файл не удалось создать или отобразить
+ */
+ 
+mappedFile mappedFile::temporary(const string& dir, size_t size)
+{
+    string pattern = (dir.empty() ? string(".") : dir) + "/.cipher.XXXXXX";
+    vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    mappedFile f;
+    f.fd = mkostemp(name.data(), O_CLOEXEC);
+    if (f.fd < 0)
+        fail("Cannot create temporary file in", pattern);
+    unlink(name.data());
+    if (ftruncate(f.fd, size) < 0)
+        fail("Cannot resize", pattern);
+    f.length = size;
+    f.map(true, pattern);
+    return f;
+}
+
+/**
+ * @brief Перемещающий конструктор
+ * @param other отображение, теряющее владение файлом
+ */
+ 
+mappedFile::mappedFile(mappedFile&& other) noexcept:
+    fd(other.fd), base(other.base), length(other.length)
+{
+    other.fd = -1;
+    other.base = nullptr;
+    other.length = 0;
+}
+
+/**
+ * @brief Деструктор: снимает отображение и закрывает файл
+ */
+ 
+mappedFile::~mappedFile()
+{
+    if (base)
+        munmap(base, length);
+    if (fd >= 0)
+        close(fd);
+}
+
+/**
+ * @brief Отображение открытого файла
+ * @param writable true — для записи (MAP_SHARED, PROT_WRITE)
+ * @param path путь для сообщения об ошибке
+ */
+ 
+void mappedFile::map(bool writable, const string& path)
+{
+    if (length == 0)
+        return;
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* p = mmap(nullptr, length, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        fail("Cannot map", path);
+    base = static_cast<char*>(p);
+}
+
+/**
+ * @brief Подсказка ядру о характере доступа к диапазону (madvise)
+ * @param offset начало диапазона (выравнивается вниз до страницы)
+ * @param len длина диапазона
+ * @param advice MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED и т.п.
+ */
+ 
+void mappedFile::advise(size_t offset, size_t len, int advice) const
+{
+    if (!base || offset >= length)
+        return;
+    size_t aligned = offset / pageSize() * pageSize();
+    len = min(len + (offset - aligned), length - aligned);
+    madvise(base + aligned, len, advice);
+}
+
+/**
+ * @brief Освобождение страниц диапазона из памяти процесса (MADV_DONTNEED)
+ * @param offset начало диапазона
+ * @param len длина диапазона
+ */
+ 
+void mappedFile::release(size_t offset, size_t len) const
+{
+    advise(offset, len, MADV_DONTNEED);
+}
+
+/**
+ * @brief Изменение размера файла, отображенного для записи
+ * @param size новый размер в байтах
+ * @throw system_error при ошибке
+ */
+ 
+void mappedFile::resize(size_t size)
+{
+    if (base)
+        munmap(base, length);
+    base = nullptr;
+    if (ftruncate(fd, size) < 0)
+        fail("Cannot resize", "mapped file");
+    length = size;
+    map(true, "mapped file");
+}
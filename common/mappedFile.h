@@ -0,0 +1,116 @@
+/**
+ * @file mappedFile.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Отображение файла в память для обработки больших текстов
+ * @details Ошибки операционной системы сообщаются исключением std::system_error.
+ */
+
+#pragma once
+#include <cstddef>
+#include <string>
+using namespace std;
+
+/**
+ * @brief Файл, отображенный в память (mmap)
+ */
+class mappedFile
+{
+private:
+    int fd = -1; ///< Дескриптор файла
+    char* base = nullptr; ///< Начало отображения
+    size_t length = 0; ///< Размер отображения
+    
+    /**
+     * @brief Пустое отображение для temporary()
+     */
+    mappedFile() = default;
+    
+    /**
+     * @brief Отображение открытого файла
+     * @param writable true — для записи (MAP_SHARED, PROT_WRITE)
+     * @param path путь для сообщения об ошибке
+     */
+    void map(bool writable, const string& path);
+    
+public:
+    /**
+     * @brief Открытие существующего файла только для чтения
+     * @param path путь к файлу
+     * @throw system_error если файл не удалось открыть или отобразить
+     */
+    explicit mappedFile(const string& path);
+    
+    /**
+     * @brief Создание (или усечение) файла заданного размера для записи
+     * @param path путь к файлу
+     * @param size размер файла в байтах
+     * @throw system_error если файл не удалось создать или отобразить
+     */
+    mappedFile(const string& path, size_t size);
+    
+    /**
+     * @brief Создание безымянного временного файла для записи
+     * @param dir каталог временного файла
+     * @param size размер файла в байтах
+     * @return отображение файла, удаленного из каталога сразу после создания
+     * @throw system_error если файл не удалось создать или отобразить
+     */
+    static mappedFile temporary(const string& dir, size_t size);
+    
+    /**
+     * @brief Деструктор: снимает отображение и закрывает файл
+     */
+    ~mappedFile();
+    
+    mappedFile(mappedFile&& other) noexcept;
+    mappedFile(const mappedFile&) = delete;
+    mappedFile& operator=(const mappedFile&) = delete;
+    
+    /**
+     * @brief Начало отображения
+     * @return указатель на первый байт файла
+     */
+    char* data() const { return base; }
+    
+    /**
+     * @brief Размер файла
+     * @return размер в байтах
+     */
+    size_t size() const { return length; }
+    
+    /**
+     * @brief Подсказка ядру о характере доступа к диапазону (madvise)
+     * @param offset начало диапазона (выравнивается вниз до страницы)
+     * @param len длина диапазона
+     * @param advice MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED и т.п.
+     */
+    void advise(size_t offset, size_t len, int advice) const;
+    
+    /**
+     * @brief Освобождение страниц диапазона из памяти процесса (MADV_DONTNEED)
+     * @details Измененные страницы остаются в страничном кэше и будут записаны в файл
+     * @param offset начало диапазона
+     * @param len длина диапазона
+     */
+    void release(size_t offset, size_t len) const;
+    
+    /**
+     * @brief Изменение размера файла, отображенного для записи
+     * @param size новый размер в байтах
+     * @throw system_error при ошибке
+     */
+    void resize(size_t size);
+};
+
+/**
+ * @brief Проверка, что выходной файл не совпадает с входным
+ * @param inPath входной файл
+ * @param outPath выходной файл (может еще не существовать)
+ * @details Выход открывается с O_TRUNC раньше, чем прочитан вход, поэтому
+ * запись в тот же файл, в том числе под другим путем или через жесткую
+ * ссылку, уничтожила бы вход. Файлы сравниваются по st_dev и st_ino.
+ * @throw system_error (EINVAL) если оба пути указывают на один файл
+ */
+void checkDistinctFiles(const string& inPath, const string& outPath);
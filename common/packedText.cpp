@@ -0,0 +1,404 @@
+/**
+ * @file packedText.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация упакованного формата и ядер упаковки 6 бит на букву
+ */
+
+#include "packedText.h"
+#include "ruAlphabet.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PACKED_X86 1
+#endif
+using namespace std;
+
+/// Сигнатура контейнера
+static const char PACKED_MAGIC[4] = {'R', 'U', '6', 'P'};
+
+/**
+ * @brief Запись целого little-endian
+ * @param p место записи
+ * @param v значение
+ * @param bytes количество байтов
+ */
+ 
+static void putLe(uint8_t* p, uint64_t v, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i)
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+/**
+ * @brief Чтение целого little-endian
+ * @param p начало
+ * @param bytes количество байтов
+ * @return значение
+ */
+ 
+static uint64_t getLe(const uint8_t* p, size_t bytes)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        v |= uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+/**
+ * @brief Хеш FNV-1a 64 для отпечатка ключа
+ * @param data данные
+ * @param len длина в байтах
+ * @return 64-битный хеш
+ */
+ 
+uint64_t fnv1a64(const void* data, size_t len)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+/**
+ * @brief Скалярная эталонная упаковка
+ * @param letters номера букв
+ * @param n количество букв
+ * @param out packedBytes(n) байтов результата
+ */
+ 
+static void packScalar(const uint8_t* letters, size_t n, uint8_t* out)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4, out += 3) {
+        uint32_t v = letters[i] | letters[i + 1] << 6 | letters[i + 2] << 12 | letters[i + 3] << 18;
+        putLe(out, v, 3);
+    }
+    uint32_t v = 0;
+    for (size_t j = 0; i + j < n; ++j)
+        v |= uint32_t(letters[i + j]) << (6 * j);
+    putLe(out, v, packedBytes(n - i));
+}
+
+/**
+ * @brief Скалярная эталонная распаковка
+ * @param in упакованные буквы
+ * @param n количество букв
+ * @param out номера букв
+ * @return false если встретилось значение больше 32
+ */
+ 
+static bool unpackScalar(const uint8_t* in, size_t n, uint8_t* out)
+{
+    uint8_t bad = 0;
+    for (size_t i = 0; i < n; i += 4, in += 3) {
+        size_t k = min<size_t>(4, n - i);
+        uint32_t v = getLe(in, packedBytes(k));
+        for (size_t j = 0; j < k; ++j) {
+            uint8_t x = (v >> (6 * j)) & 0x3F;
+            bad |= x >= RU_ALPHABET_SIZE;
+            out[i + j] = x;
+        }
+    }
+    return !bad;
+}
+
+#ifdef PACKED_X86
+
+/**
+ * @brief Упаковка AVX2: 32 буквы в 24 байта за итерацию
+ * @details В каждом 32-битном слове четыре байта-буквы сдвигаются к общему
+ * 24-битному числу, затем pshufb в каждой 128-битной половине собирает
+ * по 12 значащих байтов. Запас в 48 букв до конца гарантирует, что
+ * 16-байтовые записи не выходят за packedBytes(n).
+ * @param letters номера букв
+ * @param n количество букв
+ * @param out packedBytes(n) байтов результата
+ */
+ 
+__attribute__((target("avx2")))
+static void packAVX2(const uint8_t* letters, size_t n, uint8_t* out)
+{
+    const __m256i m0 = _mm256_set1_epi32(0x3F);
+    const __m256i m1 = _mm256_set1_epi32(0xFC0);
+    const __m256i m2 = _mm256_set1_epi32(0x3F000);
+    const __m256i m3 = _mm256_set1_epi32(0xFC0000);
+    const __m256i squeeze = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 48 <= n; i += 32, out += 24) {
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(letters + i));
+        __m256i v = _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(w, m0),
+                            _mm256_and_si256(_mm256_srli_epi32(w, 2), m1)),
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(w, 4), m2),
+                            _mm256_and_si256(_mm256_srli_epi32(w, 6), m3)));
+        v = _mm256_shuffle_epi8(v, squeeze);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm256_extracti128_si256(v, 1));
+    }
+    packScalar(letters + i, n - i, out);
+}
+
+/**
+ * @brief Распаковка AVX2: 24 байта в 32 буквы за итерацию с проверкой
+ * @param in упакованные буквы
+ * @param n количество букв
+ * @param out номера букв
+ * @return false если встретилось значение больше 32
+ */
+ 
+__attribute__((target("avx2")))
+static bool unpackAVX2(const uint8_t* in, size_t n, uint8_t* out)
+{
+    const __m256i spread = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i m0 = _mm256_set1_epi32(0x3F);
+    const __m256i m1 = _mm256_set1_epi32(0x3F00);
+    const __m256i m2 = _mm256_set1_epi32(0x3F0000);
+    const __m256i m3 = _mm256_set1_epi32(0x3F000000);
+    const __m256i maxLetter = _mm256_set1_epi8(RU_ALPHABET_SIZE - 1);
+    __m256i ok = _mm256_set1_epi8(-1);
+    size_t i = 0;
+    for (; i + 48 <= n; i += 32, in += 24) {
+        __m256i raw = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)), 1);
+        __m256i v = _mm256_shuffle_epi8(raw, spread);
+        __m256i w = _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(v, m0),
+                            _mm256_and_si256(_mm256_slli_epi32(v, 2), m1)),
+            _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(v, 4), m2),
+                            _mm256_and_si256(_mm256_slli_epi32(v, 6), m3)));
+        ok = _mm256_and_si256(ok, _mm256_cmpeq_epi8(_mm256_min_epu8(w, maxLetter), w));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), w);
+    }
+    bool tail = unpackScalar(in, n - i, out + i);
+    return tail && _mm256_movemask_epi8(ok) == -1;
+}
+
+#endif
+
+/**
+ * @brief Упаковка номеров букв по 6 бит
+ * @param isa набор инструкций
+ * @param letters номера букв 0..32
+ * @param n количество букв
+ * @param out packedBytes(n) байтов результата
+ */
+ 
+void packLetters(ruTranscodeIsa isa, const uint8_t* letters, size_t n, uint8_t* out)
+{
+    switch (isa) {
+#ifdef PACKED_X86
+    case RU_TRANSCODE_AVX2:
+        packAVX2(letters, n, out);
+        break;
+#endif
+    default:
+        packScalar(letters, n, out);
+    }
+}
+
+/**
+ * @brief Упаковка номеров букв лучшим доступным ядром
+ * @param letters номера букв 0..32
+ * @param n количество букв
+ * @param out packedBytes(n) байтов результата
+ */
+ 
+void packLetters(const uint8_t* letters, size_t n, uint8_t* out)
+{
+    packLetters(ruTranscodeBestIsa(), letters, n, out);
+}
+
+/**
+ * @brief Распаковка номеров букв с проверкой
+ * @param isa набор инструкций
+ * @param in packedBytes(n) байтов упакованных букв
+ * @param n количество букв
+ * @param out n номеров букв
+ * @return false если встретилось значение больше 32
+ */
+ 
+bool unpackLetters(ruTranscodeIsa isa, const uint8_t* in, size_t n, uint8_t* out)
+{
+    switch (isa) {
+#ifdef PACKED_X86
+    case RU_TRANSCODE_AVX2:
+        return unpackAVX2(in, n, out);
+#endif
+    default:
+        return unpackScalar(in, n, out);
+    }
+}
+
+/**
+ * @brief Распаковка номеров букв лучшим доступным ядром
+ * @param in packedBytes(n) байтов упакованных букв
+ * @param n количество букв
+ * @param out n номеров букв
+ * @return false если встретилось значение больше 32
+ */
+ 
+bool unpackLetters(const uint8_t* in, size_t n, uint8_t* out)
+{
+    return unpackLetters(ruTranscodeBestIsa(), in, n, out);
+}
+
+/**
+ * @brief Распаковка произвольного диапазона букв
+ * @param in упакованные буквы (данные после заголовка)
+ * @param offset номер первой буквы диапазона
+ * @param n количество букв
+ * @param out n номеров букв
+ * @return false если встретилось значение больше 32
+ */
+ 
+bool unpackRange(const uint8_t* in, size_t offset, size_t n, uint8_t* out)
+{
+    in += 3 * (offset / 4);
+    size_t skip = offset % 4;
+    size_t head = 0;
+    if (skip != 0) {
+        uint32_t v = getLe(in, packedBytes(min<size_t>(4, skip + n)));
+        uint8_t bad = 0;
+        for (size_t k = skip; k < 4 && head < n; ++k, ++head) {
+            out[head] = (v >> (6 * k)) & 0x3F;
+            bad |= out[head] >= RU_ALPHABET_SIZE;
+        }
+        if (bad)
+            return false;
+        in += 3;
+    }
+    return unpackLetters(in, n - head, out + head);
+}
+
+/**
+ * @brief Запись контейнера
+ * @param header шифр, количество букв и отпечаток ключа
+ * @param letters номера букв
+ * @return заголовок и упакованные буквы
+ */
+ 
+string packedEncode(const packedHeader& header, const uint8_t* letters)
+{
+    string out(PACKED_HEADER + packedBytes(header.length), '\0');
+    uint8_t* p = reinterpret_cast<uint8_t*>(&out[0]);
+    memcpy(p, PACKED_MAGIC, sizeof(PACKED_MAGIC));
+    p[4] = PACKED_VERSION;
+    p[5] = header.cipher;
+    putLe(p + 8, header.length, 8);
+    putLe(p + 16, header.fingerprint, 8);
+    packLetters(letters, header.length, p + PACKED_HEADER);
+    return out;
+}
+
+/**
+ * @brief Проверка сигнатуры контейнера
+ * @param data начало файла или строки
+ * @return true если данные начинаются с "RU6P"
+ */
+ 
+bool packedIsContainer(string_view data)
+{
+    return data.size() >= sizeof(PACKED_MAGIC) &&
+           memcmp(data.data(), PACKED_MAGIC, sizeof(PACKED_MAGIC)) == 0;
+}
+
+/**
+ * @brief Чтение заголовка контейнера
+ * @param data контейнер
+ * @param header прочитанный заголовок
+ * @return PACKED_OK, PACKED_BAD_HEADER или PACKED_BAD_LENGTH
+ */
+ 
+packedStatus packedReadHeader(string_view data, packedHeader& header)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data());
+    if (data.size() < PACKED_HEADER || memcmp(p, PACKED_MAGIC, sizeof(PACKED_MAGIC)) != 0 ||
+        p[4] != PACKED_VERSION || getLe(p + 6, 2) != 0 ||
+        (p[5] != PACKED_GRONSFELD && p[5] != PACKED_TABLE))
+        return PACKED_BAD_HEADER;
+    header.cipher = static_cast<packedCipher>(p[5]);
+    header.length = getLe(p + 8, 8);
+    header.fingerprint = getLe(p + 16, 8);
+    if (header.length > data.size() * 2 ||
+        packedBytes(header.length) != data.size() - PACKED_HEADER)
+        return PACKED_BAD_LENGTH;
+    return PACKED_OK;
+}
+
+/**
+ * @brief Проверка заголовка контейнера, шифра и ключа без распаковки
+ * @param data контейнер
+ * @param cipher ожидаемый шифр
+ * @param fingerprint ожидаемый отпечаток ключа
+ * @param header прочитанный заголовок
+ * @return итог разбора
+ */
+ 
+packedStatus packedOpen(string_view data, packedCipher cipher, uint64_t fingerprint,
+                        packedHeader& header)
+{
+    packedStatus status = packedReadHeader(data, header);
+    if (status != PACKED_OK)
+        return status;
+    if (header.cipher != cipher)
+        return PACKED_WRONG_CIPHER;
+    if (header.fingerprint != fingerprint)
+        return PACKED_WRONG_KEY;
+    return PACKED_OK;
+}
+
+/**
+ * @brief Чтение контейнера с проверкой шифра и ключа
+ * @param data контейнер
+ * @param cipher ожидаемый шифр
+ * @param fingerprint ожидаемый отпечаток ключа
+ * @param out номера букв
+ * @return итог разбора
+ */
+ 
+packedStatus packedDecode(string_view data, packedCipher cipher, uint64_t fingerprint,
+                          letterBuffer& out)
+{
+    packedHeader header;
+    packedStatus status = packedOpen(data, cipher, fingerprint, header);
+    if (status != PACKED_OK)
+        return status;
+    out.resize(header.length);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data()) + PACKED_HEADER;
+    return unpackLetters(p, header.length, out.data()) ? PACKED_OK : PACKED_BAD_LETTER;
+}
+
+/**
+ * @brief Текст ошибки разбора для исключений шифров
+ * @param status итог разбора
+ * @return сообщение на английском
+ */
+ 
+const char* packedMessage(packedStatus status)
+{
+    switch (status) {
+    case PACKED_OK:
+        return "OK";
+    case PACKED_BAD_HEADER:
+        return "Invalid packed header";
+    case PACKED_WRONG_CIPHER:
+        return "Packed text belongs to another cipher";
+    case PACKED_WRONG_KEY:
+        return "Packed text key mismatch";
+    case PACKED_BAD_LENGTH:
+        return "Invalid packed length";
+    default:
+        return "Invalid letter in packed text";
+    }
+}
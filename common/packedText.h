@@ -0,0 +1,187 @@
+/**
+ * @file packedText.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Упакованный двоичный формат шифртекста: 6 бит на букву
+ * @details 33 буквы помещаются в 6 бит, поэтому четыре буквы занимают три
+ * байта: в 2,7 раза меньше UTF-8 и в 5,3 раза меньше wstring. Контейнер
+ * начинается с заголовка фиксированной длины (все поля little-endian):
+ *
+ * | Смещение | Размер | Поле                                     |
+ * |----------|--------|------------------------------------------|
+ * | 0        | 4      | сигнатура "RU6P"                         |
+ * | 4        | 1      | версия формата (1)                       |
+ * | 5        | 1      | шифр (packedCipher)                      |
+ * | 6        | 2      | резерв (0)                               |
+ * | 8        | 8      | количество букв                          |
+ * | 16       | 8      | отпечаток ключа FNV-1a 64                |
+ *
+ * Далее идут группы по три байта: буквы l0..l3 группы образуют число
+ * l0 | l1 << 6 | l2 << 12 | l3 << 18, записанное младшим байтом вперед.
+ * Неполная последняя группа дополняется нулевыми битами и занимает
+ * столько байтов, сколько нужно для ее бит.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "ruTranscode.h"
+using namespace std;
+
+/// Размер заголовка контейнера, байт
+const size_t PACKED_HEADER = 24;
+
+/// Версия формата
+const uint8_t PACKED_VERSION = 1;
+
+/**
+ * @brief Шифр, которым получен упакованный текст
+ */
+enum packedCipher : uint8_t {
+    PACKED_GRONSFELD = 1, ///< modAlphaCipher
+    PACKED_TABLE = 2      ///< Table
+};
+
+/**
+ * @brief Итог разбора контейнера
+ */
+enum packedStatus {
+    PACKED_OK,           ///< Контейнер корректен
+    PACKED_BAD_HEADER,   ///< Неверная сигнатура, версия или резерв
+    PACKED_WRONG_CIPHER, ///< Контейнер записан другим шифром
+    PACKED_WRONG_KEY,    ///< Отпечаток ключа не совпадает
+    PACKED_BAD_LENGTH,   ///< Размер данных не соответствует количеству букв
+    PACKED_BAD_LETTER    ///< Значение 33..63 вместо номера буквы
+};
+
+/**
+ * @brief Заголовок контейнера
+ */
+struct packedHeader {
+    packedCipher cipher = PACKED_GRONSFELD; ///< Шифр
+    uint64_t length = 0; ///< Количество букв
+    uint64_t fingerprint = 0; ///< Отпечаток ключа
+};
+
+/**
+ * @brief Хеш FNV-1a 64 для отпечатка ключа
+ * @param data данные
+ * @param len длина в байтах
+ * @return 64-битный хеш
+ */
+uint64_t fnv1a64(const void* data, size_t len);
+
+/**
+ * @brief Размер упакованных букв без заголовка
+ * @param letters количество букв
+ * @return ceil(6 * letters / 8) байтов
+ */
+inline size_t packedBytes(size_t letters)
+{
+    return (letters * 6 + 7) / 8;
+}
+
+/**
+ * @brief Упаковка номеров букв по 6 бит
+ * @param isa набор инструкций (RU_TRANSCODE_AVX2 — 32 буквы за итерацию)
+ * @param letters номера букв 0..32
+ * @param n количество букв
+ * @param out packedBytes(n) байтов результата
+ */
+void packLetters(ruTranscodeIsa isa, const uint8_t* letters, size_t n, uint8_t* out);
+
+/**
+ * @brief Упаковка номеров букв лучшим доступным ядром
+ * @param letters номера букв 0..32
+ * @param n количество букв
+ * @param out packedBytes(n) байтов результата
+ */
+void packLetters(const uint8_t* letters, size_t n, uint8_t* out);
+
+/**
+ * @brief Распаковка номеров букв с проверкой
+ * @param isa набор инструкций
+ * @param in packedBytes(n) байтов упакованных букв
+ * @param n количество букв
+ * @param out n номеров букв
+ * @return false если встретилось значение больше 32
+ */
+bool unpackLetters(ruTranscodeIsa isa, const uint8_t* in, size_t n, uint8_t* out);
+
+/**
+ * @brief Распаковка номеров букв лучшим доступным ядром
+ * @param in packedBytes(n) байтов упакованных букв
+ * @param n количество букв
+ * @param out n номеров букв
+ * @return false если встретилось значение больше 32
+ */
+bool unpackLetters(const uint8_t* in, size_t n, uint8_t* out);
+
+/**
+ * @brief Распаковка произвольного диапазона букв
+ * @param in упакованные буквы (данные после заголовка)
+ * @param offset номер первой буквы диапазона
+ * @param n количество букв
+ * @param out n номеров букв
+ * @return false если встретилось значение больше 32
+ * @details Буква k лежит в группе k / 4 по смещению 3 * (k / 4), поэтому
+ * читаются только байты диапазона: неполная первая группа разбирается
+ * скалярно, остальное — unpackLetters
+ */
+bool unpackRange(const uint8_t* in, size_t offset, size_t n, uint8_t* out);
+
+/**
+ * @brief Запись контейнера
+ * @param header шифр, количество букв (должно быть равно n) и отпечаток ключа
+ * @param letters номера букв
+ * @return заголовок и упакованные буквы
+ */
+string packedEncode(const packedHeader& header, const uint8_t* letters);
+
+/**
+ * @brief Проверка сигнатуры контейнера
+ * @param data начало файла или строки
+ * @return true если данные начинаются с "RU6P"; шифртекст UTF-8 из
+ * прописных букв так начинаться не может
+ */
+bool packedIsContainer(string_view data);
+
+/**
+ * @brief Чтение заголовка контейнера
+ * @param data контейнер
+ * @param header прочитанный заголовок
+ * @return PACKED_OK, PACKED_BAD_HEADER или PACKED_BAD_LENGTH
+ */
+packedStatus packedReadHeader(string_view data, packedHeader& header);
+
+/**
+ * @brief Проверка заголовка контейнера, шифра и ключа без распаковки
+ * @param data контейнер
+ * @param cipher ожидаемый шифр
+ * @param fingerprint ожидаемый отпечаток ключа
+ * @param header прочитанный заголовок
+ * @return итог разбора; буквы не проверяются
+ */
+packedStatus packedOpen(string_view data, packedCipher cipher, uint64_t fingerprint,
+                        packedHeader& header);
+
+/**
+ * @brief Чтение контейнера с проверкой шифра и ключа
+ * @param data контейнер
+ * @param cipher ожидаемый шифр
+ * @param fingerprint ожидаемый отпечаток ключа
+ * @param out номера букв
+ * @return итог разбора
+ */
+packedStatus packedDecode(string_view data, packedCipher cipher, uint64_t fingerprint,
+                          letterBuffer& out);
+
+/**
+ * @brief Текст ошибки разбора для исключений шифров
+ * @param status итог разбора
+ * @return сообщение на английском, как у остальных ошибок шифров
+ */
+const char* packedMessage(packedStatus status);
@@ -0,0 +1,102 @@
+/**
+ * @file ruAlphabet.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Общая таблица классификации символов русского алфавита
+ * @details Таблица строится на этапе компиляции и по коду символа за одно
+ * обращение к памяти дает номер прописной буквы, номер строчной буквы
+ * (с флагом RU_CLASS_LOWER), признак пробельного символа или отказ.
+ * Используется обоими шифрами вместо std::map и поиска по строкам алфавита.
+ * @warning Реализация для русского языка
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+using namespace std;
+
+const uint8_t RU_ALPHABET_SIZE = 33; ///< Количество букв алфавита
+
+/// Прописные буквы в порядке номеров
+constexpr wchar_t RU_UPPER[] = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+
+/// Строчные буквы в порядке номеров
+constexpr wchar_t RU_LOWER[] = L"абвгдеёжзийклмнопрстуфхцчшщъыьэюя";
+
+const uint8_t RU_CLASS_INDEX = 0x3F;  ///< Маска номера буквы в классе
+const uint8_t RU_CLASS_LOWER = 0x40;  ///< Флаг строчной буквы
+const uint8_t RU_CLASS_SPACE = 0x80;  ///< Пробельный символ
+const uint8_t RU_CLASS_REJECT = 0xFF; ///< Прочие символы
+
+/// Размер таблицы: все коды до ё (U+0451) включительно
+const size_t RU_TABLE_SIZE = 0x460;
+
+/**
+ * @brief Построение таблицы классификации
+ * @return таблица классов для кодов 0..RU_TABLE_SIZE-1
+ * @details Пробельными считаются символы, для которых iswspace истинна
+ * в локалях C и UTF-8 (коды 0x09..0x0D и 0x20)
+ */
+constexpr array<uint8_t, RU_TABLE_SIZE> ruMakeClassTable()
+{
+    array<uint8_t, RU_TABLE_SIZE> t {};
+    for (size_t c = 0; c < RU_TABLE_SIZE; ++c)
+        t[c] = RU_CLASS_REJECT;
+    for (size_t c = 0x09; c <= 0x0D; ++c)
+        t[c] = RU_CLASS_SPACE;
+    t[0x20] = RU_CLASS_SPACE;
+    for (uint8_t k = 0; k < RU_ALPHABET_SIZE; ++k) {
+        t[RU_UPPER[k]] = k;
+        t[RU_LOWER[k]] = k | RU_CLASS_LOWER;
+    }
+    return t;
+}
+
+/// Таблица классификации, вычисленная при компиляции
+inline constexpr array<uint8_t, RU_TABLE_SIZE> ruClassTable = ruMakeClassTable();
+
+/**
+ * @brief Класс символа
+ * @param c символ
+ * @return номер прописной буквы, номер строчной с флагом RU_CLASS_LOWER,
+ * RU_CLASS_SPACE или RU_CLASS_REJECT
+ */
+inline uint8_t ruClassify(wchar_t c)
+{
+    if (static_cast<uint32_t>(c) < RU_TABLE_SIZE)
+        return ruClassTable[c];
+    return iswspace(c) ? RU_CLASS_SPACE : RU_CLASS_REJECT;
+}
+
+/**
+ * @brief Является ли класс буквой (любого регистра)
+ * @param cls класс символа
+ * @return true для букв
+ */
+inline bool ruIsLetter(uint8_t cls)
+{
+    return cls < RU_CLASS_SPACE;
+}
+
+/**
+ * @brief Является ли класс прописной буквой
+ * @param cls класс символа
+ * @return true для прописных букв
+ */
+inline bool ruIsUpper(uint8_t cls)
+{
+    return cls < RU_ALPHABET_SIZE;
+}
+
+/**
+ * @brief Номер буквы без учета регистра
+ * @param cls класс буквы
+ * @return номер 0..32
+ */
+inline uint8_t ruIndex(uint8_t cls)
+{
+    return cls & RU_CLASS_INDEX;
+}
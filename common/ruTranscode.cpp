@@ -0,0 +1,618 @@
+/**
+ * @file ruTranscode.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация скалярного, SSE2 и AVX2 перекодирования UTF-8
+ */
+
+#include "ruTranscode.h"
+#include "ruAlphabet.h"
+#include "ruUtf8.h"
+#include <array>
+#include <cwchar>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSCODE_X86 1
+#endif
+using namespace std;
+
+/**
+ * @brief Скалярное декодирование открытого текста до заданной позиции
+ * @param p текст
+ * @param n длина текста
+ * @param pos начальная позиция, на выходе — позиция после последнего символа
+ * @param end позиция, до которой идет разбор (символ может выйти за нее)
+ * @param out номера букв
+ * @return количество букв
+ */
+ 
+static size_t openScalar(const unsigned char* p, size_t n, size_t& pos, size_t end, uint8_t* out)
+{
+    size_t k = 0;
+    while (pos < end) {
+        wchar_t c;
+        pos += ruUtf8Next(p + pos, n - pos, c);
+        uint8_t cls = ruClassify(c);
+        if (ruIsLetter(cls))
+            out[k++] = ruIndex(cls);
+    }
+    return k;
+}
+
+/**
+ * @brief Скалярное декодирование шифртекста до заданной позиции
+ * @param p текст
+ * @param n длина текста
+ * @param pos начальная позиция, на выходе — позиция после разобранного
+ * @param end позиция, до которой идет разбор
+ * @param out номера букв
+ * @param res накапливаемый результат; при ошибке заполняются status и errorPos
+ * @return false если встретился недопустимый символ
+ */
+ 
+static bool cipherScalar(const unsigned char* p, size_t n, size_t& pos, size_t end,
+                         uint8_t* out, ruDecodeResult& res)
+{
+    while (pos < end) {
+        wchar_t c;
+        size_t len = ruUtf8Next(p + pos, n - pos, c);
+        uint8_t cls = ruClassify(c);
+        if (!ruIsUpper(cls)) {
+            res.status = cls == RU_CLASS_SPACE ? RU_TEXT_SPACE : RU_TEXT_INVALID;
+            res.errorPos = pos;
+            return false;
+        }
+        out[res.letters++] = cls;
+        pos += len;
+    }
+    return true;
+}
+
+/**
+ * @brief Скалярный отбор букв открытого текста из широких символов
+ * @param s текст
+ * @param pos начальная позиция
+ * @param end конечная позиция
+ * @param out номера букв
+ * @return количество букв
+ */
+ 
+static size_t openWideScalar(const wchar_t* s, size_t pos, size_t end, uint8_t* out)
+{
+    size_t k = 0;
+    for (; pos < end; ++pos) {
+        uint8_t cls = ruClassify(s[pos]);
+        if (ruIsLetter(cls))
+            out[k++] = ruIndex(cls);
+    }
+    return k;
+}
+
+/**
+ * @brief Скалярная проверка широкого шифртекста до заданной позиции
+ * @param s текст
+ * @param pos начальная позиция, на выходе — позиция после разобранного
+ * @param end позиция, до которой идет разбор
+ * @param out номера букв или nullptr, если нужна только проверка
+ * @param res накапливаемый результат; при ошибке заполняются status и errorPos
+ * @return false если встретился недопустимый символ
+ */
+ 
+static bool cipherWideScalar(const wchar_t* s, size_t& pos, size_t end, uint8_t* out,
+                             ruDecodeResult& res)
+{
+    for (; pos < end; ++pos) {
+        uint8_t cls = ruClassify(s[pos]);
+        if (!ruIsUpper(cls)) {
+            res.status = cls == RU_CLASS_SPACE ? RU_TEXT_SPACE : RU_TEXT_INVALID;
+            res.errorPos = pos;
+            return false;
+        }
+        if (out)
+            out[res.letters] = cls;
+        ++res.letters;
+    }
+    return true;
+}
+
+#ifdef TRANSCODE_X86
+
+/**
+ * @brief Таблица перестановок для уплотнения восьми байтов
+ * @return для каждой 8-битной маски индексы отмеченных байтов подряд
+ */
+ 
+static constexpr array<uint64_t, 256> makeCompactTable()
+{
+    array<uint64_t, 256> t {};
+    for (unsigned m = 0; m < 256; ++m) {
+        uint64_t v = 0;
+        unsigned k = 0;
+        for (unsigned b = 0; b < 8; ++b) {
+            if (m & (1u << b))
+                v |= uint64_t(b) << (8 * k++);
+        }
+        t[m] = v;
+    }
+    return t;
+}
+
+/// Перестановки pshufb для уплотнения по маске
+static constexpr array<uint64_t, 256> compactTable = makeCompactTable();
+
+/**
+ * @brief Декодирование открытого текста AVX2
+ * @details Каждая позиция блока считается возможным первым байтом
+ * двухбайтового символа; второй байт берется сдвинутой на байт загрузкой.
+ * Для D0 xx и D1 xx значение t = (xx & 0x3F) + (D1 ? 64 : 0) - 16 пробегает
+ * А..Я, а..п, р..я как 0..63, так что номер буквы без Ё равен t & 31;
+ * Ё и ё проверяются отдельно. Блок допускается на быстрый путь, если все
+ * его байты — ASCII, D0/D1 или продолжения, и продолжения стоят ровно
+ * после D0/D1. Символ, начатый последним байтом блока, переносится.
+ * Запас в 48 байт до конца входа гарантирует, что восьмибайтовые записи
+ * уплотнения не выходят за n / 2 элементов результата.
+ * @param p текст
+ * @param n длина текста
+ * @param out номера букв
+ * @return количество букв
+ */
+ 
+__attribute__((target("avx2,popcnt")))
+static size_t openAVX2(const unsigned char* p, size_t n, uint8_t* out)
+{
+    const __m256i d0 = _mm256_set1_epi8(char(0xD0));
+    const __m256i d1 = _mm256_set1_epi8(char(0xD1));
+    const __m256i lowBits = _mm256_set1_epi8(0x3F);
+    const __m256i sixteen = _mm256_set1_epi8(16);
+    const __m256i sixtyFour = _mm256_set1_epi8(64);
+    const __m256i maxT = _mm256_set1_epi8(63);
+    const __m256i five = _mm256_set1_epi8(5);
+    const __m256i six = _mm256_set1_epi8(6);
+    const __m256i topBits = _mm256_set1_epi8(char(0xC0));
+    const __m256i contBits = _mm256_set1_epi8(char(0x80));
+    const __m256i yoUpper = _mm256_set1_epi8(char(0x81));
+    const __m256i yoLower = _mm256_set1_epi8(char(0x91));
+    alignas(32) uint8_t idx[32];
+    size_t k = 0;
+    size_t pos = 0;
+    while (pos + 48 <= n) {
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + pos));
+        __m256i nb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + pos + 1));
+        __m256i isD0 = _mm256_cmpeq_epi8(b, d0);
+        __m256i isD1 = _mm256_cmpeq_epi8(b, d1);
+        uint32_t ascii = ~uint32_t(_mm256_movemask_epi8(b));
+        uint32_t lead = _mm256_movemask_epi8(_mm256_or_si256(isD0, isD1));
+        uint32_t cont = _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_and_si256(b, topBits), contBits));
+        size_t step = 32;
+        if (lead >> 31) {
+            lead &= 0x7FFFFFFF;
+            step = 31;
+        }
+        if ((ascii | lead | cont | (step == 31 ? 0x80000000u : 0)) != 0xFFFFFFFF ||
+            cont != (lead << 1)) {
+            size_t end = pos + 32;
+            k += openScalar(p, n, pos, end, out + k);
+            continue;
+        }
+        if (lead == 0) {
+            pos += step;
+            continue;
+        }
+        __m256i t = _mm256_add_epi8(_mm256_and_si256(nb, lowBits),
+                                    _mm256_and_si256(isD1, sixtyFour));
+        t = _mm256_sub_epi8(t, sixteen);
+        __m256i letter = _mm256_cmpeq_epi8(_mm256_min_epu8(t, maxT), t);
+        __m256i yo = _mm256_or_si256(
+            _mm256_and_si256(isD0, _mm256_cmpeq_epi8(nb, yoUpper)),
+            _mm256_and_si256(isD1, _mm256_cmpeq_epi8(nb, yoLower)));
+        __m256i m = _mm256_and_si256(t, _mm256_set1_epi8(31));
+        __m256i v = _mm256_sub_epi8(m, _mm256_cmpgt_epi8(m, five));
+        v = _mm256_blendv_epi8(v, six, yo);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(idx), v);
+        uint32_t keep = lead & _mm256_movemask_epi8(_mm256_or_si256(letter, yo));
+        for (unsigned g = 0; g < 4; ++g) {
+            unsigned sel = (keep >> (8 * g)) & 0xFF;
+            __m128i src = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(idx + 8 * g));
+            __m128i perm = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&compactTable[sel]));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + k), _mm_shuffle_epi8(src, perm));
+            k += _mm_popcnt_u32(sel);
+        }
+        pos += step;
+    }
+    k += openScalar(p, n, pos, n, out + k);
+    return k;
+}
+
+/**
+ * @brief Декодирование шифртекста AVX2: 32 буквы (64 байта) за итерацию
+ * @details Пары байтов читаются как 16-битные слова: младший байт обязан
+ * быть D0, старший дает номер (xx - 0x90 для А..Я с пропуском Ё, 0x81 — Ё).
+ * Итерация с любым другим символом разбирается скалярно, что находит
+ * первую ошибку и ее позицию.
+ * @param p текст
+ * @param n длина текста
+ * @param out номера букв
+ * @return количество букв и итог проверки
+ */
+ 
+__attribute__((target("avx2")))
+static ruDecodeResult cipherAVX2(const unsigned char* p, size_t n, uint8_t* out)
+{
+    const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+    const __m256i lead = _mm256_set1_epi16(0x00D0);
+    const __m256i base = _mm256_set1_epi8(char(0x90));
+    const __m256i maxT = _mm256_set1_epi8(31);
+    const __m256i five = _mm256_set1_epi8(5);
+    const __m256i six = _mm256_set1_epi8(6);
+    const __m256i yoByte = _mm256_set1_epi8(char(0x81));
+    ruDecodeResult res;
+    size_t pos = 0;
+    while (pos + 64 <= n) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + pos));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + pos + 32));
+        __m256i leadOk = _mm256_and_si256(
+            _mm256_cmpeq_epi16(_mm256_and_si256(a, lowByte), lead),
+            _mm256_cmpeq_epi16(_mm256_and_si256(b, lowByte), lead));
+        __m256i x = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+        x = _mm256_permute4x64_epi64(x, 0xD8);
+        __m256i t = _mm256_sub_epi8(x, base);
+        __m256i yo = _mm256_cmpeq_epi8(x, yoByte);
+        __m256i ok = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(t, maxT), t), yo);
+        if ((_mm256_movemask_epi8(leadOk) & _mm256_movemask_epi8(ok)) != -1) {
+            if (!cipherScalar(p, n, pos, pos + 64, out, res))
+                return res;
+            continue;
+        }
+        __m256i v = _mm256_sub_epi8(t, _mm256_cmpgt_epi8(t, five));
+        v = _mm256_blendv_epi8(v, six, yo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + res.letters), v);
+        res.letters += 32;
+        pos += 64;
+    }
+    cipherScalar(p, n, pos, n, out, res);
+    return res;
+}
+
+/**
+ * @brief Сжатие четырех векторов 32-битных номеров в 32 байта по порядку
+ * @param v номера букв 0..32 (прочие значения насыщаются)
+ * @return байты v[0][0..7], v[1][0..7], v[2][0..7], v[3][0..7]
+ */
+ 
+__attribute__((target("avx2")))
+static inline __m256i packWide(const __m256i* v)
+{
+    __m256i b = _mm256_packus_epi16(_mm256_packs_epi32(v[0], v[1]),
+                                    _mm256_packs_epi32(v[2], v[3]));
+    return _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+#if WCHAR_MAX > 0xFFFF
+
+/**
+ * @brief Отбор букв открытого текста из широких символов AVX2: 32 символа за итерацию
+ * @details Для кода c значение t = c - U+0410 пробегает А..Я, а..я как
+ * 0..63 (беззнаковое сравнение отсекает остальное), номер буквы без Ё
+ * равен t & 31 с поправкой на Ё, как в openAVX2. Номера 32-битных слов
+ * сжимаются в байты и уплотняются по маске букв; блок только из букв
+ * записывается целиком.
+ * @param s текст
+ * @param n длина в символах
+ * @param out номера букв; достаточно n элементов
+ * @return количество букв
+ */
+ 
+__attribute__((target("avx2,popcnt")))
+static size_t openWideAVX2(const wchar_t* s, size_t n, uint8_t* out)
+{
+    const __m256i base = _mm256_set1_epi32(0x410);
+    const __m256i maxT = _mm256_set1_epi32(63);
+    const __m256i low5 = _mm256_set1_epi32(31);
+    const __m256i five = _mm256_set1_epi32(5);
+    const __m256i six = _mm256_set1_epi32(6);
+    const __m256i yoUpper = _mm256_set1_epi32(0x401);
+    const __m256i yoLower = _mm256_set1_epi32(0x451);
+    alignas(32) uint8_t idx[32];
+    size_t k = 0;
+    size_t pos = 0;
+    for (; pos + 32 <= n; pos += 32) {
+        __m256i v[4];
+        uint32_t keep = 0;
+        for (unsigned g = 0; g < 4; ++g) {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pos + 8 * g));
+            __m256i t = _mm256_sub_epi32(c, base);
+            __m256i letter = _mm256_cmpeq_epi32(_mm256_min_epu32(t, maxT), t);
+            __m256i yo = _mm256_or_si256(_mm256_cmpeq_epi32(c, yoUpper),
+                                         _mm256_cmpeq_epi32(c, yoLower));
+            __m256i m = _mm256_and_si256(t, low5);
+            v[g] = _mm256_blendv_epi8(_mm256_sub_epi32(m, _mm256_cmpgt_epi32(m, five)), six, yo);
+            keep |= uint32_t(_mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_or_si256(letter, yo)))) << (8 * g);
+        }
+        if (keep == 0)
+            continue;
+        __m256i b = packWide(v);
+        if (keep == 0xFFFFFFFF) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k), b);
+            k += 32;
+            continue;
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i*>(idx), b);
+        for (unsigned g = 0; g < 4; ++g) {
+            unsigned sel = (keep >> (8 * g)) & 0xFF;
+            __m128i src = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(idx + 8 * g));
+            __m128i perm = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&compactTable[sel]));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + k), _mm_shuffle_epi8(src, perm));
+            k += _mm_popcnt_u32(sel);
+        }
+    }
+    return k + openWideScalar(s, pos, n, out + k);
+}
+
+/**
+ * @brief Проверка широкого шифртекста AVX2: 32 символа за итерацию
+ * @details Допустимы только U+0410..U+042F и U+0401. Блок с другим символом
+ * разбирается скалярно, что дает первую ошибку и ее позицию.
+ * @param s текст
+ * @param n длина в символах
+ * @param out номера букв или nullptr, если нужна только проверка
+ * @return количество букв и итог проверки
+ */
+ 
+__attribute__((target("avx2")))
+static ruDecodeResult cipherWideAVX2(const wchar_t* s, size_t n, uint8_t* out)
+{
+    const __m256i base = _mm256_set1_epi32(0x410);
+    const __m256i maxT = _mm256_set1_epi32(31);
+    const __m256i five = _mm256_set1_epi32(5);
+    const __m256i six = _mm256_set1_epi32(6);
+    const __m256i yoUpper = _mm256_set1_epi32(0x401);
+    ruDecodeResult res;
+    size_t pos = 0;
+    while (pos + 32 <= n) {
+        __m256i v[4];
+        uint32_t ok = 0;
+        for (unsigned g = 0; g < 4; ++g) {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pos + 8 * g));
+            __m256i t = _mm256_sub_epi32(c, base);
+            __m256i upper = _mm256_cmpeq_epi32(_mm256_min_epu32(t, maxT), t);
+            __m256i yo = _mm256_cmpeq_epi32(c, yoUpper);
+            v[g] = _mm256_blendv_epi8(_mm256_sub_epi32(t, _mm256_cmpgt_epi32(t, five)), six, yo);
+            ok |= uint32_t(_mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_or_si256(upper, yo)))) << (8 * g);
+        }
+        if (ok != 0xFFFFFFFF) {
+            if (!cipherWideScalar(s, pos, pos + 32, out, res))
+                return res;
+            continue;
+        }
+        if (out)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + res.letters), packWide(v));
+        res.letters += 32;
+        pos += 32;
+    }
+    cipherWideScalar(s, pos, n, out, res);
+    return res;
+}
+
+#define TRANSCODE_WIDE32 1
+#endif
+
+#endif
+
+/**
+ * @brief Проверка поддержки набора инструкций процессором
+ * @param isa набор инструкций
+ * @return true если декодер isa можно вызывать
+ */
+ 
+bool ruTranscodeSupported(ruTranscodeIsa isa)
+{
+    switch (isa) {
+    case RU_TRANSCODE_SCALAR:
+        return true;
+#ifdef TRANSCODE_X86
+    case RU_TRANSCODE_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Лучший набор инструкций, поддерживаемый процессором
+ * @return RU_TRANSCODE_AVX2 или RU_TRANSCODE_SCALAR
+ * @details Результат определяется один раз при первом вызове
+ */
+ 
+ruTranscodeIsa ruTranscodeBestIsa()
+{
+    static const ruTranscodeIsa best =
+        ruTranscodeSupported(RU_TRANSCODE_AVX2) ? RU_TRANSCODE_AVX2 : RU_TRANSCODE_SCALAR;
+    return best;
+}
+
+/**
+ * @brief Декодирование открытого текста
+ * @param isa набор инструкций
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв
+ */
+ 
+size_t ruDecodeOpen(ruTranscodeIsa isa, const char* in, size_t n, uint8_t* out)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    switch (isa) {
+#ifdef TRANSCODE_X86
+    case RU_TRANSCODE_AVX2:
+        return openAVX2(p, n, out);
+#endif
+    default: {
+        size_t pos = 0;
+        return openScalar(p, n, pos, n, out);
+    }
+    }
+}
+
+/**
+ * @brief Декодирование открытого текста лучшим доступным декодером
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв
+ */
+ 
+size_t ruDecodeOpen(const char* in, size_t n, uint8_t* out)
+{
+    return ruDecodeOpen(ruTranscodeBestIsa(), in, n, out);
+}
+
+/**
+ * @brief Декодирование шифртекста с проверкой
+ * @param isa набор инструкций
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв и итог проверки
+ */
+ 
+ruDecodeResult ruDecodeCipher(ruTranscodeIsa isa, const char* in, size_t n, uint8_t* out)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    switch (isa) {
+#ifdef TRANSCODE_X86
+    case RU_TRANSCODE_AVX2:
+        return cipherAVX2(p, n, out);
+#endif
+    default: {
+        ruDecodeResult res;
+        size_t pos = 0;
+        cipherScalar(p, n, pos, n, out, res);
+        return res;
+    }
+    }
+}
+
+/**
+ * @brief Декодирование шифртекста лучшим доступным декодером
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв и итог проверки
+ */
+ 
+ruDecodeResult ruDecodeCipher(const char* in, size_t n, uint8_t* out)
+{
+    return ruDecodeCipher(ruTranscodeBestIsa(), in, n, out);
+}
+
+/**
+ * @brief Кодирование номеров букв прописными буквами UTF-8
+ * @details SSE2 входит в базовый набор x86-64, поэтому выбор во время
+ * выполнения не нужен: второй байт равен 0x90 + idx - (idx > 6), для Ё — 0x81,
+ * первый байт всегда D0
+ * @param idx номера букв 0..32
+ * @param n количество букв
+ * @param out 2 * n байтов результата
+ */
+ 
+void ruEncodeUpper(const uint8_t* idx, size_t n, char* out)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i base = _mm_set1_epi8(char(0x90));
+    const __m128i six = _mm_set1_epi8(6);
+    const __m128i yoByte = _mm_set1_epi8(char(0x81));
+    const __m128i lead = _mm_set1_epi8(char(0xD0));
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx + i));
+        __m128i x = _mm_add_epi8(_mm_add_epi8(v, base), _mm_cmpgt_epi8(v, six));
+        __m128i yo = _mm_cmpeq_epi8(v, six);
+        x = _mm_or_si128(_mm_andnot_si128(yo, x), _mm_and_si128(yo, yoByte));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(lead, x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(lead, x));
+    }
+#endif
+    for (; i < n; ++i)
+        ruUtf8PutUpper(idx[i], out + 2 * i);
+}
+
+/**
+ * @brief Отбор букв открытого текста из широкой строки
+ * @param isa набор инструкций
+ * @param s открытый текст
+ * @param out номера букв; достаточно s.size() элементов
+ * @return количество букв
+ */
+ 
+size_t ruDecodeOpen(ruTranscodeIsa isa, wstring_view s, uint8_t* out)
+{
+#ifdef TRANSCODE_WIDE32
+    if (isa == RU_TRANSCODE_AVX2)
+        return openWideAVX2(s.data(), s.size(), out);
+#endif
+    return openWideScalar(s.data(), 0, s.size(), out);
+}
+
+/**
+ * @brief Отбор букв открытого текста из широкой строки лучшим доступным ядром
+ * @param s открытый текст
+ * @param out номера букв; достаточно s.size() элементов
+ * @return количество букв
+ */
+ 
+size_t ruDecodeOpen(wstring_view s, uint8_t* out)
+{
+    return ruDecodeOpen(ruTranscodeBestIsa(), s, out);
+}
+
+/**
+ * @brief Номера букв шифртекста из широкой строки с проверкой
+ * @param isa набор инструкций
+ * @param s шифртекст
+ * @param out номера букв; достаточно s.size() элементов; nullptr — только проверка
+ * @return количество букв и итог проверки; разбор останавливается
+ * на первом недопустимом символе
+ */
+ 
+ruDecodeResult ruDecodeCipher(ruTranscodeIsa isa, wstring_view s, uint8_t* out)
+{
+#ifdef TRANSCODE_WIDE32
+    if (isa == RU_TRANSCODE_AVX2)
+        return cipherWideAVX2(s.data(), s.size(), out);
+#endif
+    ruDecodeResult res;
+    size_t pos = 0;
+    cipherWideScalar(s.data(), pos, s.size(), out, res);
+    return res;
+}
+
+/**
+ * @brief Номера букв шифртекста из широкой строки лучшим доступным ядром
+ * @param s шифртекст
+ * @param out номера букв; достаточно s.size() элементов; nullptr — только проверка
+ * @return количество букв и итог проверки
+ */
+ 
+ruDecodeResult ruDecodeCipher(wstring_view s, uint8_t* out)
+{
+    return ruDecodeCipher(ruTranscodeBestIsa(), s, out);
+}
+
+/**
+ * @brief Запись номеров букв прописными буквами в широкую строку
+ * @param idx номера букв 0..32
+ * @param n количество букв
+ * @param out n символов результата
+ */
+ 
+void ruEncodeUpper(const uint8_t* idx, size_t n, wchar_t* out)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = RU_UPPER[idx[i]];
+}
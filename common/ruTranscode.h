@@ -0,0 +1,164 @@
+/**
+ * @file ruTranscode.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Перекодирование UTF-8 в номера букв и обратно с SIMD
+ * @details Декодер проверяет UTF-8 и сразу пишет однобайтовые номера букв
+ * 0..32, минуя wchar_t. Быстрый путь AVX2 обрабатывает блоки из ASCII и
+ * двухбайтовых символов с первым байтом D0/D1 (вся кириллица алфавита):
+ * номера вычисляются для всех позиций блока, затем буквы уплотняются
+ * перестановкой pshufb по таблице масок. Блок с другими символами или
+ * ошибкой разбирается скалярно. Кодировщик пишет прописные буквы, все они
+ * в UTF-8 имеют вид D0 xx. Перегрузки для wstring_view и wchar_t служат
+ * краями API шифров, принимающих широкие строки: внутри шифров текст
+ * хранится только как letterBuffer. Широкие строки с 32-битным wchar_t
+ * классифицируются AVX2 по 32 символа: буквы уплотняются так же, как
+ * в UTF-8, а блок с недопустимым символом дорабатывается скалярно ради
+ * позиции первой ошибки.
+ * @warning Реализация для русского языка
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+/// Текст внутри шифров: номера букв 0..32, один байт на букву
+using letterBuffer = vector<uint8_t>;
+
+/**
+ * @brief Набор инструкций декодера
+ */
+enum ruTranscodeIsa {
+    RU_TRANSCODE_SCALAR, ///< Скалярная эталонная реализация
+    RU_TRANSCODE_AVX2    ///< 32 байта входа за итерацию
+};
+
+/**
+ * @brief Итог проверки шифртекста
+ */
+enum ruTextStatus {
+    RU_TEXT_OK,      ///< Только прописные буквы
+    RU_TEXT_SPACE,   ///< Встретился пробельный символ
+    RU_TEXT_INVALID  ///< Встретился другой недопустимый символ или байт
+};
+
+/**
+ * @brief Результат декодирования шифртекста
+ */
+struct ruDecodeResult {
+    size_t letters = 0; ///< Количество записанных номеров букв
+    ruTextStatus status = RU_TEXT_OK; ///< Итог проверки
+    size_t errorPos = 0; ///< Смещение первого недопустимого символа (байты UTF-8 или символы wstring)
+};
+
+/**
+ * @brief Проверка поддержки набора инструкций процессором
+ * @param isa набор инструкций
+ * @return true если декодер isa можно вызывать
+ */
+bool ruTranscodeSupported(ruTranscodeIsa isa);
+
+/**
+ * @brief Лучший набор инструкций, поддерживаемый процессором
+ * @return RU_TRANSCODE_AVX2 или RU_TRANSCODE_SCALAR
+ */
+ruTranscodeIsa ruTranscodeBestIsa();
+
+/**
+ * @brief Декодирование открытого текста
+ * @param isa набор инструкций
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв
+ * @details Буквы обоих регистров дают номера 0..32, остальные символы
+ * и некорректные байты пропускаются
+ */
+size_t ruDecodeOpen(ruTranscodeIsa isa, const char* in, size_t n, uint8_t* out);
+
+/**
+ * @brief Декодирование открытого текста лучшим доступным декодером
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв
+ */
+size_t ruDecodeOpen(const char* in, size_t n, uint8_t* out);
+
+/**
+ * @brief Декодирование шифртекста с проверкой
+ * @param isa набор инструкций
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв и итог проверки; разбор останавливается
+ * на первом недопустимом символе
+ */
+ruDecodeResult ruDecodeCipher(ruTranscodeIsa isa, const char* in, size_t n, uint8_t* out);
+
+/**
+ * @brief Декодирование шифртекста лучшим доступным декодером
+ * @param in текст в UTF-8
+ * @param n длина в байтах
+ * @param out номера букв; достаточно n / 2 элементов
+ * @return количество букв и итог проверки
+ */
+ruDecodeResult ruDecodeCipher(const char* in, size_t n, uint8_t* out);
+
+/**
+ * @brief Кодирование номеров букв прописными буквами UTF-8
+ * @param idx номера букв 0..32
+ * @param n количество букв
+ * @param out 2 * n байтов результата
+ */
+void ruEncodeUpper(const uint8_t* idx, size_t n, char* out);
+
+/**
+ * @brief Отбор букв открытого текста из широкой строки
+ * @param isa набор инструкций (RU_TRANSCODE_AVX2 — 32 символа за итерацию,
+ * только при 32-битном wchar_t; иначе используется скалярный путь)
+ * @param s открытый текст
+ * @param out номера букв; достаточно s.size() элементов
+ * @return количество букв; остальные символы пропускаются, строчные
+ * буквы дают номера прописных
+ */
+size_t ruDecodeOpen(ruTranscodeIsa isa, wstring_view s, uint8_t* out);
+
+/**
+ * @brief Отбор букв открытого текста из широкой строки лучшим доступным ядром
+ * @param s открытый текст
+ * @param out номера букв; достаточно s.size() элементов
+ * @return количество букв; остальные символы пропускаются
+ */
+size_t ruDecodeOpen(wstring_view s, uint8_t* out);
+
+/**
+ * @brief Номера букв шифртекста из широкой строки с проверкой
+ * @param isa набор инструкций
+ * @param s шифртекст
+ * @param out номера букв; достаточно s.size() элементов; nullptr —
+ * только проверка без записи
+ * @return количество букв и итог проверки; errorPos — номер первого
+ * недопустимого символа
+ */
+ruDecodeResult ruDecodeCipher(ruTranscodeIsa isa, wstring_view s, uint8_t* out);
+
+/**
+ * @brief Номера букв шифртекста из широкой строки лучшим доступным ядром
+ * @param s шифртекст
+ * @param out номера букв; достаточно s.size() элементов; nullptr — только проверка
+ * @return количество букв и итог проверки; errorPos — номер символа
+ */
+ruDecodeResult ruDecodeCipher(wstring_view s, uint8_t* out);
+
+/**
+ * @brief Запись номеров букв прописными буквами в широкую строку
+ * @param idx номера букв 0..32
+ * @param n количество букв
+ * @param out n символов результата
+ */
+void ruEncodeUpper(const uint8_t* idx, size_t n, wchar_t* out);
@@ -0,0 +1,143 @@
+/**
+ * @file ruUtf8.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Разбор UTF-8 и запись букв русского алфавита в UTF-8
+ * @details Все прописные буквы алфавита занимают в UTF-8 ровно два байта,
+ * поэтому шифртекст в UTF-8 имеет фиксированную ширину символа.
+ * @warning Реализация для русского языка
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "ruAlphabet.h"
+using namespace std;
+
+const size_t RU_UTF8_LETTER = 2; ///< Длина прописной буквы в UTF-8
+
+/**
+ * @brief Длина символа UTF-8 по первому байту
+ * @param b первый байт
+ * @return 1..4; для некорректного первого байта 1
+ */
+inline size_t ruUtf8Length(unsigned char b)
+{
+    if (b < 0xC2 || b > 0xF4)
+        return 1;
+    return b >= 0xF0 ? 4 : b >= 0xE0 ? 3 : 2;
+}
+
+/**
+ * @brief Чтение одного символа UTF-8
+ * @param p начало символа
+ * @param avail количество доступных байтов (больше нуля)
+ * @param cp прочитанный код символа, -1 для некорректной последовательности
+ * @return количество использованных байтов (не меньше одного)
+ * @details Как и codecvt_utf8, отвергает избыточно длинные формы
+ * (E0 80..9F, F0 80..8F), суррогаты (ED A0..BF) и коды выше U+10FFFF,
+ * поэтому каждая прописная буква занимает ровно RU_UTF8_LETTER байта
+ */
+inline size_t ruUtf8Next(const unsigned char* p, size_t avail, wchar_t& cp)
+{
+    unsigned char b = p[0];
+    if (b < 0x80) {
+        cp = b;
+        return 1;
+    }
+    size_t len = ruUtf8Length(b);
+    if (len == 1 || len > avail) {
+        cp = -1;
+        return 1;
+    }
+    uint32_t v = b & (0x7F >> len);
+    for (size_t i = 1; i < len; ++i) {
+        if ((p[i] & 0xC0) != 0x80) {
+            cp = -1;
+            return 1;
+        }
+        v = (v << 6) | (p[i] & 0x3F);
+    }
+    static const uint32_t minCode[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (v < minCode[len] || v > 0x10FFFF || (v >= 0xD800 && v <= 0xDFFF)) {
+        cp = -1;
+        return 1;
+    }
+    cp = static_cast<wchar_t>(v);
+    return len;
+}
+
+/**
+ * @brief Запись прописной буквы в UTF-8
+ * @param idx номер буквы 0..32
+ * @param out место для RU_UTF8_LETTER байтов
+ */
+inline void ruUtf8PutUpper(uint8_t idx, char* out)
+{
+    uint32_t cp = RU_UPPER[idx];
+    out[0] = static_cast<char>(0xC0 | (cp >> 6));
+    out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+}
+
+/**
+ * @brief Прописная буква в UTF-8 как одно 16-битное слово
+ * @param idx номер буквы 0..32
+ * @return слово, байты которого в памяти совпадают с записью буквы в UTF-8
+ */
+inline uint16_t ruUtf8Unit(uint8_t idx)
+{
+    char bytes[RU_UTF8_LETTER];
+    ruUtf8PutUpper(idx, bytes);
+    uint16_t unit;
+    memcpy(&unit, bytes, sizeof(unit));
+    return unit;
+}
+
+/**
+ * @brief Разбор части текста UTF-8, которая может обрываться посреди символа
+ * @param tail буфер незавершенного символа, переходящий между частями
+ * @param tailLen длина незавершенного символа (0 — нет)
+ * @param data часть текста
+ * @param len длина части в байтах
+ * @param take вызывается для каждого полного символа (код или -1)
+ * @details Символ, начатый в предыдущей части, дочитывается из начала этой;
+ * оборванный на конце символ (не длиннее трех байт) сохраняется в tail
+ */
+template <class F>
+void ruUtf8Feed(unsigned char (&tail)[4], size_t& tailLen, const char* data, size_t len, F&& take)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    size_t pos = 0;
+    if (tailLen > 0) {
+        unsigned char joined[8];
+        size_t extra = len < 4 ? len : 4;
+        size_t avail = tailLen + extra;
+        memcpy(joined, tail, tailLen);
+        memcpy(joined + tailLen, p, extra);
+        size_t at = 0;
+        while (at < tailLen) {
+            if (ruUtf8Length(joined[at]) > avail - at) {
+                tailLen = avail - at;
+                memmove(tail, joined + at, tailLen);
+                return;
+            }
+            wchar_t cp;
+            at += ruUtf8Next(joined + at, avail - at, cp);
+            take(cp);
+        }
+        pos = at - tailLen;
+        tailLen = 0;
+    }
+    while (pos < len) {
+        if (ruUtf8Length(p[pos]) > len - pos) {
+            tailLen = len - pos;
+            memcpy(tail, p + pos, tailLen);
+            return;
+        }
+        wchar_t cp;
+        pos += ruUtf8Next(p + pos, len - pos, cp);
+        take(cp);
+    }
+}
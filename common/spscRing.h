@@ -0,0 +1,155 @@
+/**
+ * @file spscRing.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Ограниченная очередь без блокировок для одного писателя и одного читателя
+ * @details Кольцо из степени двойки ячеек с индексами записи и чтения на
+ * разных кэш-линиях. tryPush/tryPop не берут мьютексов и не делают
+ * системных вызовов. push/pop ждут места или данных на счетчике событий
+ * через atomic::wait (futex), так что переполненная очередь останавливает
+ * писателя (обратное давление), не занимая процессор.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+/**
+ * @brief Очередь SPSC фиксированной емкости
+ * @tparam T тип элемента (копируемый; обычно указатель на блок)
+ * @warning push/tryPush вызывает только один поток, pop/tryPop — только один
+ * (возможно, другой) поток
+ */
+template <class T>
+class spscRing
+{
+private:
+    vector<T> slots; ///< Ячейки кольца
+    size_t mask; ///< Емкость - 1
+    alignas(64) atomic<size_t> head{0}; ///< Следующая ячейка чтения (двигает читатель)
+    alignas(64) atomic<size_t> tail{0}; ///< Следующая ячейка записи (двигает писатель)
+    alignas(64) atomic<uint32_t> events{0}; ///< Счетчик записей, чтений и закрытия для ожидания
+    atomic<bool> closed{false}; ///< Очередь закрыта
+    
+    /**
+     * @brief Пробуждение ожидающей стороны
+     */
+    void signal()
+    {
+        events.fetch_add(1, memory_order_release);
+        events.notify_all();
+    }
+    
+public:
+    /**
+     * @brief Конструктор
+     * @param capacity емкость, округляется вверх до степени двойки (не меньше 1)
+     */
+    explicit spscRing(size_t capacity)
+    {
+        size_t n = 1;
+        while (n < capacity)
+            n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+    
+    spscRing(const spscRing&) = delete;
+    spscRing& operator=(const spscRing&) = delete;
+    
+    /**
+     * @brief Емкость
+     * @return количество ячеек
+     */
+    size_t capacity() const { return slots.size(); }
+    
+    /**
+     * @brief Занятость
+     * @return количество элементов в очереди на момент вызова
+     */
+    size_t size() const
+    {
+        return tail.load(memory_order_acquire) - head.load(memory_order_acquire);
+    }
+    
+    /**
+     * @brief Запись без ожидания
+     * @param v элемент
+     * @return false если очередь полна
+     */
+    bool tryPush(const T& v)
+    {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == slots.size())
+            return false;
+        slots[t & mask] = v;
+        tail.store(t + 1, memory_order_release);
+        signal();
+        return true;
+    }
+    
+    /**
+     * @brief Чтение без ожидания
+     * @param v прочитанный элемент
+     * @return false если очередь пуста
+     */
+    bool tryPop(T& v)
+    {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire))
+            return false;
+        v = slots[h & mask];
+        head.store(h + 1, memory_order_release);
+        signal();
+        return true;
+    }
+    
+    /**
+     * @brief Запись с ожиданием свободной ячейки
+     * @param v элемент
+     * @return false если очередь закрыта
+     */
+    bool push(const T& v)
+    {
+        for (;;) {
+            uint32_t seen = events.load(memory_order_acquire);
+            if (closed.load(memory_order_acquire))
+                return false;
+            if (tryPush(v))
+                return true;
+            events.wait(seen, memory_order_acquire);
+        }
+    }
+    
+    /**
+     * @brief Чтение с ожиданием элемента
+     * @param v прочитанный элемент
+     * @return false если очередь закрыта
+     */
+    bool pop(T& v)
+    {
+        for (;;) {
+            uint32_t seen = events.load(memory_order_acquire);
+            if (closed.load(memory_order_acquire))
+                return false;
+            if (tryPop(v))
+                return true;
+            events.wait(seen, memory_order_acquire);
+        }
+    }
+    
+    /**
+     * @brief Закрытие: ожидающие и последующие push/pop возвращают false
+     * @details Используется для аварийной остановки конвейера; может
+     * вызываться из любого потока
+     */
+    void close()
+    {
+        closed.store(true, memory_order_release);
+        signal();
+    }
+};
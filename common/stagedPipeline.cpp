@@ -0,0 +1,336 @@
+/**
+ * @file stagedPipeline.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация конвейера стадий на очередях spscRing
+ */
+
+#include "stagedPipeline.h"
+#include "spscRing.h"
+#include "mappedFile.h"
+#include "ruUtf8.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+using stageClock = chrono::steady_clock;
+
+/**
+ * @brief Блок, передаваемый между стадиями
+ */
+struct stageBlock {
+    string bytes; ///< Вход UTF-8, после шифра — результат UTF-8
+    letterBuffer letters; ///< Номера букв блока
+    bool last = false; ///< Последний блок потока
+};
+
+/// Очередь блоков между стадиями
+using stageRing = spscRing<stageBlock*>;
+
+/**
+ * @brief Время с отметки с переносом отметки на текущий момент
+ * @param mark отметка времени
+ * @return прошедшее время, с
+ */
+ 
+static double lap(stageClock::time_point& mark)
+{
+    stageClock::time_point now = stageClock::now();
+    chrono::duration<double> spent = now - mark;
+    mark = now;
+    return spent.count();
+}
+
+/**
+ * @brief Граница последнего полного символа UTF-8
+ * @param data текст
+ * @param len длина в байтах
+ * @return длина текста без оборванного на конце символа
+ */
+ 
+static size_t utf8Cut(const char* data, size_t len)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    for (size_t back = 1; back <= 3 && back <= len; ++back) {
+        unsigned char b = p[len - back];
+        if ((b & 0xC0) != 0x80)
+            return ruUtf8Length(b) > back ? len - back : len;
+    }
+    return len;
+}
+
+/**
+ * @brief Чтение до заполнения буфера или конца входа
+ * @param fd дескриптор
+ * @param data буфер
+ * @param len размер буфера
+ * @return прочитано байтов (меньше len только в конце входа)
+ * @throw system_error при ошибке чтения
+ */
+ 
+static size_t readFull(int fd, char* data, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t r = ::read(fd, data + done, len - done);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            throw system_error(errno, generic_category(), "read");
+        }
+        if (r == 0)
+            break;
+        done += r;
+    }
+    return done;
+}
+
+/**
+ * @brief Запись всего буфера в дескриптор
+ * @param fd дескриптор
+ * @param data буфер
+ * @param len длина
+ * @throw system_error при ошибке записи
+ */
+ 
+static void writeFull(int fd, const char* data, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t r = ::write(fd, data + done, len - done);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            throw system_error(errno, generic_category(), "write");
+        }
+        done += r;
+    }
+}
+
+/**
+ * @brief Цикл одной стадии
+ * @param st счетчики стадии
+ * @param from входная очередь
+ * @param to выходная очередь
+ * @param fromFree входная очередь — свободные блоки (стадия чтения)
+ * @param work обработка блока
+ * @details Стадия завершается после блока с last или когда очередь закрыта
+ * из-за ошибки другой стадии
+ */
+ 
+template <class F>
+static void runStage(stageStats& st, stageRing& from, stageRing& to, bool fromFree, F&& work)
+{
+    size_t queued = 0;
+    stageClock::time_point mark = stageClock::now();
+    for (;;) {
+        if (!fromFree)
+            queued += from.size();
+        stageBlock* b;
+        if (!from.pop(b))
+            return;
+        (fromFree ? st.blocked : st.starved) += lap(mark);
+        work(*b);
+        st.busy += lap(mark);
+        bool last = b->last;
+        if (!to.push(b))
+            return;
+        st.blocked += lap(mark);
+        ++st.blocks;
+        st.queue = double(queued) / st.blocks;
+        if (last)
+            return;
+    }
+}
+
+/**
+ * @brief Стадия с наибольшим временем работы
+ * @return узкое место конвейера
+ */
+ 
+const stageStats& stagedStats::bottleneck() const
+{
+    return *max_element(stages.begin(), stages.end(),
+                        [](const stageStats& a, const stageStats& b) { return a.busy < b.busy; });
+}
+
+/**
+ * @brief Отчет: итоговая строка и строка на каждую стадию
+ * @return многострочный текст без завершающего перевода строки
+ * @details Для каждой стадии печатаются доля времени работы, ожидания
+ * входа и выхода и средняя занятость входной очереди из depth блоков
+ */
+ 
+string stagedStats::report() const
+{
+    char line[256];
+    snprintf(line, sizeof(line),
+             "staged: %.1f MB in, %.1f MB out, %.3f s, %.2f GB/s, depth %u, block %zu KB, bottleneck %s",
+             bytesIn / 1e6, bytesOut / 1e6, seconds, gbPerSec(), depth, block >> 10,
+             stages.empty() ? "-" : bottleneck().name);
+    string out = line;
+    double total = seconds > 0 ? seconds : 1;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const stageStats& s = stages[i];
+        int len = snprintf(line, sizeof(line),
+                           "\n  %-6s %6zu blocks, busy %5.1f%%, wait in %5.1f%%, wait out %5.1f%%",
+                           s.name, s.blocks, 100 * s.busy / total, 100 * s.starved / total,
+                           100 * s.blocked / total);
+        if (i > 0)
+            snprintf(line + len, sizeof(line) - len, ", queue %.1f/%u", s.queue, depth);
+        out += line;
+    }
+    return out;
+}
+
+/**
+ * @brief Конструктор
+ * @param stages разбор и ядро шифра
+ * @param depth количество блоков, одновременно находящихся в конвейере
+ * @param block размер блока чтения, байт
+ */
+ 
+stagedPipeline::stagedPipeline(stageSet stages, unsigned depth, size_t block):
+    stages(std::move(stages)), depth(max(depth, 1u)), block(max<size_t>(block, 4))
+{
+}
+
+/**
+ * @brief Обработка потока
+ * @param in дескриптор входа (файл или канал)
+ * @param out дескриптор выхода
+ * @return статистика прогона
+ * @details Чтение, разбор и шифр работают в своих потоках, запись — в
+ * вызывающем. Чтение обрезает блок по границе символа UTF-8 и переносит
+ * оборванный символ в следующий блок, так что разбор всегда видит целые
+ * символы. Первое исключение стадии закрывает все очереди.
+ * @throw cipher_error если текст невалиден
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+stagedStats stagedPipeline::run(int in, int out)
+{
+    stageClock::time_point t0 = stageClock::now();
+    stageSet set = stages;
+    vector<stageBlock> blocks(depth);
+    stageRing freeRing(depth), decodeRing(depth), kernelRing(depth), writeRing(depth);
+    stageRing* rings[] = {&freeRing, &decodeRing, &kernelRing, &writeRing};
+    for (stageBlock& b : blocks)
+        freeRing.push(&b);
+    
+    stagedStats stats;
+    stats.depth = depth;
+    stats.block = block;
+    stats.stages.resize(4);
+    stats.stages[0].name = "read";
+    stats.stages[1].name = "decode";
+    stats.stages[2].name = "cipher";
+    stats.stages[3].name = "write";
+    
+    mutex errorLock;
+    exception_ptr error;
+    auto guarded = [&](auto&& body) {
+        try {
+            body();
+        } catch (...) {
+            lock_guard<mutex> g(errorLock);
+            if (!error)
+                error = current_exception();
+            for (stageRing* r : rings)
+                r->close();
+        }
+    };
+    
+    string carry;
+    thread reader([&] {
+        guarded([&] {
+            runStage(stats.stages[0], freeRing, decodeRing, true, [&](stageBlock& b) {
+                b.bytes.swap(carry);
+                size_t have = b.bytes.size();
+                b.bytes.resize(have + block);
+                size_t got = readFull(in, &b.bytes[have], block);
+                stats.bytesIn += got;
+                b.last = got < block;
+                size_t cut = b.last ? have + got : utf8Cut(b.bytes.data(), have + got);
+                carry.assign(b.bytes, cut, have + got - cut);
+                b.bytes.resize(cut);
+            });
+        });
+    });
+    thread decoder([&] {
+        guarded([&] {
+            runStage(stats.stages[1], decodeRing, kernelRing, false, [&](stageBlock& b) {
+                b.letters.resize(b.bytes.size());
+                b.letters.resize(set.decode(b.bytes.data(), b.bytes.size(), b.letters.data()));
+            });
+        });
+    });
+    thread kernel([&] {
+        guarded([&] {
+            runStage(stats.stages[2], kernelRing, writeRing, false, [&](stageBlock& b) {
+                set.kernel(b.letters, b.last);
+            });
+        });
+    });
+    guarded([&] {
+        runStage(stats.stages[3], writeRing, freeRing, false, [&](stageBlock& b) {
+            b.bytes.resize(RU_UTF8_LETTER * b.letters.size());
+            ruEncodeUpper(b.letters.data(), b.letters.size(), b.bytes.data());
+            writeFull(out, b.bytes.data(), b.bytes.size());
+            stats.bytesOut += b.bytes.size();
+            b.bytes.clear();
+        });
+    });
+    reader.join();
+    decoder.join();
+    kernel.join();
+    if (error)
+        rethrow_exception(error);
+    chrono::duration<double> spent = stageClock::now() - t0;
+    stats.seconds = spent.count();
+    return stats;
+}
+
+/**
+ * @brief Обработка файла
+ * @param inPath входной файл
+ * @param outPath выходной файл (создается или перезаписывается)
+ * @return статистика прогона
+ * @throw cipher_error если текст невалиден
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+stagedStats stagedPipeline::run(const string& inPath, const string& outPath)
+{
+    checkDistinctFiles(inPath, outPath);
+    int in = open(inPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        throw system_error(errno, generic_category(), "Cannot open " + inPath);
+    int out = open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        close(in);
+        throw system_error(errno, generic_category(), "Cannot create " + outPath);
+    }
+    stagedStats stats;
+    try {
+        stats = run(in, out);
+    } catch (...) {
+        close(in);
+        close(out);
+        unlink(outPath.c_str());
+        throw;
+    }
+    close(in);
+    if (close(out) < 0)
+        throw system_error(errno, generic_category(), "Cannot close " + outPath);
+    return stats;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file stagedPipeline.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Конвейер из отдельных потоков чтения, разбора, шифрования и записи
+ * @details Каждая стадия работает в своем потоке и передает блоки следующей
+ * через ограниченную очередь spscRing. Блоков в обороте depth: запись
+ * возвращает обработанный блок чтению через очередь свободных блоков, поэтому
+ * медленная стадия останавливает все предыдущие и память не растет.
+ * По счетчикам стадий видно, какая из них ограничивает скорость.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ruTranscode.h"
+using namespace std;
+
+/**
+ * @brief Стадии конкретного шифра
+ * @details Набор строится шифром (modAlphaCipher::stages, Table::stages)
+ * и может хранить состояние между блоками (позицию в ключе, неполный кадр).
+ * Конвейер копирует набор на каждый прогон, поэтому состояние исходного
+ * набора не меняется.
+ */
+struct stageSet {
+    /// Разбор и проверка блока UTF-8, обрезанного по границе символа: текст, длина, номера букв (len элементов); результат — количество букв
+    function<size_t(const char* data, size_t len, uint8_t* out)> decode;
+    
+    /// Ядро шифра над номерами букв блока; может менять их количество, last — последний блок
+    function<void(letterBuffer& letters, bool last)> kernel;
+};
+
+/**
+ * @brief Счетчики одной стадии
+ */
+struct stageStats {
+    const char* name = ""; ///< Название стадии
+    size_t blocks = 0; ///< Обработано блоков
+    double busy = 0; ///< Время работы над блоками, с
+    double starved = 0; ///< Ожидание блока от предыдущей стадии, с
+    double blocked = 0; ///< Ожидание места в очереди следующей стадии (у чтения — свободного блока), с
+    double queue = 0; ///< Средняя занятость входной очереди при взятии блока
+};
+
+/**
+ * @brief Итоги прогона конвейера
+ */
+struct stagedStats {
+    vector<stageStats> stages; ///< Стадии по порядку: чтение, разбор, шифр, запись
+    unsigned depth = 0; ///< Количество блоков в обороте
+    size_t block = 0; ///< Размер блока чтения, байт
+    size_t bytesIn = 0; ///< Прочитано, байт
+    size_t bytesOut = 0; ///< Записано, байт
+    double seconds = 0; ///< Время прогона, с
+    
+    /**
+     * @brief Достигнутая пропускная способность по входу
+     * @return ГБ/с
+     */
+    double gbPerSec() const { return seconds > 0 ? bytesIn / seconds / 1e9 : 0; }
+    
+    /**
+     * @brief Узкое место
+     * @return стадия с наибольшим временем работы
+     */
+    const stageStats& bottleneck() const;
+    
+    /**
+     * @brief Отчет: итоговая строка и строка на каждую стадию
+     * @return многострочный текст без завершающего перевода строки
+     */
+    string report() const;
+};
+
+/**
+ * @brief Конвейер чтение — разбор — шифр — запись в отдельных потоках
+ */
+class stagedPipeline
+{
+public:
+    /// Количество блоков в обороте по умолчанию
+    static const unsigned DEPTH = 8;
+    
+    /// Размер блока чтения по умолчанию, байт
+    static const size_t BLOCK = size_t(1) << 20;
+    
+private:
+    stageSet stages; ///< Разбор и ядро шифра
+    unsigned depth; ///< Количество блоков в обороте (и емкость очередей)
+    size_t block; ///< Размер блока чтения, байт
+    
+public:
+    /**
+     * @brief Конструктор
+     * @param stages разбор и ядро шифра
+     * @param depth количество блоков, одновременно находящихся в конвейере
+     * @param block размер блока чтения, байт
+     */
+    stagedPipeline(stageSet stages, unsigned depth = DEPTH, size_t block = BLOCK);
+    
+    /**
+     * @brief Обработка потока
+     * @param in дескриптор входа (файл или канал)
+     * @param out дескриптор выхода
+     * @return статистика прогона
+     * @details Первое исключение любой стадии закрывает все очереди,
+     * остальные стадии останавливаются, исключение передается вызывающему.
+     * Дескрипторы не закрываются.
+     * @throw cipher_error если текст невалиден
+     * @throw system_error при ошибке ввода-вывода
+     */
+    stagedStats run(int in, int out);
+    
+    /**
+     * @brief Обработка файла
+     * @param inPath входной файл
+     * @param outPath выходной файл (создается или перезаписывается)
+     * @return статистика прогона
+     * @details При ошибке выходной файл удаляется. Выход, совпадающий
+     * со входом, отвергается до открытия файлов
+     * @throw cipher_error если текст невалиден
+     * @throw system_error при ошибке ввода-вывода
+     */
+    stagedStats run(const string& inPath, const string& outPath);
+};
@@ -0,0 +1,42 @@
+/**
+ * @file textBatch.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Результат пакетного шифрования: один буфер и таблица смещений
+ */
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+/**
+ * @brief Пакет текстов в одном непрерывном буфере
+ * @details Текст с номером i занимает text[offsets[i] .. offsets[i + 1])
+ */
+struct textBatch {
+    wstring text; ///< Все тексты пакета подряд
+    vector<size_t> offsets; ///< Смещения начала текстов, последнее — конец буфера
+    
+    /**
+     * @brief Количество текстов в пакете
+     * @return число текстов
+     */
+    size_t size() const
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+    
+    /**
+     * @brief Текст пакета по номеру
+     * @param i номер текста
+     * @return представление текста внутри общего буфера
+     */
+    wstring_view operator[](size_t i) const
+    {
+        return wstring_view(text).substr(offsets[i], offsets[i + 1] - offsets[i]);
+    }
+};
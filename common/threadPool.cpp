@@ -0,0 +1,113 @@
+/**
+ * @file threadPool.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация пула потоков
+ */
+
+#include "threadPool.h"
+#include <exception>
+using namespace std;
+
+/**
+ * @brief Конструктор пула
+ * @param threads количество потоков, 0 — по числу ядер
+ */
+ 
+threadPool::threadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(&threadPool::work, this);
+    }
+}
+
+/**
+ * @brief Деструктор: дожидается завершения задач в очереди
+ */
+ 
+threadPool::~threadPool()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+/**
+ * @brief Цикл рабочего потока
+ */
+ 
+void threadPool::work()
+{
+    for (;;) {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            ready.wait(guard, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+/**
+ * @brief Постановка задачи в очередь
+ * @param task задача
+ */
+ 
+void threadPool::submit(function<void()> task)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        tasks.push(move(task));
+    }
+    ready.notify_one();
+}
+
+/**
+ * @brief Параллельный запуск fn(0) .. fn(count-1) с ожиданием завершения
+ * @param count количество задач
+ * @param fn задача, получает свой номер
+ * @details Исключения задач собираются, и повторно выбрасывается исключение
+ * задачи с наименьшим номером, чтобы результат не зависел от планирования
+ */
+ 
+void threadPool::parallelFor(size_t count, const function<void(size_t)>& fn)
+{
+    mutex doneLock;
+    condition_variable done;
+    size_t left = count;
+    vector<exception_ptr> errors(count);
+    
+    for (size_t i = 0; i < count; ++i) {
+        submit([&, i] {
+            try {
+                fn(i);
+            } catch (...) {
+                errors[i] = current_exception();
+            }
+            lock_guard<mutex> guard(doneLock);
+            if (--left == 0)
+                done.notify_one();
+        });
+    }
+    
+    unique_lock<mutex> guard(doneLock);
+    done.wait(guard, [&] { return left == 0; });
+    for (auto& e : errors) {
+        if (e)
+            rethrow_exception(e);
+    }
+}
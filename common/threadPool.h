@@ -0,0 +1,76 @@
+/**
+ * @file threadPool.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Пул потоков для параллельной обработки больших текстов
+ * @details Потоки создаются один раз и переиспользуются между вызовами,
+ * поэтому один пул можно разделять между несколькими шифрами.
+ * Классы подключают пул методом setParallel, который не синхронизирован
+ * с их константными методами: пул подключается до того, как экземпляр
+ * станет доступен другим потокам, и дальше не меняется.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * @brief Пул потоков фиксированного размера
+ */
+class threadPool
+{
+private:
+    vector<thread> workers; ///< Рабочие потоки
+    queue<function<void()>> tasks; ///< Очередь задач
+    mutex lock; ///< Защита очереди
+    condition_variable ready; ///< Сигнал о новой задаче или остановке
+    bool stopping = false; ///< Пул останавливается
+    
+    /**
+     * @brief Цикл рабочего потока
+     */
+    void work();
+    
+public:
+    /**
+     * @brief Конструктор пула
+     * @param threads количество потоков, 0 — по числу ядер
+     */
+    explicit threadPool(unsigned threads = 0);
+    
+    /**
+     * @brief Деструктор: дожидается завершения задач в очереди
+     */
+    ~threadPool();
+    
+    threadPool(const threadPool&) = delete;
+    threadPool& operator=(const threadPool&) = delete;
+    
+    /**
+     * @brief Количество потоков пула
+     * @return число рабочих потоков
+     */
+    unsigned size() const { return workers.size(); }
+    
+    /**
+     * @brief Постановка задачи в очередь
+     * @param task задача
+     */
+    void submit(function<void()> task);
+    
+    /**
+     * @brief Параллельный запуск fn(0) .. fn(count-1) с ожиданием завершения
+     * @param count количество задач
+     * @param fn задача, получает свой номер
+     * @throw исключение задачи с наименьшим номером, если задачи завершились с ошибкой
+     * @warning Нельзя вызывать из задачи этого же пула
+     */
+    void parallelFor(size_t count, const function<void(size_t)>& fn);
+};
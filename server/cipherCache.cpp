@@ -0,0 +1,136 @@
+/**
+ * @file cipherCache.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация кэша шифров
+ */
+
+#include "cipherCache.h"
+#include "cipherProtocol.h"
+#include <charconv>
+#include <codecvt>
+#include <locale>
+using namespace std;
+
+/**
+ * @brief Конструктор
+ * @param capacity наибольшее количество шифров, 0 — без кэширования
+ */
+ 
+cipherCache::cipherCache(size_t capacity):
+    capacity(capacity)
+{
+}
+
+/**
+ * @brief Поиск или построение шифра
+ * @param kind шифр (cipherKind)
+ * @param key ключ в UTF-8
+ * @return запись с построенным шифром
+ * @throw cipher_error если ключ невалиден (в кэш не попадает)
+ */
+ 
+cipherCache::entry cipherCache::lookup(uint8_t kind, string_view key)
+{
+    string name(1, char(kind));
+    name.append(key);
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = index.find(name);
+        if (it != index.end()) {
+            order.splice(order.begin(), order, it->second);
+            ++hitCount;
+            return it->second->second;
+        }
+        ++missCount;
+    }
+    
+    entry built;
+    if (kind == KIND_GRONSFELD) {
+        wstring wide;
+        try {
+            wstring_convert<codecvt_utf8<wchar_t>> conv;
+            wide = conv.from_bytes(key.data(), key.data() + key.size());
+        } catch (const range_error&) {
+            throw cipher_error("Invalid key");
+        }
+        built.gronsfeld = make_shared<const modAlphaCipher>(wide);
+    } else {
+        int cols = 0;
+        auto [end, ec] = from_chars(key.data(), key.data() + key.size(), cols);
+        if (key.empty() || ec != errc() || end != key.data() + key.size())
+            throw cipher_error("Invalid key");
+        built.table = make_shared<const Table>(cols);
+    }
+    if (capacity == 0)
+        return built;
+    lock_guard<mutex> guard(lock);
+    auto it = index.find(name);
+    if (it != index.end())
+        return it->second->second;
+    order.emplace_front(name, built);
+    index.emplace(move(name), order.begin());
+    if (order.size() > capacity) {
+        index.erase(order.back().first);
+        order.pop_back();
+    }
+    return built;
+}
+
+/**
+ * @brief Шифр Гронсфельда по ключу
+ * @param key ключ в UTF-8
+ * @return разделяемый шифр
+ * @throw cipher_error если ключ невалиден
+ */
+ 
+shared_ptr<const modAlphaCipher> cipherCache::gronsfeld(string_view key)
+{
+    return lookup(KIND_GRONSFELD, key).gronsfeld;
+}
+
+/**
+ * @brief Табличная перестановка по ключу
+ * @param key количество столбцов десятичными цифрами
+ * @return разделяемый шифр
+ * @throw cipher_error если ключ невалиден
+ */
+ 
+shared_ptr<const Table> cipherCache::table(string_view key)
+{
+    return lookup(KIND_TABLE, key).table;
+}
+
+/**
+ * @brief Количество попаданий
+ * @return число запросов, для которых шифр найден в кэше
+ */
+ 
+size_t cipherCache::hits() const
+{
+    lock_guard<mutex> guard(lock);
+    return hitCount;
+}
+
+/**
+ * @brief Количество промахов
+ * @return число построенных шифров
+ */
+ 
+size_t cipherCache::misses() const
+{
+    lock_guard<mutex> guard(lock);
+    return missCount;
+}
+
+/**
+ * @brief Количество шифров в кэше
+ * @return не больше емкости
+ */
+ 
+size_t cipherCache::size() const
+{
+    lock_guard<mutex> guard(lock);
+    return order.size();
+}
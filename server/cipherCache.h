@@ -0,0 +1,103 @@
+/**
+ * @file cipherCache.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Кэш построенных шифров по ключу
+ * @details Конструктор шифра проверяет ключ и строит таблицы сдвигов,
+ * поэтому сервер строит шифр один раз на ключ и затем разделяет его между
+ * рабочими потоками: константные методы обоих шифров потокобезопасны.
+ * Вытесняется шифр, к которому дольше всего не обращались.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "modAlphaCipher.h"
+#include "table.h"
+using namespace std;
+
+/**
+ * @brief Потокобезопасный LRU-кэш шифров
+ */
+class cipherCache
+{
+private:
+    /**
+     * @brief Построенный шифр, заполнен один из указателей
+     */
+    struct entry {
+        shared_ptr<const modAlphaCipher> gronsfeld; ///< Шифр Гронсфельда
+        shared_ptr<const Table> table; ///< Табличная перестановка
+    };
+    using lruList = list<pair<string, entry>>;
+    
+    size_t capacity; ///< Наибольшее количество шифров
+    lruList order; ///< Шифры от недавних к давним
+    unordered_map<string, lruList::iterator> index; ///< Поиск по шифру и ключу
+    mutable mutex lock; ///< Защита списка и индекса
+    size_t hitCount = 0; ///< Найдено в кэше
+    size_t missCount = 0; ///< Построено заново
+    
+    /**
+     * @brief Поиск или построение шифра
+     * @param kind шифр (cipherKind)
+     * @param key ключ в UTF-8
+     * @return запись с построенным шифром
+     * @details Шифр строится вне блокировки, чтобы промахи разных потоков
+     * не ждали друг друга; если два потока построили один ключ, в кэше
+     * остается первый
+     * @throw cipher_error если ключ невалиден (в кэш не попадает)
+     */
+    entry lookup(uint8_t kind, string_view key);
+    
+public:
+    /// Емкость по умолчанию
+    static const size_t DEFAULT_CAPACITY = 1024;
+    
+    /**
+     * @brief Конструктор
+     * @param capacity наибольшее количество шифров, 0 — без кэширования
+     */
+    explicit cipherCache(size_t capacity = DEFAULT_CAPACITY);
+    
+    /**
+     * @brief Шифр Гронсфельда по ключу
+     * @param key ключ в UTF-8
+     * @return разделяемый шифр
+     * @throw cipher_error если ключ невалиден
+     */
+    shared_ptr<const modAlphaCipher> gronsfeld(string_view key);
+    
+    /**
+     * @brief Табличная перестановка по ключу
+     * @param key количество столбцов десятичными цифрами
+     * @return разделяемый шифр
+     * @throw cipher_error если ключ невалиден
+     */
+    shared_ptr<const Table> table(string_view key);
+    
+    /**
+     * @brief Количество попаданий
+     * @return число запросов, для которых шифр найден в кэше
+     */
+    size_t hits() const;
+    
+    /**
+     * @brief Количество промахов
+     * @return число построенных шифров
+     */
+    size_t misses() const;
+    
+    /**
+     * @brief Количество шифров в кэше
+     * @return не больше емкости
+     */
+    size_t size() const;
+};
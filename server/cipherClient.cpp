@@ -0,0 +1,138 @@
+/**
+ * @file cipherClient.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация блокирующего клиента сервера шифрования
+ */
+
+#include "cipherClient.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+/// Размер одного чтения из сокета
+static const size_t READ_CHUNK = 64 * 1024;
+
+/**
+ * @brief Подключение к Unix-сокету
+ * @param unixPath путь сокета
+ * @throw system_error если подключиться не удалось
+ */
+ 
+cipherClient::cipherClient(const string& unixPath)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (unixPath.size() >= sizeof(addr.sun_path))
+        throw system_error(ENAMETOOLONG, generic_category(), "connect " + unixPath);
+    memcpy(addr.sun_path, unixPath.c_str(), unixPath.size() + 1);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int err = errno;
+        if (fd >= 0)
+            close(fd);
+        throw system_error(err, generic_category(), "connect " + unixPath);
+    }
+}
+
+/**
+ * @brief Подключение к порту TCP на 127.0.0.1
+ * @param port порт
+ * @throw system_error если подключиться не удалось
+ */
+ 
+cipherClient::cipherClient(uint16_t port)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int err = errno;
+        if (fd >= 0)
+            close(fd);
+        throw system_error(err, generic_category(), "connect 127.0.0.1:" + to_string(port));
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/**
+ * @brief Деструктор: закрывает соединение
+ */
+ 
+cipherClient::~cipherClient()
+{
+    close(fd);
+}
+
+/**
+ * @brief Отправка кадров целиком
+ * @param frames один или несколько кадров запросов
+ * @throw system_error при ошибке записи
+ */
+ 
+void cipherClient::send(string_view frames)
+{
+    size_t done = 0;
+    while (done < frames.size()) {
+        ssize_t r = ::send(fd, frames.data() + done, frames.size() - done, MSG_NOSIGNAL);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            throw system_error(errno, generic_category(), "send");
+        }
+        done += r;
+    }
+}
+
+/**
+ * @brief Прием следующего ответа
+ * @param resp ответ; тело действительно до следующего вызова
+ * @return false если сервер закрыл соединение
+ * @throw system_error при ошибке чтения
+ * @throw length_error если кадр длиннее FRAME_MAX
+ */
+ 
+bool cipherClient::receive(cipherResponse& resp)
+{
+    for (;;) {
+        size_t len = frameLength(string_view(in).substr(consumed));
+        if (len != 0) {
+            parseResponse(string_view(in).substr(consumed, len), resp);
+            consumed += len;
+            return true;
+        }
+        // Разобранное начало отбрасывается только здесь, при следующем
+        // вызове, поэтому тело ответа действительно до него
+        in.erase(0, consumed);
+        consumed = 0;
+        size_t old = in.size();
+        in.resize(old + READ_CHUNK);
+        ssize_t r = read(fd, in.data() + old, READ_CHUNK);
+        in.resize(old + max<ssize_t>(r, 0));
+        if (r == 0)
+            return false;
+        if (r < 0 && errno != EINTR)
+            throw system_error(errno, generic_category(), "read");
+    }
+}
+
+/**
+ * @brief Закрытие передачи: сервер допишет ответы и закроет соединение
+ */
+ 
+void cipherClient::finish()
+{
+    shutdown(fd, SHUT_WR);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file cipherClient.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Блокирующий клиент сервера шифрования
+ * @details Используется генератором нагрузки и тестами. Запросы
+ * отправляются пачками без ожидания ответов, ответы читаются по одному.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "cipherProtocol.h"
+using namespace std;
+
+/**
+ * @brief Соединение с сервером шифрования
+ */
+class cipherClient
+{
+private:
+    int fd = -1; ///< Сокет
+    string in; ///< Принятые байты
+    size_t consumed = 0; ///< Разобрано байтов из in
+    
+public:
+    /**
+     * @brief Подключение к Unix-сокету
+     * @param unixPath путь сокета
+     * @throw system_error если подключиться не удалось
+     */
+    explicit cipherClient(const string& unixPath);
+    
+    /**
+     * @brief Подключение к порту TCP на 127.0.0.1
+     * @param port порт
+     * @throw system_error если подключиться не удалось
+     */
+    explicit cipherClient(uint16_t port);
+    
+    /**
+     * @brief Деструктор: закрывает соединение
+     */
+    ~cipherClient();
+    
+    cipherClient(const cipherClient&) = delete;
+    cipherClient& operator=(const cipherClient&) = delete;
+    
+    /**
+     * @brief Отправка кадров целиком
+     * @param frames один или несколько кадров запросов
+     * @throw system_error при ошибке записи
+     */
+    void send(string_view frames);
+    
+    /**
+     * @brief Прием следующего ответа
+     * @param resp ответ; тело действительно до следующего вызова
+     * @return false если сервер закрыл соединение
+     * @throw system_error при ошибке чтения
+     * @throw length_error если кадр длиннее FRAME_MAX
+     */
+    bool receive(cipherResponse& resp);
+    
+    /**
+     * @brief Закрытие передачи: сервер допишет ответы и закроет соединение
+     */
+    void finish();
+};
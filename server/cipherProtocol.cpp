@@ -0,0 +1,139 @@
+/**
+ * @file cipherProtocol.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация кадров протокола сервера шифрования
+ */
+
+#include "cipherProtocol.h"
+#include <stdexcept>
+using namespace std;
+
+/// Заголовок запроса после поля длины: номер, операция, шифр, длина ключа
+static const size_t REQUEST_HEADER = 8;
+/// Заголовок ответа после поля длины: номер и итог
+static const size_t RESPONSE_HEADER = 5;
+
+/**
+ * @brief Добавление целого little-endian
+ * @param out буфер
+ * @param v значение
+ * @param bytes количество байтов
+ */
+ 
+static void appendLe(string& out, uint32_t v, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i)
+        out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+/**
+ * @brief Чтение целого little-endian
+ * @param p начало
+ * @param bytes количество байтов
+ * @return значение
+ */
+ 
+static uint32_t getLe(const char* p, size_t bytes)
+{
+    uint32_t v = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        v |= uint32_t(uint8_t(p[i])) << (8 * i);
+    return v;
+}
+
+/**
+ * @brief Длина первого полного кадра в буфере
+ * @param buf принятые байты
+ * @return длина кадра вместе с полем длины, 0 если кадр еще не принят целиком
+ * @throw length_error если заявленная длина больше FRAME_MAX
+ */
+ 
+size_t frameLength(string_view buf)
+{
+    if (buf.size() < FRAME_PREFIX)
+        return 0;
+    size_t len = getLe(buf.data(), FRAME_PREFIX);
+    if (len > FRAME_MAX)
+        throw length_error("Frame too long");
+    return buf.size() - FRAME_PREFIX >= len ? FRAME_PREFIX + len : 0;
+}
+
+/**
+ * @brief Добавление кадра запроса в буфер отправки
+ * @param out буфер
+ * @param req запрос
+ * @throw length_error если ключ длиннее 65535 байт или кадр больше FRAME_MAX
+ */
+ 
+void appendRequest(string& out, const cipherRequest& req)
+{
+    size_t len = REQUEST_HEADER + req.key.size() + req.text.size();
+    if (req.key.size() > 0xFFFF || len > FRAME_MAX)
+        throw length_error("Frame too long");
+    appendLe(out, len, FRAME_PREFIX);
+    appendLe(out, req.id, 4);
+    out.push_back(static_cast<char>(req.op));
+    out.push_back(static_cast<char>(req.kind));
+    appendLe(out, req.key.size(), 2);
+    out.append(req.key);
+    out.append(req.text);
+}
+
+/**
+ * @brief Добавление кадра ответа в буфер отправки
+ * @param out буфер
+ * @param id номер запроса
+ * @param status итог
+ * @param body результат или сообщение об ошибке
+ */
+ 
+void appendResponse(string& out, uint32_t id, uint8_t status, string_view body)
+{
+    appendLe(out, RESPONSE_HEADER + body.size(), FRAME_PREFIX);
+    appendLe(out, id, 4);
+    out.push_back(static_cast<char>(status));
+    out.append(body);
+}
+
+/**
+ * @brief Разбор кадра запроса
+ * @param frame кадр вместе с полем длины
+ * @param req результат разбора
+ * @return false если кадр короче заголовка или ключ выходит за кадр
+ */
+ 
+bool parseRequest(string_view frame, cipherRequest& req)
+{
+    if (frame.size() < FRAME_PREFIX + REQUEST_HEADER)
+        return false;
+    const char* p = frame.data() + FRAME_PREFIX;
+    size_t keyLen = getLe(p + 6, 2);
+    if (frame.size() - FRAME_PREFIX - REQUEST_HEADER < keyLen)
+        return false;
+    req.id = getLe(p, 4);
+    req.op = uint8_t(p[4]);
+    req.kind = uint8_t(p[5]);
+    req.key = frame.substr(FRAME_PREFIX + REQUEST_HEADER, keyLen);
+    req.text = frame.substr(FRAME_PREFIX + REQUEST_HEADER + keyLen);
+    return true;
+}
+
+/**
+ * @brief Разбор кадра ответа
+ * @param frame кадр вместе с полем длины
+ * @param resp результат разбора
+ * @return false если кадр короче заголовка
+ */
+ 
+bool parseResponse(string_view frame, cipherResponse& resp)
+{
+    if (frame.size() < FRAME_PREFIX + RESPONSE_HEADER)
+        return false;
+    const char* p = frame.data() + FRAME_PREFIX;
+    resp.id = getLe(p, 4);
+    resp.status = uint8_t(p[4]);
+    resp.body = frame.substr(FRAME_PREFIX + RESPONSE_HEADER);
+    return true;
+}
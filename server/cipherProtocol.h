@@ -0,0 +1,114 @@
+/**
+ * @file cipherProtocol.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Двоичный протокол сервера шифрования
+ * @details Каждый кадр начинается с длины остатка кадра (4 байта, little
+ * endian). Запрос: номер (4 байта), операция (1 байт), шифр (1 байт),
+ * длина ключа (2 байта), ключ в UTF-8 и текст в UTF-8 до конца кадра.
+ * Ответ: номер запроса, итог (1 байт) и результат или сообщение об ошибке.
+ * Клиент может отправить сколько угодно запросов, не дожидаясь ответов;
+ * ответы приходят в порядке готовности и сопоставляются по номеру.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+using namespace std;
+
+/// Размер поля длины кадра
+const size_t FRAME_PREFIX = 4;
+/// Наибольшая длина кадра без поля длины; кадр длиннее закрывает соединение
+const size_t FRAME_MAX = size_t(64) << 20;
+
+/**
+ * @brief Операция запроса
+ */
+enum cipherOp : uint8_t {
+    OP_ENCRYPT = 0, ///< Шифрование
+    OP_DECRYPT = 1  ///< Расшифрование
+};
+
+/**
+ * @brief Шифр запроса
+ */
+enum cipherKind : uint8_t {
+    KIND_GRONSFELD = 0, ///< Шифр Гронсфельда, ключ — русские буквы
+    KIND_TABLE = 1      ///< Табличная перестановка, ключ — число столбцов
+};
+
+/**
+ * @brief Итог обработки запроса
+ */
+enum cipherStatus : uint8_t {
+    STATUS_OK = 0,          ///< Успех, в ответе результат
+    STATUS_CIPHER_ERROR = 1, ///< cipher_error шифра, в ответе сообщение
+    STATUS_BAD_REQUEST = 2, ///< Неизвестная операция или шифр, в ответе сообщение
+    STATUS_INTERNAL_ERROR = 3 ///< Другая ошибка сервера (например, нехватка памяти)
+};
+
+/**
+ * @brief Разобранный запрос
+ * @details Ключ и текст ссылаются на буфер кадра
+ */
+struct cipherRequest {
+    uint32_t id = 0; ///< Номер запроса, возвращается в ответе
+    uint8_t op = OP_ENCRYPT; ///< Операция
+    uint8_t kind = KIND_GRONSFELD; ///< Шифр
+    string_view key; ///< Ключ в UTF-8
+    string_view text; ///< Текст в UTF-8
+};
+
+/**
+ * @brief Разобранный ответ
+ * @details Тело ссылается на буфер кадра
+ */
+struct cipherResponse {
+    uint32_t id = 0; ///< Номер запроса
+    uint8_t status = STATUS_OK; ///< Итог
+    string_view body; ///< Результат или сообщение об ошибке
+};
+
+/**
+ * @brief Длина первого полного кадра в буфере
+ * @param buf принятые байты
+ * @return длина кадра вместе с полем длины, 0 если кадр еще не принят целиком
+ * @throw length_error если заявленная длина больше FRAME_MAX
+ */
+size_t frameLength(string_view buf);
+
+/**
+ * @brief Добавление кадра запроса в буфер отправки
+ * @param out буфер
+ * @param req запрос
+ * @throw length_error если ключ длиннее 65535 байт или кадр больше FRAME_MAX
+ */
+void appendRequest(string& out, const cipherRequest& req);
+
+/**
+ * @brief Добавление кадра ответа в буфер отправки
+ * @param out буфер
+ * @param id номер запроса
+ * @param status итог
+ * @param body результат или сообщение об ошибке
+ */
+void appendResponse(string& out, uint32_t id, uint8_t status, string_view body);
+
+/**
+ * @brief Разбор кадра запроса
+ * @param frame кадр вместе с полем длины
+ * @param req результат разбора
+ * @return false если кадр короче заголовка или ключ выходит за кадр
+ */
+bool parseRequest(string_view frame, cipherRequest& req);
+
+/**
+ * @brief Разбор кадра ответа
+ * @param frame кадр вместе с полем длины
+ * @param resp результат разбора
+ * @return false если кадр короче заголовка
+ */
+bool parseResponse(string_view frame, cipherResponse& resp);
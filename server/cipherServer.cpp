@@ -0,0 +1,439 @@
+/**
+ * @file cipherServer.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация сервера шифрования на epoll
+ */
+
+#include "cipherServer.h"
+#include "cipherProtocol.h"
+#include "../common/threadPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+/// Размер одного чтения из сокета
+static const size_t READ_CHUNK = 64 * 1024;
+
+/**
+ * @brief Исключение с кодом errno
+ * @param what операция
+ * @throw system_error всегда
+ */
+ 
+[[noreturn]] static void fail(const char* what)
+{
+    throw system_error(errno, generic_category(), what);
+}
+
+/**
+ * @brief Регистрация дескриптора в epoll
+ * @param epollFd экземпляр epoll
+ * @param op EPOLL_CTL_ADD, EPOLL_CTL_MOD или EPOLL_CTL_DEL
+ * @param fd дескриптор
+ * @param events интерес
+ * @param tag метка события
+ * @throw system_error при ошибке epoll_ctl
+ */
+ 
+static void control(int epollFd, int op, int fd, uint32_t events, uint64_t tag)
+{
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = tag;
+    if (epoll_ctl(epollFd, op, fd, &ev) != 0)
+        fail("epoll_ctl");
+}
+
+/**
+ * @brief Конструктор: создает и привязывает слушающий сокет
+ * @param cfg параметры
+ * @throw system_error если сокет не удалось создать или привязать
+ */
+ 
+cipherServer::cipherServer(const serverConfig& cfg):
+    config(cfg), cache(cfg.cacheSize)
+{
+    if (config.maxInFlight == 0)
+        config.maxInFlight = 1;
+    try {
+        if (!config.unixPath.empty()) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            if (config.unixPath.size() >= sizeof(addr.sun_path))
+                throw system_error(ENAMETOOLONG, generic_category(), "bind " + config.unixPath);
+            memcpy(addr.sun_path, config.unixPath.c_str(), config.unixPath.size() + 1);
+            listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listenFd < 0)
+                fail("socket");
+            // Сокет, оставшийся от прошлого запуска, мешает bind
+            unlink(config.unixPath.c_str());
+            if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+                fail("bind");
+        } else {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(config.port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listenFd < 0)
+                fail("socket");
+            int one = 1;
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+                fail("bind");
+            socklen_t len = sizeof(addr);
+            if (getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+                fail("getsockname");
+            boundPort = ntohs(addr.sin_port);
+        }
+        if (listen(listenFd, SOMAXCONN) != 0)
+            fail("listen");
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0)
+            fail("epoll_create1");
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0)
+            fail("eventfd");
+        control(epollFd, EPOLL_CTL_ADD, listenFd, EPOLLIN, LISTEN_TAG);
+        control(epollFd, EPOLL_CTL_ADD, wakeFd, EPOLLIN, WAKE_TAG);
+        pool = make_unique<threadPool>(config.threads);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+/**
+ * @brief Деструктор: дожидается запросов на пуле и закрывает соединения
+ */
+ 
+cipherServer::~cipherServer()
+{
+    // Задачи пула пишут в wakeFd, поэтому пул останавливается первым
+    pool.reset();
+    release();
+}
+
+/**
+ * @brief Закрытие всех дескрипторов
+ */
+ 
+void cipherServer::release()
+{
+    for (auto& [serial, c] : conns)
+        close(c.fd);
+    conns.clear();
+    for (int* fd : {&listenFd, &epollFd, &wakeFd}) {
+        if (*fd >= 0)
+            close(*fd);
+        *fd = -1;
+    }
+    if (!config.unixPath.empty())
+        unlink(config.unixPath.c_str());
+}
+
+/**
+ * @brief Остановка цикла; безопасна в обработчике сигнала
+ */
+ 
+void cipherServer::stop()
+{
+    stopping = true;
+    uint64_t one = 1;
+    ssize_t r = write(wakeFd, &one, sizeof(one));
+    (void)r;
+}
+
+/**
+ * @brief Текущие счетчики
+ * @return число соединений, запросов, ошибок и обращений к кэшу
+ */
+ 
+serverStats cipherServer::stats() const
+{
+    serverStats s;
+    s.connections = connectionCount;
+    s.requests = requestCount;
+    s.errors = errorCount;
+    s.cacheHits = cache.hits();
+    s.cacheMisses = cache.misses();
+    return s;
+}
+
+/**
+ * @brief Цикл обработки событий до вызова stop()
+ * @details Уровневые уведомления: за событие читается не больше READ_CHUNK
+ * байтов, так что одно соединение не задерживает остальные
+ * @throw system_error при ошибке epoll
+ */
+ 
+void cipherServer::run()
+{
+    epoll_event events[64];
+    while (!stopping) {
+        int n = epoll_wait(epollFd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fail("epoll_wait");
+        }
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                acceptAll();
+            } else if (tag == WAKE_TAG) {
+                uint64_t count;
+                while (read(wakeFd, &count, sizeof(count)) > 0) {
+                }
+                collect();
+            } else {
+                auto it = conns.find(tag);
+                if (it == conns.end())
+                    continue;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    readFrom(it->second);
+                if (events[i].events & EPOLLOUT)
+                    writeTo(it->second);
+                update(tag);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Прием всех ожидающих соединений
+ */
+ 
+void cipherServer::acceptAll()
+{
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        if (config.unixPath.empty()) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        uint64_t serial = nextSerial++;
+        connection& c = conns[serial];
+        c.fd = fd;
+        c.events = EPOLLIN;
+        control(epollFd, EPOLL_CTL_ADD, fd, c.events, serial);
+        ++connectionCount;
+    }
+}
+
+/**
+ * @brief Чтение из сокета
+ * @param c соединение
+ */
+ 
+void cipherServer::readFrom(connection& c)
+{
+    if (c.peerClosed || c.broken)
+        return;
+    size_t old = c.in.size();
+    c.in.resize(old + READ_CHUNK);
+    ssize_t r = read(c.fd, c.in.data() + old, READ_CHUNK);
+    c.in.resize(old + max<ssize_t>(r, 0));
+    if (r == 0)
+        c.peerClosed = true;
+    else if (r < 0 && errno != EAGAIN && errno != EINTR)
+        c.broken = true;
+}
+
+/**
+ * @brief Передача принятых кадров на пул, пока не достигнут maxInFlight
+ * @param c соединение
+ * @param serial номер соединения
+ */
+ 
+void cipherServer::dispatch(connection& c, uint64_t serial)
+{
+    size_t pos = 0;
+    while (!c.broken && c.inFlight < config.maxInFlight) {
+        size_t len;
+        try {
+            len = frameLength(string_view(c.in).substr(pos));
+        } catch (const length_error&) {
+            c.broken = true;
+            break;
+        }
+        if (len == 0)
+            break;
+        ++c.inFlight;
+        pool->submit([this, serial, frame = c.in.substr(pos, len)] {
+            string reply = process(frame);
+            bool wake;
+            {
+                lock_guard<mutex> guard(doneLock);
+                wake = done.empty();
+                done.emplace_back(serial, move(reply));
+            }
+            if (wake) {
+                uint64_t one = 1;
+                ssize_t r = write(wakeFd, &one, sizeof(one));
+                (void)r;
+            }
+        });
+        pos += len;
+    }
+    c.in.erase(0, pos);
+}
+
+/**
+ * @brief Отправка накопленных ответов
+ * @param c соединение
+ */
+ 
+void cipherServer::writeTo(connection& c)
+{
+    while (!c.broken && c.sent < c.out.size()) {
+        ssize_t r = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                c.broken = true;
+            break;
+        }
+        c.sent += r;
+    }
+    if (c.sent == c.out.size()) {
+        c.out.clear();
+        c.sent = 0;
+    } else if (c.sent > c.out.size() / 2) {
+        c.out.erase(0, c.sent);
+        c.sent = 0;
+    }
+}
+
+/**
+ * @brief Перенос готовых ответов в соединения
+ * @details Ответы одного соединения склеиваются и отправляются одним
+ * вызовом send
+ */
+ 
+void cipherServer::collect()
+{
+    vector<pair<uint64_t, string>> ready;
+    {
+        lock_guard<mutex> guard(doneLock);
+        ready.swap(done);
+    }
+    vector<uint64_t> touched;
+    for (auto& [serial, reply] : ready) {
+        auto it = conns.find(serial);
+        if (it == conns.end())
+            continue;
+        it->second.out += reply;
+        --it->second.inFlight;
+        touched.push_back(serial);
+    }
+    sort(touched.begin(), touched.end());
+    touched.erase(unique(touched.begin(), touched.end()), touched.end());
+    for (uint64_t serial : touched) {
+        writeTo(conns[serial]);
+        // Соединение, упершееся в maxInFlight, продолжает разбор принятых кадров
+        update(serial);
+    }
+}
+
+/**
+ * @brief Обновление интереса в epoll или закрытие соединения
+ * @param serial номер соединения
+ * @details Соединение закрывается при ошибке или когда клиент закрыл
+ * передачу и все ответы отправлены. Пока неотправленных ответов больше
+ * maxPendingOutput, новые кадры не разбираются и EPOLLIN снят; интерес
+ * восстанавливается, когда EPOLLOUT отправит накопленное. Сокет без
+ * интереса снимается с epoll, иначе EPOLLHUP закрытого клиентом сокета
+ * будет приходить постоянно.
+ */
+ 
+void cipherServer::update(uint64_t serial)
+{
+    auto it = conns.find(serial);
+    if (it == conns.end())
+        return;
+    connection& c = it->second;
+    bool congested = c.out.size() - c.sent >= config.maxPendingOutput;
+    if (!congested)
+        dispatch(c, serial);
+    bool pending = c.sent < c.out.size();
+    if (c.broken || (c.peerClosed && c.inFlight == 0 && !pending)) {
+        close(c.fd);
+        conns.erase(it);
+        return;
+    }
+    uint32_t events = 0;
+    if (!c.peerClosed && !congested && c.inFlight < config.maxInFlight)
+        events |= EPOLLIN;
+    if (pending)
+        events |= EPOLLOUT;
+    if (events == c.events)
+        return;
+    if (events == 0)
+        control(epollFd, EPOLL_CTL_DEL, c.fd, 0, serial);
+    else
+        control(epollFd, c.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c.fd, events, serial);
+    c.events = events;
+}
+
+/**
+ * @brief Выполнение одного запроса
+ * @param frame кадр запроса
+ * @return кадр ответа
+ */
+ 
+string cipherServer::process(string_view frame)
+{
+    cipherRequest req;
+    string reply;
+    uint8_t status = STATUS_OK;
+    string result;
+    if (!parseRequest(frame, req)) {
+        status = STATUS_BAD_REQUEST;
+        result = "Malformed request";
+    } else if (req.op != OP_ENCRYPT && req.op != OP_DECRYPT) {
+        status = STATUS_BAD_REQUEST;
+        result = "Unknown operation";
+    } else if (req.kind != KIND_GRONSFELD && req.kind != KIND_TABLE) {
+        status = STATUS_BAD_REQUEST;
+        result = "Unknown cipher";
+    } else {
+        try {
+            bool back = req.op == OP_DECRYPT;
+            if (req.kind == KIND_GRONSFELD) {
+                auto c = cache.gronsfeld(req.key);
+                result = back ? c->decryptUtf8(req.text) : c->encryptUtf8(req.text);
+            } else {
+                auto c = cache.table(req.key);
+                result = back ? c->decryptUtf8(req.text) : c->encryptUtf8(req.text);
+            }
+        } catch (const cipher_error& e) {
+            status = STATUS_CIPHER_ERROR;
+            result = e.what();
+        } catch (const exception& e) {
+            status = STATUS_INTERNAL_ERROR;
+            result = e.what();
+        }
+    }
+    ++requestCount;
+    if (status != STATUS_OK)
+        ++errorCount;
+    appendResponse(reply, req.id, status, result);
+    return reply;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file cipherServer.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Сервер шифрования на epoll
+ * @details Один поток ведет цикл epoll: принимает соединения, читает кадры
+ * протокола cipherProtocol и отправляет ответы. Каждый запрос выполняется
+ * на пуле потоков с шифром из cipherCache; готовый ответ возвращается
+ * в цикл через очередь и eventfd. На одном соединении одновременно
+ * выполняется до maxInFlight запросов, сверх этого чтение соединения
+ * приостанавливается до получения ответов. Чтение приостанавливается и
+ * тогда, когда клиент не забирает ответы и их скопилось больше
+ * maxPendingOutput байт.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "cipherCache.h"
+using namespace std;
+
+class threadPool;
+
+/**
+ * @brief Параметры сервера
+ */
+struct serverConfig {
+    string unixPath; ///< Путь Unix-сокета; пусто — TCP на 127.0.0.1
+    uint16_t port = 0; ///< Порт TCP; 0 — выбирается системой
+    unsigned threads = 0; ///< Рабочие потоки, 0 — по числу ядер
+    size_t cacheSize = cipherCache::DEFAULT_CAPACITY; ///< Емкость кэша шифров
+    size_t maxInFlight = 1024; ///< Запросов в работе на одно соединение
+    size_t maxPendingOutput = size_t(16) << 20; ///< Неотправленных байтов ответов на соединение, сверх этого прием запросов приостанавливается
+};
+
+/**
+ * @brief Счетчики сервера
+ */
+struct serverStats {
+    uint64_t connections = 0; ///< Принято соединений
+    uint64_t requests = 0; ///< Выполнено запросов
+    uint64_t errors = 0; ///< Из них с ответом об ошибке
+    size_t cacheHits = 0; ///< Шифр найден в кэше
+    size_t cacheMisses = 0; ///< Шифр построен заново
+};
+
+/**
+ * @brief Сервер шифрования
+ * @details run() выполняется в одном потоке; stop() и stats() можно
+ * вызывать из любого потока, stop() — также из обработчика сигнала.
+ */
+class cipherServer
+{
+private:
+    /**
+     * @brief Состояние соединения
+     */
+    struct connection {
+        int fd = -1; ///< Сокет
+        string in; ///< Принятые, но еще не разобранные байты
+        string out; ///< Ответы к отправке
+        size_t sent = 0; ///< Отправлено байтов из out
+        size_t inFlight = 0; ///< Запросов на пуле
+        uint32_t events = 0; ///< Интерес в epoll, 0 — сокет снят с epoll
+        bool peerClosed = false; ///< Клиент закрыл передачу
+        bool broken = false; ///< Ошибка сокета или протокола, закрыть
+    };
+    
+    serverConfig config; ///< Параметры
+    int listenFd = -1; ///< Слушающий сокет
+    int epollFd = -1; ///< Экземпляр epoll
+    int wakeFd = -1; ///< eventfd для готовых ответов и остановки
+    uint16_t boundPort = 0; ///< Фактический порт TCP
+    cipherCache cache; ///< Кэш шифров
+    unordered_map<uint64_t, connection> conns; ///< Соединения по номеру
+    uint64_t nextSerial = FIRST_SERIAL; ///< Номер следующего соединения
+    mutex doneLock; ///< Защита done
+    vector<pair<uint64_t, string>> done; ///< Готовые ответы: номер соединения и кадр
+    atomic<bool> stopping{false}; ///< Запрошена остановка
+    atomic<uint64_t> connectionCount{0}; ///< Принято соединений
+    atomic<uint64_t> requestCount{0}; ///< Выполнено запросов
+    atomic<uint64_t> errorCount{0}; ///< Ответов об ошибке
+    unique_ptr<threadPool> pool; ///< Рабочие потоки
+    
+    /// Метка epoll слушающего сокета
+    static const uint64_t LISTEN_TAG = 0;
+    /// Метка epoll eventfd
+    static const uint64_t WAKE_TAG = 1;
+    /// Первый номер соединения
+    static const uint64_t FIRST_SERIAL = 2;
+    
+    /**
+     * @brief Закрытие всех дескрипторов
+     */
+    void release();
+    
+    /**
+     * @brief Прием всех ожидающих соединений
+     */
+    void acceptAll();
+    
+    /**
+     * @brief Чтение из сокета; кадры разбирает dispatch
+     * @param c соединение
+     */
+    void readFrom(connection& c);
+    
+    /**
+     * @brief Передача принятых кадров на пул, пока не достигнут maxInFlight
+     * @param c соединение
+     * @param serial номер соединения
+     */
+    void dispatch(connection& c, uint64_t serial);
+    
+    /**
+     * @brief Отправка накопленных ответов
+     * @param c соединение
+     */
+    void writeTo(connection& c);
+    
+    /**
+     * @brief Перенос готовых ответов в соединения
+     */
+    void collect();
+    
+    /**
+     * @brief Обновление интереса в epoll или закрытие соединения
+     * @param serial номер соединения
+     */
+    void update(uint64_t serial);
+    
+    /**
+     * @brief Выполнение одного запроса
+     * @param frame кадр запроса
+     * @return кадр ответа
+     */
+    string process(string_view frame);
+    
+public:
+    /**
+     * @brief Конструктор: создает и привязывает слушающий сокет
+     * @param cfg параметры
+     * @throw system_error если сокет не удалось создать или привязать
+     */
+    explicit cipherServer(const serverConfig& cfg);
+    
+    /**
+     * @brief Деструктор: дожидается запросов на пуле и закрывает соединения
+     */
+    ~cipherServer();
+    
+    cipherServer(const cipherServer&) = delete;
+    cipherServer& operator=(const cipherServer&) = delete;
+    
+    /**
+     * @brief Порт TCP
+     * @return фактический порт, 0 для Unix-сокета
+     */
+    uint16_t port() const { return boundPort; }
+    
+    /**
+     * @brief Цикл обработки событий до вызова stop()
+     * @throw system_error при ошибке epoll
+     */
+    void run();
+    
+    /**
+     * @brief Остановка цикла; безопасна в обработчике сигнала
+     */
+    void stop();
+    
+    /**
+     * @brief Текущие счетчики
+     * @return число соединений, запросов, ошибок и обращений к кэшу
+     */
+    serverStats stats() const;
+};
@@ -0,0 +1,253 @@
+/**
+ * @file loadgen.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Генератор нагрузки для сервера шифрования
+ * @details Открывает несколько соединений, на каждом держит заданное
+ * количество запросов в полете и измеряет задержку каждого запроса от
+ * постановки до получения ответа. Печатает запросы в секунду и процентили
+ * задержки, последней строкой — то же в JSON. С --self запускает сервер
+ * в этом же процессе на временном Unix-сокете.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "cipherClient.h"
+#include "cipherServer.h"
+#include "../common/benchHarness.h"
+using namespace std;
+
+/**
+ * @brief Параметры нагрузки из командной строки
+ */
+struct loadArgs {
+    string unixPath; ///< Unix-сокет сервера (--unix)
+    uint16_t port = 0; ///< Порт TCP сервера (--tcp)
+    bool self = false; ///< Запустить сервер в этом процессе (--self)
+    unsigned threads = 0; ///< Рабочие потоки сервера с --self (-j)
+    size_t connections = 4; ///< Соединений (-c)
+    size_t depth = 32; ///< Запросов в полете на соединение (-d)
+    size_t requests = 100000; ///< Всего запросов (-n)
+    size_t size = 256; ///< Размер открытого текста, байт (-s)
+    size_t keys = 16; ///< Различных ключей каждого шифра (-k)
+    string cipher = "mixed"; ///< gronsfeld, table или mixed (--cipher)
+};
+
+/**
+ * @brief Разбор аргументов
+ * @param argc количество аргументов
+ * @param argv аргументы
+ * @param args результат разбора
+ * @return true если аргументы корректны
+ */
+ 
+static bool parseArgs(int argc, char** argv, loadArgs& args)
+{
+    int targets = 0;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--unix" && hasValue) {
+            args.unixPath = argv[++i];
+            ++targets;
+        } else if (arg == "--tcp" && hasValue) {
+            args.port = strtoul(argv[++i], nullptr, 10);
+            ++targets;
+        } else if (arg == "--self") {
+            args.self = true;
+            ++targets;
+        } else if (arg == "-j" && hasValue) {
+            args.threads = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-c" && hasValue) {
+            args.connections = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-d" && hasValue) {
+            args.depth = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-n" && hasValue) {
+            args.requests = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-s" && hasValue) {
+            args.size = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-k" && hasValue) {
+            args.keys = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--cipher" && hasValue) {
+            args.cipher = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return targets == 1 && args.connections > 0 && args.depth > 0 && args.keys > 0 &&
+           args.requests >= args.connections &&
+           (args.cipher == "gronsfeld" || args.cipher == "table" || args.cipher == "mixed");
+}
+
+/**
+ * @brief Ключ шифра Гронсфельда в UTF-8 (без "А", чтобы не был слабым)
+ * @param i номер ключа
+ * @return ключ из 8 букв
+ */
+ 
+static string gronsfeldKey(size_t i)
+{
+    static const char* letters = "БВГДЕЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+    string key;
+    for (size_t j = 0; j < 8; ++j) {
+        size_t k = (i * 5 + j * 7) % 31;
+        key.append(letters + 2 * k, 2);
+    }
+    return key;
+}
+
+/**
+ * @brief Процентиль отсортированной выборки
+ * @param sorted задержки по возрастанию
+ * @param q доля от 0 до 1
+ * @return значение процентиля
+ */
+ 
+static double percentile(const vector<double>& sorted, double q)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = min(sorted.size() - 1, size_t(q * sorted.size()));
+    return sorted[i];
+}
+
+/**
+ * @brief Главная функция генератора нагрузки
+ * @param argc количество аргументов
+ * @param argv аргументы
+ * @return 0, 1 при ошибке соединения или ответах с ошибкой, 2 при неверных аргументах
+ */
+ 
+int main(int argc, char** argv)
+{
+    loadArgs args;
+    if (!parseArgs(argc, argv, args)) {
+        cerr << "Использование: " << argv[0]
+             << " (--unix ПУТЬ | --tcp ПОРТ | --self [-j ПОТОКОВ]) [-c СОЕДИНЕНИЙ] [-d ГЛУБИНА]"
+                " [-n ЗАПРОСОВ] [-s БАЙТОВ] [-k КЛЮЧЕЙ] [--cipher gronsfeld|table|mixed]" << endl;
+        return 2;
+    }
+    
+    unique_ptr<cipherServer> server;
+    thread serverLoop;
+    try {
+        if (args.self) {
+            serverConfig cfg;
+            cfg.unixPath = "/tmp/cipher_loadgen_" + to_string(getpid()) + ".sock";
+            cfg.threads = args.threads;
+            server = make_unique<cipherServer>(cfg);
+            serverLoop = thread([&] { server->run(); });
+            args.unixPath = cfg.unixPath;
+        }
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+    
+    const string text = benchText(args.size);
+    vector<string> gronsfeldKeys, tableKeys;
+    for (size_t i = 0; i < args.keys; ++i) {
+        gronsfeldKeys.push_back(gronsfeldKey(i));
+        tableKeys.push_back(to_string(2 + i * 3));
+    }
+    
+    vector<vector<double>> latencies(args.connections);
+    atomic<uint64_t> errors(0);
+    mutex failLock;
+    string failure;
+    vector<thread> clients;
+    auto t0 = chrono::steady_clock::now();
+    for (size_t conn = 0; conn < args.connections; ++conn) {
+        clients.emplace_back([&, conn] {
+            try {
+                unique_ptr<cipherClient> client = args.unixPath.empty()
+                    ? make_unique<cipherClient>(args.port)
+                    : make_unique<cipherClient>(args.unixPath);
+                size_t quota = args.requests / args.connections +
+                               (conn < args.requests % args.connections);
+                vector<chrono::steady_clock::time_point> sentAt(quota);
+                vector<double>& lat = latencies[conn];
+                lat.reserve(quota);
+                string out;
+                size_t next = 0;
+                auto enqueue = [&] {
+                    cipherRequest req;
+                    req.id = next;
+                    bool table = args.cipher == "table" || (args.cipher == "mixed" && next % 2);
+                    size_t k = (next * 7 + conn) % args.keys;
+                    req.kind = table ? KIND_TABLE : KIND_GRONSFELD;
+                    req.key = table ? tableKeys[k] : gronsfeldKeys[k];
+                    req.text = text;
+                    appendRequest(out, req);
+                    sentAt[next++] = chrono::steady_clock::now();
+                };
+                while (next < min(args.depth, quota))
+                    enqueue();
+                client->send(out);
+                cipherResponse resp;
+                while (lat.size() < quota) {
+                    if (!client->receive(resp))
+                        throw runtime_error("Server closed connection");
+                    if (resp.id >= next)
+                        throw runtime_error("Unexpected response id");
+                    chrono::duration<double, micro> spent = chrono::steady_clock::now() - sentAt[resp.id];
+                    lat.push_back(spent.count());
+                    if (resp.status != STATUS_OK)
+                        ++errors;
+                    if (next < quota) {
+                        out.clear();
+                        enqueue();
+                        client->send(out);
+                    }
+                }
+            } catch (const exception& e) {
+                lock_guard<mutex> guard(failLock);
+                if (failure.empty())
+                    failure = e.what();
+            }
+        });
+    }
+    for (auto& t : clients)
+        t.join();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - t0;
+    
+    if (server) {
+        server->stop();
+        serverLoop.join();
+        serverStats s = server->stats();
+        cerr << "Сервер: запросов " << s.requests << ", кэш " << s.cacheHits << " попаданий, "
+             << s.cacheMisses << " промахов" << endl;
+    }
+    if (!failure.empty()) {
+        cerr << "Ошибка: " << failure << endl;
+        return 1;
+    }
+    
+    vector<double> all;
+    for (const auto& lat : latencies)
+        all.insert(all.end(), lat.begin(), lat.end());
+    sort(all.begin(), all.end());
+    double rps = all.size() / elapsed.count();
+    printf("requests %zu, connections %zu, depth %zu, size %zu, cipher %s, errors %llu\n",
+           all.size(), args.connections, args.depth, args.size, args.cipher.c_str(),
+           (unsigned long long)errors.load());
+    printf("%.0f requests/s, latency us: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+           rps, percentile(all, 0.5), percentile(all, 0.9), percentile(all, 0.99),
+           all.empty() ? 0.0 : all.back());
+    printf("{\"requests\": %zu, \"seconds\": %.6f, \"requests_per_s\": %.1f, \"p50_us\": %.1f, "
+           "\"p90_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f, \"errors\": %llu}\n",
+           all.size(), elapsed.count(), rps, percentile(all, 0.5), percentile(all, 0.9),
+           percentile(all, 0.99), all.empty() ? 0.0 : all.back(), (unsigned long long)errors.load());
+    return errors == 0 ? 0 : 1;
+}
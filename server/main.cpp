@@ -0,0 +1,107 @@
+/**
+ * @file main.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Сервер шифрования cipherd
+ * @details Долгоживущий процесс вместо запуска интерактивной программы
+ * на каждое сообщение: слушает Unix-сокет или порт TCP на 127.0.0.1
+ * и выполняет запросы протокола cipherProtocol обоими шифрами.
+ * Останавливается по SIGINT или SIGTERM и печатает счетчики.
+ */
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "cipherServer.h"
+using namespace std;
+
+/// Сервер для обработчика сигнала
+static cipherServer* running = nullptr;
+
+/**
+ * @brief Обработчик SIGINT и SIGTERM
+ * @param sig номер сигнала
+ */
+ 
+static void onSignal(int sig)
+{
+    (void)sig;
+    if (running)
+        running->stop();
+}
+
+/**
+ * @brief Разбор аргументов
+ * @param argc количество аргументов
+ * @param argv аргументы: (--unix ПУТЬ | --tcp ПОРТ) [-j ПОТОКОВ] [--cache ШИФРОВ] [--in-flight ЗАПРОСОВ] [--max-output БАЙТ]
+ * @param cfg результат разбора
+ * @return true если аргументы корректны
+ */
+ 
+static bool parseArgs(int argc, char** argv, serverConfig& cfg)
+{
+    bool haveAddress = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--unix" && hasValue) {
+            cfg.unixPath = argv[++i];
+            haveAddress = true;
+        } else if (arg == "--tcp" && hasValue) {
+            cfg.port = strtoul(argv[++i], nullptr, 10);
+            haveAddress = true;
+        } else if (arg == "-j" && hasValue) {
+            cfg.threads = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--cache" && hasValue) {
+            cfg.cacheSize = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--in-flight" && hasValue) {
+            cfg.maxInFlight = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-output" && hasValue) {
+            cfg.maxPendingOutput = strtoull(argv[++i], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return haveAddress;
+}
+
+/**
+ * @brief Главная функция сервера
+ * @param argc количество аргументов
+ * @param argv аргументы
+ * @return 0 после остановки по сигналу, 1 при ошибке, 2 при неверных аргументах
+ */
+ 
+int main(int argc, char** argv)
+{
+    serverConfig cfg;
+    if (!parseArgs(argc, argv, cfg)) {
+        cerr << "Использование: " << argv[0]
+             << " (--unix ПУТЬ | --tcp ПОРТ) [-j ПОТОКОВ] [--cache ШИФРОВ] [--in-flight ЗАПРОСОВ]"
+                " [--max-output БАЙТ]" << endl;
+        return 2;
+    }
+    try {
+        cipherServer server(cfg);
+        running = &server;
+        signal(SIGINT, onSignal);
+        signal(SIGTERM, onSignal);
+        signal(SIGPIPE, SIG_IGN);
+        if (cfg.unixPath.empty())
+            cerr << "Сервер слушает 127.0.0.1:" << server.port() << endl;
+        else
+            cerr << "Сервер слушает " << cfg.unixPath << endl;
+        server.run();
+        running = nullptr;
+        serverStats s = server.stats();
+        cerr << "Соединений: " << s.connections << ", запросов: " << s.requests
+             << ", ошибок: " << s.errors << ", кэш: " << s.cacheHits << " попаданий, "
+             << s.cacheMisses << " промахов" << endl;
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
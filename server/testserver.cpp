@@ -0,0 +1,316 @@
+/**
+ * @file testserver.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Модульные тесты сервера шифрования
+ * @details Тестирование кадров протокола, кэша шифров и обработки
+ * конвейерных запросов сервером через Unix-сокет и TCP
+ */
+
+#include <UnitTest++/UnitTest++.h>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "cipherCache.h"
+#include "cipherClient.h"
+#include "cipherProtocol.h"
+#include "cipherServer.h"
+
+using namespace std;
+
+/**
+ * @brief Кадр запроса
+ * @param id номер
+ * @param op операция
+ * @param kind шифр
+ * @param key ключ
+ * @param text текст
+ * @return кадр
+ */
+string requestFrame(uint32_t id, uint8_t op, uint8_t kind, string_view key, string_view text)
+{
+    cipherRequest req;
+    req.id = id;
+    req.op = op;
+    req.kind = kind;
+    req.key = key;
+    req.text = text;
+    string out;
+    appendRequest(out, req);
+    return out;
+}
+
+/**
+ * @brief Сервер, работающий в отдельном потоке на время теста
+ */
+struct runningServer {
+    cipherServer server; ///< Сервер
+    thread loop; ///< Поток цикла событий
+    
+    /**
+     * @brief Запуск
+     * @param cfg параметры сервера
+     */
+    explicit runningServer(const serverConfig& cfg):
+        server(cfg), loop([this] { server.run(); }) {}
+    
+    /**
+     * @brief Остановка и ожидание потока
+     */
+    ~runningServer()
+    {
+        server.stop();
+        loop.join();
+    }
+};
+
+/**
+ * @brief Путь временного Unix-сокета теста
+ * @return путь в /tmp с номером процесса
+ */
+string socketPath()
+{
+    return "/tmp/testserver_" + to_string(getpid()) + ".sock";
+}
+
+SUITE(ProtocolTest)
+{
+    TEST(RequestRoundTrip) {
+        string frame = requestFrame(77, OP_DECRYPT, KIND_TABLE, "12", "ПРИВЕТ");
+        CHECK_EQUAL(frame.size(), frameLength(frame));
+        cipherRequest req;
+        CHECK(parseRequest(frame, req));
+        CHECK_EQUAL(77u, req.id);
+        CHECK_EQUAL(int(OP_DECRYPT), int(req.op));
+        CHECK_EQUAL(int(KIND_TABLE), int(req.kind));
+        CHECK_EQUAL("12", string(req.key));
+        CHECK_EQUAL("ПРИВЕТ", string(req.text));
+    }
+    
+    TEST(ResponseRoundTrip) {
+        string frame;
+        appendResponse(frame, 5, STATUS_CIPHER_ERROR, "Invalid key");
+        appendResponse(frame, 6, STATUS_OK, "");
+        size_t first = frameLength(frame);
+        cipherResponse resp;
+        CHECK(parseResponse(string_view(frame).substr(0, first), resp));
+        CHECK_EQUAL(5u, resp.id);
+        CHECK_EQUAL(int(STATUS_CIPHER_ERROR), int(resp.status));
+        CHECK_EQUAL("Invalid key", string(resp.body));
+        CHECK(parseResponse(string_view(frame).substr(first), resp));
+        CHECK_EQUAL(6u, resp.id);
+        CHECK(resp.body.empty());
+    }
+    
+    TEST(PartialAndBadFrames) {
+        string frame = requestFrame(1, OP_ENCRYPT, KIND_GRONSFELD, "КЛЮЧ", "текст");
+        for (size_t n = 0; n < frame.size(); ++n)
+            CHECK_EQUAL(size_t(0), frameLength(string_view(frame).substr(0, n)));
+        CHECK_THROW(frameLength(string("\x01\x00\x00\x04", 4)), length_error);
+        cipherRequest req;
+        CHECK(!parseRequest(string("\x03\x00\x00\x00\x01\x02\x03", 7), req));
+        // Длина ключа больше остатка кадра
+        string bad = requestFrame(1, OP_ENCRYPT, KIND_GRONSFELD, "К", "");
+        bad[10] = 9;
+        CHECK(!parseRequest(bad, req));
+        cipherRequest big;
+        string key(70000, 'x');
+        big.key = key;
+        string out;
+        CHECK_THROW(appendRequest(out, big), length_error);
+    }
+}
+
+SUITE(CacheTest)
+{
+    TEST(SharesCipherPerKey) {
+        cipherCache cache(8);
+        auto a = cache.gronsfeld("КЛЮЧ");
+        auto b = cache.gronsfeld("КЛЮЧ");
+        CHECK(a == b);
+        CHECK(cache.table("5") == cache.table("5"));
+        CHECK(cache.table("5") != cache.table("6"));
+        CHECK_EQUAL(size_t(3), cache.misses());
+        CHECK_EQUAL(size_t(3), cache.hits());
+        CHECK_EQUAL(size_t(3), cache.size());
+        CHECK_EQUAL(a->encryptUtf8("привет"), modAlphaCipher(L"КЛЮЧ").encryptUtf8("привет"));
+    }
+    
+    TEST(EvictsLeastRecentlyUsed) {
+        cipherCache cache(2);
+        auto a = cache.table("2");
+        cache.table("3");
+        cache.table("2");
+        cache.table("4");
+        CHECK_EQUAL(size_t(2), cache.size());
+        CHECK(cache.table("2") == a);
+        size_t misses = cache.misses();
+        cache.table("3");
+        CHECK_EQUAL(misses + 1, cache.misses());
+    }
+    
+    TEST(InvalidKeysAreNotCached) {
+        cipherCache cache;
+        CHECK_THROW(cache.gronsfeld(""), cipher_error);
+        CHECK_THROW(cache.gronsfeld("ААА"), cipher_error);
+        CHECK_THROW(cache.gronsfeld("\xff"), cipher_error);
+        CHECK_THROW(cache.table("0"), cipher_error);
+        CHECK_THROW(cache.table("5x"), cipher_error);
+        CHECK_THROW(cache.table(""), cipher_error);
+        CHECK_EQUAL(size_t(0), cache.size());
+        cipherCache none(0);
+        CHECK(none.table("5") != none.table("5"));
+        CHECK_EQUAL(size_t(0), none.size());
+    }
+}
+
+SUITE(ServerTest)
+{
+    TEST(PipelinedRequestsMatchDirectCalls) {
+        serverConfig cfg;
+        cfg.unixPath = socketPath();
+        cfg.threads = 4;
+        runningServer srv(cfg);
+        cipherClient client(cfg.unixPath);
+        map<uint32_t, string> expected;
+        string frames;
+        for (uint32_t id = 0; id < 300; ++id) {
+            string text = "Сообщение номер " + to_string(id) + ", ёжик в тумане";
+            if (id % 2 == 0) {
+                string key = id % 4 == 0 ? "КЛЮЧ" : "ШИФР";
+                modAlphaCipher c(id % 4 == 0 ? L"КЛЮЧ" : L"ШИФР");
+                frames += requestFrame(id, id % 3 ? OP_ENCRYPT : OP_DECRYPT, KIND_GRONSFELD, key,
+                                       id % 3 ? text : c.encryptUtf8(text));
+                expected[id] = id % 3 ? c.encryptUtf8(text) : c.decryptUtf8(c.encryptUtf8(text));
+            } else {
+                Table t(1 + id % 9);
+                frames += requestFrame(id, OP_ENCRYPT, KIND_TABLE, to_string(1 + id % 9), text);
+                expected[id] = t.encryptUtf8(text);
+            }
+        }
+        client.send(frames);
+        cipherResponse resp;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            CHECK(client.receive(resp));
+            CHECK_EQUAL(int(STATUS_OK), int(resp.status));
+            CHECK_EQUAL(expected[resp.id], string(resp.body));
+            expected[resp.id] = "received";
+        }
+        for (const auto& [id, text] : expected)
+            CHECK_EQUAL("received", text);
+        client.finish();
+        CHECK(!client.receive(resp));
+        serverStats s = srv.server.stats();
+        CHECK_EQUAL(300u, s.requests);
+        CHECK_EQUAL(0u, s.errors);
+        // Два потока могут одновременно промахнуться по одному ключу
+        CHECK(s.cacheMisses >= 11);
+        CHECK_EQUAL(size_t(300), s.cacheHits + s.cacheMisses);
+    }
+    
+    TEST(ErrorsKeepConnectionOpen) {
+        serverConfig cfg;
+        cfg.unixPath = socketPath();
+        runningServer srv(cfg);
+        cipherClient client(cfg.unixPath);
+        client.send(requestFrame(1, OP_ENCRYPT, KIND_GRONSFELD, "ААА", "текст") +
+                    requestFrame(2, OP_DECRYPT, KIND_TABLE, "3", "АБ В") +
+                    requestFrame(3, 9, KIND_TABLE, "3", "АБВ") +
+                    requestFrame(4, OP_ENCRYPT, 9, "3", "АБВ") +
+                    string("\x02\x00\x00\x00\x05\x00", 6));
+        map<uint32_t, pair<int, string>> got;
+        cipherResponse resp;
+        for (int i = 0; i < 5; ++i) {
+            CHECK(client.receive(resp));
+            got[resp.id] = {resp.status, string(resp.body)};
+        }
+        CHECK_EQUAL(int(STATUS_CIPHER_ERROR), got[1].first);
+        CHECK_EQUAL("Weak key", got[1].second);
+        CHECK_EQUAL(int(STATUS_CIPHER_ERROR), got[2].first);
+        CHECK_EQUAL("Whitespace in cipher text", got[2].second);
+        CHECK_EQUAL("Unknown operation", got[3].second);
+        CHECK_EQUAL("Unknown cipher", got[4].second);
+        CHECK_EQUAL(int(STATUS_BAD_REQUEST), got[0].first);
+        CHECK_EQUAL("Malformed request", got[0].second);
+        client.send(requestFrame(5, OP_ENCRYPT, KIND_TABLE, "2", "АБВ"));
+        CHECK(client.receive(resp));
+        CHECK_EQUAL(5u, resp.id);
+        CHECK_EQUAL("БАВ", string(resp.body));
+        CHECK_EQUAL(5u, srv.server.stats().errors);
+    }
+    
+    TEST(TcpWithInFlightLimit) {
+        serverConfig cfg;
+        cfg.threads = 2;
+        cfg.maxInFlight = 2;
+        runningServer srv(cfg);
+        CHECK(srv.server.port() != 0);
+        cipherClient client(srv.server.port());
+        string frames;
+        string text(20000, 'x');
+        text += "Привет";
+        for (uint32_t id = 0; id < 100; ++id)
+            frames += requestFrame(id, OP_ENCRYPT, KIND_TABLE, "4", text);
+        client.send(frames);
+        client.finish();
+        cipherResponse resp;
+        size_t count = 0;
+        while (client.receive(resp)) {
+            CHECK_EQUAL("ВИРТПЕ", string(resp.body));
+            ++count;
+        }
+        CHECK_EQUAL(size_t(100), count);
+    }
+    
+    TEST(OversizedFrameClosesConnection) {
+        serverConfig cfg;
+        cfg.unixPath = socketPath();
+        runningServer srv(cfg);
+        cipherClient client(cfg.unixPath);
+        client.send(string("\xff\xff\xff\x7f", 4));
+        cipherResponse resp;
+        CHECK(!client.receive(resp));
+        cipherClient other(cfg.unixPath);
+        other.send(requestFrame(1, OP_ENCRYPT, KIND_TABLE, "1", "АБ"));
+        CHECK(other.receive(resp));
+        CHECK_EQUAL("АБ", string(resp.body));
+    }
+    
+    TEST(UnreadRepliesPauseReading) {
+        serverConfig cfg;
+        cfg.unixPath = socketPath();
+        cfg.threads = 2;
+        cfg.maxPendingOutput = 64 << 10;
+        runningServer srv(cfg);
+        cipherClient client(cfg.unixPath);
+        const uint32_t count = 5000;
+        string text;
+        for (int i = 0; i < 1000; ++i)
+            text += "Ж";
+        string frames;
+        for (uint32_t id = 0; id < count; ++id)
+            frames += requestFrame(id, OP_ENCRYPT, KIND_TABLE, "1", text);
+        // Клиент отправляет все запросы, не читая ответов
+        thread sender([&] { client.send(frames); });
+        this_thread::sleep_for(chrono::milliseconds(300));
+        // Выполнено не больше, чем помещается в буферы сокета и maxPendingOutput
+        CHECK(srv.server.stats().requests < count / 2);
+        cipherResponse resp;
+        uint32_t received = 0;
+        while (received < count && client.receive(resp)) {
+            CHECK_EQUAL(text.size(), resp.body.size());
+            ++received;
+        }
+        sender.join();
+        CHECK_EQUAL(count, received);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    return UnitTest::RunAllTests();
+}
@@ -0,0 +1,134 @@
+/**
+ * @file bench.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Замеры производительности шифра Гронсфельда
+ * @details Измеряет шифрование и расшифрование при разных длинах ключа,
+ * отдельно валидацию текста и перекодирование UTF-8 на сообщениях от 16 байт
+ * до --max-size (по умолчанию 16 МБ, для 1 ГБ — --max-size 1073741824).
+ * Результаты выводятся в JSON, --compare сравнивает их с базой.
+ */
+
+#include <codecvt>
+#include <locale>
+#include <string>
+#include <vector>
+#include "modAlphaCipher.h"
+#include "gronsfeldAnalysis.h"
+#include "../common/benchHarness.h"
+#include "../common/ruTranscode.h"
+#include "../common/packedText.h"
+using namespace std;
+
+/**
+ * @brief Ключ заданной длины из букв алфавита (без "А", чтобы не был слабым)
+ * @param length длина ключа
+ * @return ключ
+ */
+ 
+wstring benchKey(size_t length)
+{
+    wstring key;
+    for (size_t i = 0; i < length; ++i)
+        key += L"БВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ"[(i * 7) % 32];
+    return key;
+}
+
+/**
+ * @brief Главная функция замеров
+ * @param argc количество аргументов
+ * @param argv аргументы benchSuite
+ * @return 0, или 1 при регрессии относительно базы
+ */
+ 
+int main(int argc, char** argv)
+{
+    benchSuite suite("modAlphaCipher", argc, argv);
+    wstring_convert<codecvt_utf8<wchar_t>> conv;
+    modAlphaCipher validator(benchKey(8));
+    
+    for (size_t size : suite.sizes()) {
+        string sz = "/size=" + to_string(size);
+        string text8 = benchText(size);
+        wstring text = conv.from_bytes(text8);
+        wstring cipher = validator.encrypt(text);
+        string cipher8 = conv.to_bytes(cipher);
+        vector<uint8_t> idx(size / 2);
+        vector<uint8_t> wideIdx(text.size());
+        volatile size_t sink = 0;
+        
+        suite.run("utf8/decode" + sz, size, [&] { sink = conv.from_bytes(text8).size(); });
+        suite.run("utf8/encode" + sz, size, [&] { sink = conv.to_bytes(text).size(); });
+        for (ruTranscodeIsa isa : {RU_TRANSCODE_SCALAR, RU_TRANSCODE_AVX2}) {
+            if (!ruTranscodeSupported(isa))
+                continue;
+            string i = isa == RU_TRANSCODE_AVX2 ? "/isa=avx2" : "/isa=scalar";
+            suite.run("transcode/open" + i + sz, size, [&] {
+                sink = ruDecodeOpen(isa, text8.data(), text8.size(), idx.data());
+            });
+            suite.run("transcode/cipher" + i + sz, cipher8.size(), [&] {
+                sink = ruDecodeCipher(isa, cipher8.data(), cipher8.size(), idx.data()).letters;
+            });
+            suite.run("transcode/wide/open" + i + sz, size, [&] {
+                sink = ruDecodeOpen(isa, text, wideIdx.data());
+            });
+            suite.run("transcode/wide/cipher" + i + sz, cipher8.size(), [&] {
+                sink = ruDecodeCipher(isa, cipher, wideIdx.data()).letters;
+            });
+        }
+        string encoded(cipher8.size(), '\0');
+        suite.run("transcode/encode" + sz, cipher8.size(), [&] {
+            ruEncodeUpper(idx.data(), cipher.size(), &encoded[0]);
+        });
+        vector<uint8_t> packed(packedBytes(cipher.size()));
+        for (ruTranscodeIsa isa : {RU_TRANSCODE_SCALAR, RU_TRANSCODE_AVX2}) {
+            if (!ruTranscodeSupported(isa))
+                continue;
+            string i = isa == RU_TRANSCODE_AVX2 ? "/isa=avx2" : "/isa=scalar";
+            suite.run("packed/pack" + i + sz, cipher.size(), [&] {
+                packLetters(isa, idx.data(), cipher.size(), packed.data());
+            });
+            suite.run("packed/unpack" + i + sz, cipher.size(), [&] {
+                sink = unpackLetters(isa, packed.data(), cipher.size(), idx.data());
+            });
+        }
+        suite.run("validate/open" + sz, size, [&] {
+            sink = validator.validateOpenText(text);
+        });
+        suite.run("validate/cipher" + sz, size, [&] {
+            sink = validator.validateCipherText(cipher);
+        });
+        
+        // Каждое выполнение проверяет MAX_PERIOD длин ключа
+        if (size <= (1 << 20)) {
+            gronsfeldAnalyzer single;
+            gronsfeldAnalyzer parallel;
+            parallel.setParallel(0u);
+            suite.run("analyze/threads=1" + sz, cipher8.size(), [&] {
+                sink = single.analyze(cipher8).period;
+            });
+            suite.run("analyze/threads=all" + sz, cipher8.size(), [&] {
+                sink = parallel.analyze(cipher8).period;
+            });
+        }
+        
+        for (size_t keyLength : {1, 8, 64, 1024}) {
+            modAlphaCipher c(benchKey(keyLength));
+            string k = "/key=" + to_string(keyLength);
+            suite.run("encrypt" + k + sz, size, [&] { sink = c.encrypt(text).size(); });
+            suite.run("decrypt" + k + sz, size, [&] { sink = c.decrypt(cipher).size(); });
+            suite.run("encrypt/utf8" + k + sz, size, [&] { sink = c.encryptUtf8(text8).size(); });
+            suite.run("decrypt/utf8" + k + sz, size, [&] { sink = c.decryptUtf8(cipher8).size(); });
+            string archive = c.encryptPacked(text8);
+            suite.run("encrypt/packed" + k + sz, size, [&] { sink = c.encryptPacked(text8).size(); });
+            suite.run("decrypt/packed" + k + sz, size, [&] { sink = c.decryptPacked(archive).size(); });
+            // Страница из середины: время не должно зависеть от size
+            size_t page = min<size_t>(4096, cipher.size() / 2);
+            suite.run("decrypt/range" + k + sz, 2 * page, [&] {
+                sink = c.decryptRange(string_view(cipher8), cipher.size() / 2, page).size();
+            });
+        }
+    }
+    return suite.finish();
+}
@@ -0,0 +1,236 @@
+/**
+ * @file gronsfeldAnalysis.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация восстановления ключа шифра Гронсфельда
+ */
+
+#include "gronsfeldAnalysis.h"
+#include "../common/ruAlphabet.h"
+#include "../common/ruUtf8.h"
+#include "../common/threadPool.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+using namespace std;
+
+/**
+ * @brief Частоты букв русского языка в порядке алфавита, доли единицы
+ * @return таблица из RU_ALPHABET_SIZE частот, нормированная к сумме 1
+ * @details Исходные значения — проценты по корпусу художественных текстов
+ */
+ 
+static array<double, RU_ALPHABET_SIZE> makeFrequencies()
+{
+    array<double, RU_ALPHABET_SIZE> f = {
+        8.01, 1.59, 4.54, 1.70, 2.98, 8.45, 0.04, 0.94, 1.65, 7.35, 1.21,
+        3.49, 4.40, 3.21, 6.70, 10.97, 2.81, 4.73, 5.47, 6.26, 2.62, 0.26,
+        0.97, 0.48, 1.44, 0.73, 0.36, 0.04, 1.90, 1.74, 0.32, 0.64, 2.01
+    };
+    double sum = 0;
+    for (double x : f)
+        sum += x;
+    for (double& x : f)
+        x /= sum;
+    return f;
+}
+
+/// Частоты букв русского языка
+static const array<double, RU_ALPHABET_SIZE> ruFrequencies = makeFrequencies();
+
+/**
+ * @brief Обратные частоты для хи-квадрата
+ * @return 1 / ruFrequencies[c] для каждой буквы
+ */
+ 
+static array<double, RU_ALPHABET_SIZE> makeInverseFrequencies()
+{
+    array<double, RU_ALPHABET_SIZE> f;
+    for (size_t c = 0; c < RU_ALPHABET_SIZE; ++c)
+        f[c] = 1 / ruFrequencies[c];
+    return f;
+}
+
+/// Обратные частоты букв русского языка
+static const array<double, RU_ALPHABET_SIZE> ruInverseFrequencies = makeInverseFrequencies();
+
+/**
+ * @brief Конструктор
+ * @param maxLength наибольшая проверяемая длина ключа
+ * @throw cipher_error если maxLength равна нулю
+ */
+ 
+gronsfeldAnalyzer::gronsfeldAnalyzer(size_t maxLength):
+    maxPeriod(maxLength)
+{
+    if (maxPeriod == 0)
+        throw cipher_error("Invalid key length limit");
+}
+
+/**
+ * @brief Разбор длин-кандидатов на общем пуле потоков
+ * @param p пул потоков, nullptr — однопоточный режим
+ * @details Не синхронизируется с analyze в других потоках
+ */
+ 
+void gronsfeldAnalyzer::setParallel(shared_ptr<threadPool> p)
+{
+    pool = move(p);
+}
+
+/**
+ * @brief Разбор длин-кандидатов на собственном пуле
+ * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+ */
+ 
+void gronsfeldAnalyzer::setParallel(unsigned threads)
+{
+    setParallel(threads == 1 ? nullptr : make_shared<threadPool>(threads));
+}
+
+/**
+ * @brief Гистограммы фаз, индекс совпадений и подбор сдвигов для одной длины
+ * @param text номера букв шифртекста
+ * @param n количество букв
+ * @param period длина ключа-кандидата
+ * @return оценка длины
+ * @details Гистограммы всех фаз строятся за один проход: соседние буквы
+ * попадают в разные фазы, поэтому приращения счетчиков не ждут друг друга.
+ * Хи-квадрат сдвига s сравнивает частоту шифробуквы (c + s) mod 33
+ * с ожидаемой частотой открытой буквы c. Так как сумма наблюдений равна
+ * сумме ожиданий N, он сводится к (1 / N) * sum(o[c + s]^2 / f[c]) - N,
+ * то есть к скалярному произведению квадратов счетчиков на обратные
+ * частоты без делений во внутреннем цикле.
+ */
+ 
+periodFit gronsfeldAnalyzer::fitPeriod(const uint8_t* text, size_t n, size_t period) const
+{
+    vector<uint32_t> hist(period * RU_ALPHABET_SIZE);
+    size_t phase = 0;
+    for (size_t i = 0; i < n; ++i) {
+        ++hist[phase * RU_ALPHABET_SIZE + text[i]];
+        if (++phase == period)
+            phase = 0;
+    }
+    
+    periodFit fit;
+    fit.period = period;
+    fit.shifts.assign(period, 0);
+    size_t counted = 0;
+    for (size_t j = 0; j < period; ++j) {
+        size_t total = n / period + (j < n % period);
+        if (total < 2)
+            continue;
+        const uint32_t* h = &hist[j * RU_ALPHABET_SIZE];
+        double squares[2 * RU_ALPHABET_SIZE];
+        double same = 0;
+        for (size_t c = 0; c < RU_ALPHABET_SIZE; ++c) {
+            double o = h[c];
+            same += o * (o - 1);
+            squares[c] = squares[c + RU_ALPHABET_SIZE] = o * o;
+        }
+        fit.ioc += same / (double(total) * double(total - 1));
+        
+        // Все 33 сдвига накапливаются одновременно: внутренний цикл векторизуется
+        double weighted[RU_ALPHABET_SIZE] = {};
+        for (size_t c = 0; c < RU_ALPHABET_SIZE; ++c) {
+            for (size_t s = 0; s < RU_ALPHABET_SIZE; ++s)
+                weighted[s] += squares[c + s] * ruInverseFrequencies[c];
+        }
+        double best = numeric_limits<double>::infinity();
+        for (size_t s = 0; s < RU_ALPHABET_SIZE; ++s) {
+            if (weighted[s] < best) {
+                best = weighted[s];
+                fit.shifts[j] = s;
+            }
+        }
+        fit.chiSquared += best / total - total;
+        ++counted;
+    }
+    if (counted != 0) {
+        fit.ioc /= counted;
+        fit.chiSquared /= counted;
+    }
+    return fit;
+}
+
+/**
+ * @brief Восстановление ключа по номерам букв шифртекста
+ * @param cipher номера букв 0..32
+ * @param n количество букв
+ * @return оценки всех длин, выбранная длина и ключ
+ * @details Длины больше n / 2 не проверяются: в их фазах меньше двух букв
+ * @throw cipher_error если шифртекст короче двух букв
+ */
+ 
+keyRecovery gronsfeldAnalyzer::analyze(const uint8_t* cipher, size_t n) const
+{
+    if (n < 2)
+        throw cipher_error("Cipher text too short");
+    auto t0 = chrono::steady_clock::now();
+    keyRecovery res;
+    res.letters = n;
+    res.periods.resize(min(maxPeriod, n / 2));
+    auto fitOne = [&](size_t k) {
+        res.periods[k] = fitPeriod(cipher, n, k + 1);
+    };
+    if (pool && res.periods.size() > 1) {
+        pool->parallelFor(res.periods.size(), fitOne);
+    } else {
+        for (size_t k = 0; k < res.periods.size(); ++k)
+            fitOne(k);
+    }
+    
+    double best = 0;
+    for (const periodFit& fit : res.periods)
+        best = max(best, fit.ioc);
+    double threshold = (best + 1.0 / RU_ALPHABET_SIZE) / 2;
+    const periodFit* chosen = &res.periods.back();
+    for (const periodFit& fit : res.periods) {
+        if (fit.ioc >= threshold) {
+            chosen = &fit;
+            break;
+        }
+    }
+    res.period = chosen->period;
+    
+    // Сдвиги могут повторяться с меньшим периодом, если выбрана кратная длина
+    const letterBuffer& s = chosen->shifts;
+    size_t q = 1;
+    while (q < s.size()) {
+        bool repeats = s.size() % q == 0;
+        for (size_t j = q; repeats && j < s.size(); ++j)
+            repeats = s[j] == s[j - q];
+        if (repeats)
+            break;
+        ++q;
+    }
+    for (size_t j = 0; j < q; ++j)
+        res.key.push_back(RU_UPPER[s[j]]);
+    
+    chrono::duration<double> spent = chrono::steady_clock::now() - t0;
+    res.seconds = spent.count();
+    res.periodsPerSecond = res.seconds > 0 ? res.periods.size() / res.seconds : 0;
+    return res;
+}
+
+/**
+ * @brief Восстановление ключа по шифртексту в UTF-8
+ * @param cipher шифртекст из прописных букв
+ * @return оценки всех длин, выбранная длина и ключ
+ * @throw cipher_error если шифртекст короче двух букв или содержит
+ * недопустимые символы
+ */
+ 
+keyRecovery gronsfeldAnalyzer::analyze(string_view cipher) const
+{
+    letterBuffer letters(cipher.size() / RU_UTF8_LETTER);
+    ruDecodeResult res = ruDecodeCipher(cipher.data(), cipher.size(), letters.data());
+    if (res.status == RU_TEXT_SPACE)
+        throw cipher_error("Whitespace in cipher text");
+    if (res.status == RU_TEXT_INVALID)
+        throw cipher_error("Invalid character in cipher text");
+    return analyze(letters.data(), res.letters);
+}
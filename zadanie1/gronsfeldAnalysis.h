@@ -0,0 +1,118 @@
+/**
+ * @file gronsfeldAnalysis.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Восстановление ключа шифра Гронсфельда по шифртексту
+ * @details Для каждой длины ключа-кандидата шифртекст раскладывается на фазы
+ * (буквы с одинаковым остатком позиции), по гистограммам фаз считается
+ * средний индекс совпадений. У верной длины и ее кратных он близок к индексу
+ * русского языка (около 0,055), у остальных — к 1/33. Затем для каждой фазы
+ * подбирается сдвиг с наименьшим хи-квадратом относительно частот букв
+ * русского языка, сдвиг и есть номер буквы ключа. Длины-кандидаты
+ * обрабатываются параллельно на пуле потоков.
+ * @warning Реализация для русского языка
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "modAlphaCipher.h"
+#include "../common/ruTranscode.h"
+using namespace std;
+
+class threadPool;
+
+/**
+ * @brief Оценка одной длины ключа-кандидата
+ */
+struct periodFit {
+    size_t period = 0; ///< Длина ключа-кандидата
+    double ioc = 0; ///< Средний по фазам индекс совпадений
+    double chiSquared = 0; ///< Средний по фазам хи-квадрат лучших сдвигов
+    letterBuffer shifts; ///< Лучший сдвиг (номер буквы ключа) для каждой фазы
+};
+
+/**
+ * @brief Результат восстановления ключа
+ */
+struct keyRecovery {
+    vector<periodFit> periods; ///< Оценки длин 1..maxPeriod по возрастанию
+    size_t period = 0; ///< Выбранная длина ключа
+    wstring key; ///< Восстановленный ключ наименьшей длины
+    size_t letters = 0; ///< Количество букв шифртекста
+    double seconds = 0; ///< Время анализа
+    double periodsPerSecond = 0; ///< Пропускная способность, длин-кандидатов в секунду
+};
+
+/**
+ * @brief Анализатор шифртекстов Гронсфельда
+ * @details Оценки длин ключа собираются в возвращаемом keyRecovery,
+ * в анализаторе хранится только наибольшая длина, поэтому анализы
+ * разных текстов могут идти одновременно.
+ */
+class gronsfeldAnalyzer
+{
+private:
+    size_t maxPeriod; ///< Наибольшая проверяемая длина ключа
+    shared_ptr<threadPool> pool; ///< Пул потоков (может быть пустым)
+    
+    /**
+     * @brief Гистограммы фаз, индекс совпадений и подбор сдвигов для одной длины
+     * @param text номера букв шифртекста
+     * @param n количество букв
+     * @param period длина ключа-кандидата
+     * @return оценка длины
+     */
+    periodFit fitPeriod(const uint8_t* text, size_t n, size_t period) const;
+    
+public:
+    /// Наибольшая длина ключа по умолчанию
+    static const size_t MAX_PERIOD = 64;
+    
+    /**
+     * @brief Конструктор
+     * @param maxLength наибольшая проверяемая длина ключа
+     * @throw cipher_error если maxLength равна нулю
+     */
+    explicit gronsfeldAnalyzer(size_t maxLength = MAX_PERIOD);
+    
+    /**
+     * @brief Разбор длин-кандидатов на общем пуле потоков
+     * @param p пул потоков, nullptr — однопоточный режим
+     * @details Не синхронизируется с analyze в других потоках
+     */
+    void setParallel(shared_ptr<threadPool> p);
+    
+    /**
+     * @brief Разбор длин-кандидатов на собственном пуле
+     * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+     */
+    void setParallel(unsigned threads);
+    
+    /**
+     * @brief Восстановление ключа по номерам букв шифртекста
+     * @param cipher номера букв 0..32
+     * @param n количество букв
+     * @return оценки всех длин, выбранная длина и ключ
+     * @details Выбирается наименьшая длина, индекс совпадений которой выше
+     * середины между лучшим индексом и 1/33: кратные верной длины дают
+     * такой же индекс, а более короткие — нет. Ключ сокращается до
+     * наименьшего периода найденных сдвигов.
+     * @throw cipher_error если шифртекст короче двух букв
+     */
+    keyRecovery analyze(const uint8_t* cipher, size_t n) const;
+    
+    /**
+     * @brief Восстановление ключа по шифртексту в UTF-8
+     * @param cipher шифртекст из прописных букв
+     * @return оценки всех длин, выбранная длина и ключ
+     * @throw cipher_error если шифртекст короче двух букв или содержит
+     * недопустимые символы
+     */
+    keyRecovery analyze(string_view cipher) const;
+};
@@ -0,0 +1,192 @@
+/**
+ * @file gronsfeldKernel.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация скалярного, SSE2 и AVX2 ядер шифра Гронсфельда
+ */
+
+#include "gronsfeldKernel.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GRONSFELD_X86 1
+#endif
+using namespace std;
+
+/**
+ * @brief Построение ключевого потока
+ * @param key номера букв ключа
+ * @param back true — поток для расшифрования (33 - k), false — для шифрования
+ * @return ключ, повторенный до длины key.size() + GRONSFELD_PAD
+ */
+ 
+vector<uint8_t> gronsfeldKeyStream(const vector<uint8_t>& key, bool back)
+{
+    vector<uint8_t> ks(key.size() + GRONSFELD_PAD);
+    for (size_t i = 0; i < ks.size(); ++i) {
+        uint8_t k = key[i % key.size()];
+        ks[i] = back ? (GRONSFELD_MOD - k) % GRONSFELD_MOD : k;
+    }
+    return ks;
+}
+
+/**
+ * @brief Скалярное эталонное ядро
+ * @param data номера букв
+ * @param n количество букв
+ * @param ks ключевой поток
+ * @param period длина ключа
+ * @param phase позиция в ключе
+ */
+ 
+static void addScalar(uint8_t* data, size_t n,
+                      const uint8_t* ks, size_t period, size_t phase)
+{
+    for (size_t p = 0; p < n; ++p) {
+        data[p] = (data[p] + ks[phase]) % GRONSFELD_MOD;
+        if (++phase == period)
+            phase = 0;
+    }
+}
+
+#ifdef GRONSFELD_X86
+
+/**
+ * @brief Ядро SSE2: 16 букв за итерацию
+ * @details min(s, s - 33) без знака дает s при s < 33 (разность переполняется)
+ * и s - 33 иначе
+ * @param data номера букв
+ * @param n количество букв
+ * @param ks ключевой поток
+ * @param period длина ключа
+ * @param phase позиция в ключе
+ */
+ 
+__attribute__((target("sse2")))
+static void addSSE2(uint8_t* data, size_t n,
+                    const uint8_t* ks, size_t period, size_t phase)
+{
+    const __m128i mod = _mm_set1_epi8(GRONSFELD_MOD);
+    const size_t step = 16 % period;
+    size_t p = 0;
+    for (; p + 16 <= n; p += 16) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + p));
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ks + phase));
+        __m128i s = _mm_add_epi8(d, k);
+        s = _mm_min_epu8(s, _mm_sub_epi8(s, mod));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + p), s);
+        phase += step;
+        if (phase >= period)
+            phase -= period;
+    }
+    addScalar(data + p, n - p, ks, period, phase);
+}
+
+/**
+ * @brief Ядро AVX2: 32 буквы за итерацию
+ * @param data номера букв
+ * @param n количество букв
+ * @param ks ключевой поток
+ * @param period длина ключа
+ * @param phase позиция в ключе
+ */
+ 
+__attribute__((target("avx2")))
+static void addAVX2(uint8_t* data, size_t n,
+                    const uint8_t* ks, size_t period, size_t phase)
+{
+    const __m256i mod = _mm256_set1_epi8(GRONSFELD_MOD);
+    const size_t step = 32 % period;
+    size_t p = 0;
+    for (; p + 32 <= n; p += 32) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + p));
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ks + phase));
+        __m256i s = _mm256_add_epi8(d, k);
+        s = _mm256_min_epu8(s, _mm256_sub_epi8(s, mod));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + p), s);
+        phase += step;
+        if (phase >= period)
+            phase -= period;
+    }
+    addSSE2(data + p, n - p, ks, period, phase);
+}
+
+#endif
+
+/**
+ * @brief Проверка поддержки набора инструкций процессором
+ * @param isa набор инструкций
+ * @return true если ядро isa можно вызывать
+ */
+ 
+bool gronsfeldSupported(gronsfeldIsa isa)
+{
+    switch (isa) {
+    case ISA_SCALAR:
+        return true;
+#ifdef GRONSFELD_X86
+    case ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Лучший набор инструкций, поддерживаемый процессором
+ * @return ISA_AVX2, ISA_SSE2 или ISA_SCALAR
+ * @details Результат определяется один раз при первом вызове
+ */
+ 
+gronsfeldIsa gronsfeldBestIsa()
+{
+    static const gronsfeldIsa best =
+        gronsfeldSupported(ISA_AVX2) ? ISA_AVX2 :
+        gronsfeldSupported(ISA_SSE2) ? ISA_SSE2 : ISA_SCALAR;
+    return best;
+}
+
+/**
+ * @brief Сложение текста с ключевым потоком по модулю 33
+ * @param isa набор инструкций
+ * @param data номера букв, изменяются на месте
+ * @param n количество букв
+ * @param ks ключевой поток из gronsfeldKeyStream
+ * @param period длина исходного ключа
+ * @param phase позиция в ключе для первой буквы (меньше period)
+ */
+ 
+void gronsfeldAdd(gronsfeldIsa isa, uint8_t* data, size_t n,
+                  const uint8_t* ks, size_t period, size_t phase)
+{
+    switch (isa) {
+#ifdef GRONSFELD_X86
+    case ISA_AVX2:
+        addAVX2(data, n, ks, period, phase);
+        break;
+    case ISA_SSE2:
+        addSSE2(data, n, ks, period, phase);
+        break;
+#endif
+    default:
+        addScalar(data, n, ks, period, phase);
+    }
+}
+
+/**
+ * @brief Сложение текста с ключевым потоком лучшим доступным ядром
+ * @param data номера букв, изменяются на месте
+ * @param n количество букв
+ * @param ks ключевой поток из gronsfeldKeyStream
+ * @param period длина исходного ключа
+ * @param phase позиция в ключе для первой буквы (меньше period)
+ */
+ 
+void gronsfeldAdd(uint8_t* data, size_t n,
+                  const uint8_t* ks, size_t period, size_t phase)
+{
+    gronsfeldAdd(gronsfeldBestIsa(), data, n, ks, period, phase);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file gronsfeldKernel.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Векторное ядро шифра Гронсфельда над индексами букв
+ * @details Текст и ключ представлены однобайтовыми номерами букв (0..32).
+ * Ключ заранее разворачивается в ключевой поток длиной период + GRONSFELD_PAD,
+ * поэтому для любой позиции в ключе доступен непрерывный отрезок ключа
+ * на ширину вектора. Остаток по модулю 33 заменяется сравнением и вычитанием.
+ * Набор инструкций выбирается во время выполнения.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+const uint8_t GRONSFELD_MOD = 33; ///< Размер алфавита
+const size_t GRONSFELD_PAD = 64; ///< Запас ключевого потока на ширину вектора
+
+/**
+ * @brief Набор инструкций для ядра шифра
+ */
+enum gronsfeldIsa {
+    ISA_SCALAR, ///< Скалярная эталонная реализация
+    ISA_SSE2,   ///< 16 букв за инструкцию
+    ISA_AVX2    ///< 32 буквы за инструкцию
+};
+
+/**
+ * @brief Лучший набор инструкций, поддерживаемый процессором
+ * @return ISA_AVX2, ISA_SSE2 или ISA_SCALAR
+ */
+gronsfeldIsa gronsfeldBestIsa();
+
+/**
+ * @brief Проверка поддержки набора инструкций процессором
+ * @param isa набор инструкций
+ * @return true если ядро isa можно вызывать
+ */
+bool gronsfeldSupported(gronsfeldIsa isa);
+
+/**
+ * @brief Построение ключевого потока
+ * @param key номера букв ключа
+ * @param back true — поток для расшифрования (33 - k), false — для шифрования
+ * @return ключ, повторенный до длины key.size() + GRONSFELD_PAD
+ */
+vector<uint8_t> gronsfeldKeyStream(const vector<uint8_t>& key, bool back);
+
+/**
+ * @brief Сложение текста с ключевым потоком по модулю 33
+ * @param isa набор инструкций
+ * @param data номера букв, изменяются на месте
+ * @param n количество букв
+ * @param ks ключевой поток из gronsfeldKeyStream
+ * @param period длина исходного ключа
+ * @param phase позиция в ключе для первой буквы (меньше period)
+ */
+void gronsfeldAdd(gronsfeldIsa isa, uint8_t* data, size_t n,
+                  const uint8_t* ks, size_t period, size_t phase);
+
+/**
+ * @brief Сложение текста с ключевым потоком лучшим доступным ядром
+ * @param data номера букв, изменяются на месте
+ * @param n количество букв
+ * @param ks ключевой поток из gronsfeldKeyStream
+ * @param period длина исходного ключа
+ * @param phase позиция в ключе для первой буквы (меньше period)
+ */
+void gronsfeldAdd(uint8_t* data, size_t n,
+                  const uint8_t* ks, size_t period, size_t phase);
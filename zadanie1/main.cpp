@@ -14,7 +14,11 @@
 #include <algorithm>
 #include <cwctype>
 #include <limits>
+#include <cstring>
 #include "modAlphaCipher.h"
+#include "../common/linePipe.h"
+#include "../common/asyncIo.h"
+#include "../common/mappedFile.h"
 
 using namespace std;
 
@@ -26,31 +30,96 @@ using namespace std;
  
 wstring str8_to_w(const string& s)
 {
-    wstring_convert<codecvt_utf8<wchar_t>> conv;
+    thread_local wstring_convert<codecvt_utf8<wchar_t>> conv;
     return conv.from_bytes(s);
 }
 
 /**
- * @brief Преобразование широкой строки в строку UTF-8
- * @param ws широкая строка
- * @return строка в UTF-8
+ * @brief Неинтерактивный режим
+ * @param args ключ, направление, количество потоков и пути файлов
+ * @return 0 если все записи обработаны, иначе 1
+ * @details С -i/-o файл обрабатывается целиком через отображение в память,
+ * с -q — блоками через очередь io_uring (или pread/pwrite) с отчетом
+ * о скорости, с -p шифртекст записывается и читается в упакованном формате
+ * packedText, с -s — конвейером стадий в отдельных потоках с отчетом
+ * по стадиям, без них каждая строка стандартного ввода — отдельная запись
  */
  
-string w_to_str8(const wstring& ws)
+int runPipe(const pipeArgs& args)
 {
-    wstring_convert<codecvt_utf8<wchar_t>> conv;
-    return conv.to_bytes(ws);
+    bool ready = false;
+    try {
+        modAlphaCipher cipher(str8_to_w(args.key));
+        ready = true;
+        if (!args.inPath.empty() && args.queueDepth > 0) {
+            modAlphaStream stream(cipher, args.decrypt);
+            filePipeline pipeline(args.queueDepth);
+            pipelineStats stats = pipeline.run(args.inPath, args.outPath,
+                [&](const char* data, size_t len, bool last, string& out) {
+                    stream.update(data, len, out);
+                    if (last)
+                        stream.finish();
+                });
+            cerr << stats.report() << endl;
+            return 0;
+        }
+        if (args.staged) {
+            stagedPipeline pipeline(cipher.stages(args.decrypt));
+            cerr << pipeline.run(args.inPath, args.outPath).report() << endl;
+            return 0;
+        }
+        if (args.packed) {
+            checkDistinctFiles(args.inPath, args.outPath);
+            mappedFile src(args.inPath);
+            string_view text(src.data(), src.size());
+            string out = args.decrypt ? cipher.decryptPacked(text) : cipher.encryptPacked(text);
+            mappedFile dst(args.outPath, out.size());
+            memcpy(dst.data(), out.data(), out.size());
+            return 0;
+        }
+        if (!args.inPath.empty()) {
+            if (args.decrypt) {
+                cipher.decryptFile(args.inPath, args.outPath);
+            } else {
+                cipher.encryptFile(args.inPath, args.outPath);
+            }
+            return 0;
+        }
+        linePipe pipe([&](const string& line) {
+            return args.decrypt ? cipher.decryptUtf8(line) : cipher.encryptUtf8(line);
+        }, args.threads);
+        return pipe.run() ? 1 : 0;
+    } catch (const cipher_error& e) {
+        cerr << (ready ? "Ошибка при обработке текста: " : "Ошибка инициализации шифра: ")
+             << e.what() << endl;
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+    }
+    return 1;
 }
 
 /**
  * @brief Главная функция программы
+ * @param argc количество аргументов
+ * @param argv аргументы неинтерактивного режима: -k КЛЮЧ (-e|-d) [-j N]
+ * [-i ВХОД -o ВЫХОД [-q ГЛУБИНА | -p | -s]];
+ * без аргументов запускается диалог
  * @return код завершения программы
  * @details Реализует диалоговый интерфейс для шифрования/расшифрования
  */
  
-int main()
+int main(int argc, char** argv)
 {
     setlocale(LC_ALL, "ru_RU.UTF-8");
+    if (argc > 1) {
+        pipeArgs args;
+        if (!parsePipeArgs(argc, argv, args)) {
+            cerr << "Использование: " << argv[0] << " -k КЛЮЧ (-e|-d) [-j ПОТОКОВ] [-i ВХОД -o ВЫХОД [-q ГЛУБИНА | -p | -s]]" << endl;
+            return 2;
+        }
+        return runPipe(args);
+    }
+
 
     string keyLine;
     string msgLine;
@@ -77,11 +146,9 @@ int main()
 
                 try {
                     if (action == 1) {
-                        wstring enc = cipher.encrypt(str8_to_w(msgLine));
-                        cout << "Зашифровано: " << w_to_str8(enc) << endl;
+                        cout << "Зашифровано: " << cipher.encryptUtf8(msgLine) << endl;
                     } else {
-                        wstring dec = cipher.decrypt(str8_to_w(msgLine));
-                        cout << "Расшифровано: " << w_to_str8(dec) << endl;
+                        cout << "Расшифровано: " << cipher.decryptUtf8(msgLine) << endl;
                     }
                 } catch (const cipher_error& e) {
                     cerr << "Ошибка при обработке текста: " << e.what() << endl;
@@ -7,6 +7,13 @@
  */
 
 #include "modAlphaCipher.h"
+#include "gronsfeldKernel.h"
+#include "../common/ruAlphabet.h"
+#include "../common/threadPool.h"
+#include "../common/ruUtf8.h"
+#include "../common/ruTranscode.h"
+#include "../common/packedText.h"
+#include <algorithm>
 using namespace std;
 
 /**
@@ -14,44 +21,61 @@ using namespace std;
  * @param keyStr строковый ключ для шифрования
  * @throw cipher_error если ключ невалиден
  */
-modAlphaCipher::modAlphaCipher(const wstring& keyStr)
+modAlphaCipher::modAlphaCipher(const wstring& keyStr):
+    keySeq(toNums(getValidKey(keyStr), false)),
+    keyFwd(gronsfeldKeyStream(keySeq, false)),
+    keyBack(gronsfeldKeyStream(keySeq, true))
 {
-    // Инициализация ассоциативного массива
-    for (unsigned k = 0; k < alphabet.size(); ++k) {
-        alphaIndex[alphabet[k]] = k;
-    }
-    keySeq = toNums(getValidKey(keyStr));
 }
 
 /**
- * @brief Преобразование строки в числовой вектор
+ * @brief Преобразование текста в номера букв в буфер вызывающего
  * @param s входная строка
- * @return вектор чисел, соответствующих символам строки
+ * @param back true — шифртекст (проверяется), false — открытый текст
+ * @param out номера букв; достаточно s.size() элементов
+ * @return количество букв
+ * @details Шифртекст проверяется до первого недопустимого символа,
+ * поэтому сообщение определяется первой ошибкой, как в checkCipherText
+ * @throw cipher_error если шифртекст содержит пробелы или недопустимые символы
  */
  
-vector<int> modAlphaCipher::toNums(const wstring& s)
+size_t modAlphaCipher::toNums(wstring_view s, bool back, uint8_t* out) const
 {
-    vector<int> resultNums;
-    resultNums.reserve(s.size());
-    for (auto sym : s) {
-        resultNums.push_back(alphaIndex[sym]);
-    }
-    return resultNums;
+    if (!back)
+        return ruDecodeOpen(s, out);
+    ruDecodeResult res = ruDecodeCipher(s, out);
+    if (res.status == RU_TEXT_SPACE)
+        throw cipher_error("Whitespace in cipher text");
+    if (res.status == RU_TEXT_INVALID)
+        throw cipher_error("Invalid character in cipher text");
+    return res.letters;
 }
 
 /**
- * @brief Преобразование числового вектора в строку
- * @param v входной вектор чисел
- * @return строка, составленная из символов алфавита
+ * @brief Преобразование текста в номера букв
+ * @param s входная строка
+ * @param back true — шифртекст (проверяется), false — открытый текст
+ * @return номера букв
+ * @throw cipher_error если шифртекст содержит пробелы или недопустимые символы
  */
  
-wstring modAlphaCipher::toStr(const vector<int>& v)
+letterBuffer modAlphaCipher::toNums(wstring_view s, bool back) const
 {
-    wstring resultStr;
-    resultStr.reserve(v.size());
-    for (auto idx : v) {
-        resultStr.push_back(alphabet[idx]);
-    }
+    letterBuffer v(s.size());
+    v.resize(toNums(s, back, v.data()));
+    return v;
+}
+
+/**
+ * @brief Преобразование номеров букв в строку
+ * @param v номера букв
+ * @return строка, составленная из прописных букв алфавита
+ */
+ 
+wstring modAlphaCipher::toStr(const letterBuffer& v) const
+{
+    wstring resultStr(v.size(), L' ');
+    ruEncodeUpper(v.data(), v.size(), &resultStr[0]);
     return resultStr;
 }
 
@@ -62,37 +86,30 @@ wstring modAlphaCipher::toStr(const vector<int>& v)
  * @throw cipher_error если ключ пустой, содержит пробелы, недопустимые символы или вырожден
  */
  
-wstring modAlphaCipher::getValidKey(const wstring& s)
+wstring modAlphaCipher::getValidKey(const wstring& s) const
 {
     wstring tmp;
+    bool hasSpace = false;
+    bool invalid = false;
     for (auto c : s) {
-        if (!iswspace(c)) {
+        uint8_t cls = ruClassify(c);
+        if (cls == RU_CLASS_SPACE) {
+            hasSpace = true;
+        } else if (ruIsLetter(cls)) {
+            // Преобразование строчных в прописные
+            tmp.push_back(RU_UPPER[ruIndex(cls)]);
+        } else {
             tmp.push_back(c);
+            invalid = true;
         }
     }
     
     if (tmp.empty())
         throw cipher_error("Empty key");
-    
-    // Проверка на пробелы в исходной строке
-    for (auto c : s) {
-        if (iswspace(c)) {
-            throw cipher_error("Whitespace in key");
-        }
-    }
-    
-    wstring lower = L"абвгдеёжзийклмнопрстуфхцчшщъыьэюя";
-    wstring upper = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
-    
-    for (auto & c : tmp) {
-        // Преобразование строчных в прописные
-        size_t pos = lower.find(c);
-        if (pos != wstring::npos) {
-            c = upper[pos];
-        } else if (alphabet.find(c) == wstring::npos) {
-            throw cipher_error("Invalid key");
-        }
-    }
+    if (hasSpace)
+        throw cipher_error("Whitespace in key");
+    if (invalid)
+        throw cipher_error("Invalid key");
     
     // Проверка на вырожденный ключ (все символы одинаковые)
     bool allSame = true;
@@ -113,30 +130,15 @@ wstring modAlphaCipher::getValidKey(const wstring& s)
 }
 
 /**
- * @brief Валидация и нормализация открытого текста
+ * @brief Валидация открытого текста
  * @param s исходный открытый текст
- * @return валидированный текст в верхнем регистре без пробелов и не-букв
+ * @return номера букв текста, пробелы и не-буквы удалены
  * @throw cipher_error если текст пустой после обработки
  */
  
-wstring modAlphaCipher::getValidOpenText(const wstring& s)
+letterBuffer modAlphaCipher::getValidOpenText(wstring_view s) const
 {
-    wstring tmp;
-    wstring lower = L"абвгдеёжзийклмнопрстуфхцчшщъыьэюя";
-    wstring upper = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
-    
-    for (auto c : s) {
-        if (!iswspace(c)) { // Игнорируем пробелы
-            if (alphabet.find(c) != wstring::npos) {
-                tmp.push_back(c);
-            } else {
-                size_t pos = lower.find(c);
-                if (pos != wstring::npos) {
-                    tmp.push_back(upper[pos]); 
-                }
-            }
-        }
-    }
+    letterBuffer tmp = toNums(s, false);
     if (tmp.empty())
         throw cipher_error("Empty open text");
     return tmp;
@@ -145,24 +147,13 @@ wstring modAlphaCipher::getValidOpenText(const wstring& s)
 /**
  * @brief Валидация зашифрованного текста
  * @param s исходный зашифрованный текст
- * @return валидированный зашифрованный текст
+ * @return номера букв текста
  * @throw cipher_error если текст пустой или содержит недопустимые символы
  */
  
-wstring modAlphaCipher::getValidCipherText(const wstring& s)
+letterBuffer modAlphaCipher::getValidCipherText(wstring_view s) const
 {
-    wstring tmp;
-    
-    // Проверяем есть ли пробелы или недопустимые символы
-    for (auto c : s) {
-        if (iswspace(c)) {
-            throw cipher_error("Whitespace in cipher text");
-        }
-        if (alphabet.find(c) == wstring::npos) {
-            throw cipher_error("Invalid character in cipher text");
-        }
-        tmp.push_back(c);
-    }
+    letterBuffer tmp = toNums(s, true);
     
     if (tmp.empty())
         throw cipher_error("Empty cipher text");
@@ -170,6 +161,37 @@ wstring modAlphaCipher::getValidCipherText(const wstring& s)
     return tmp;
 }
 
+/**
+ * @brief Проверка символов зашифрованного текста без проверки на пустоту
+ * @param s исходный зашифрованный текст
+ * @throw cipher_error если текст содержит пробелы или недопустимые символы
+ */
+ 
+void modAlphaCipher::checkCipherText(wstring_view s) const
+{
+    // Проверка без записи номеров, ошибка определяется первым недопустимым символом
+    ruDecodeResult res = ruDecodeCipher(s, nullptr);
+    if (res.status == RU_TEXT_SPACE)
+        throw cipher_error("Whitespace in cipher text");
+    if (res.status == RU_TEXT_INVALID)
+        throw cipher_error("Invalid character in cipher text");
+}
+
+/**
+ * @brief Наложение ключа на числовой вектор векторным ядром
+ * @param v номера букв, изменяются на месте
+ * @param n количество букв
+ * @param phase позиция в ключе, соответствующая первому элементу
+ * @param back true — вычитание ключа (расшифрование), false — сложение
+ * @details Вычитание ключа выполняется как сложение с ключом 33 - k
+ */
+ 
+void modAlphaCipher::applyKey(uint8_t* v, size_t n, size_t phase, bool back) const
+{
+    const vector<uint8_t>& ks = back ? keyBack : keyFwd;
+    gronsfeldAdd(v, n, ks.data(), keySeq.size(), phase % keySeq.size());
+}
+
 /**
  * @brief Шифрование открытого текста
  * @param plain открытый текст для шифрования
@@ -177,12 +199,12 @@ wstring modAlphaCipher::getValidCipherText(const wstring& s)
  * @throw cipher_error если открытый текст невалиден
  */
  
-wstring modAlphaCipher::encrypt(const wstring& plain)
+wstring modAlphaCipher::encrypt(const wstring& plain) const
 {
-    vector<int> tmp = toNums(getValidOpenText(plain));
-    for (unsigned p = 0; p < tmp.size(); ++p) {
-        tmp[p] = (tmp[p] + keySeq[p % keySeq.size()]) % alphabet.size();
-    }
+    if (pool && plain.size() >= parallelThreshold)
+        return runParallel(plain, false);
+    letterBuffer tmp = getValidOpenText(plain);
+    applyKey(tmp.data(), tmp.size(), 0, false);
     return toStr(tmp);
 }
 
@@ -193,11 +215,487 @@ wstring modAlphaCipher::encrypt(const wstring& plain)
  * @throw cipher_error если зашифрованный текст невалиден
  */
  
-wstring modAlphaCipher::decrypt(const wstring& cipher)
+wstring modAlphaCipher::decrypt(const wstring& cipher) const
 {
-    vector<int> tmp = toNums(getValidCipherText(cipher));
-    for (unsigned p = 0; p < tmp.size(); ++p) {
-        tmp[p] = (tmp[p] + alphabet.size() - keySeq[p % keySeq.size()]) % alphabet.size();
-    }
+    if (pool && cipher.size() >= parallelThreshold)
+        return runParallel(cipher, true);
+    letterBuffer tmp = getValidCipherText(cipher);
+    applyKey(tmp.data(), tmp.size(), 0, true);
+    return toStr(tmp);
+}
+
+/**
+ * @brief Проверка открытого текста теми же правилами, что и в encrypt
+ * @param plain открытый текст
+ * @return количество букв
+ * @details Вызывает getValidOpenText без последующего шифрования
+ * @throw cipher_error если текст пустой после удаления не-букв
+ */
+ 
+size_t modAlphaCipher::validateOpenText(wstring_view plain) const
+{
+    return getValidOpenText(plain).size();
+}
+
+/**
+ * @brief Проверка зашифрованного текста теми же правилами, что и в decrypt
+ * @param cipher зашифрованный текст
+ * @return количество букв
+ * @details Вызывает getValidCipherText без последующего расшифрования
+ * @throw cipher_error если текст пустой или содержит недопустимые символы
+ */
+ 
+size_t modAlphaCipher::validateCipherText(wstring_view cipher) const
+{
+    return getValidCipherText(cipher).size();
+}
+
+/**
+ * @brief Шифрование открытого текста в UTF-8 без преобразования в wstring
+ * @param plain открытый текст в UTF-8
+ * @return шифртекст в UTF-8
+ * @throw cipher_error если в тексте нет букв
+ */
+ 
+string modAlphaCipher::encryptUtf8(string_view plain) const
+{
+    letterBuffer tmp(plain.size() / RU_UTF8_LETTER);
+    size_t n = ruDecodeOpen(plain.data(), plain.size(), tmp.data());
+    if (n == 0)
+        throw cipher_error("Empty open text");
+    applyKey(tmp.data(), n, 0, false);
+    string out(RU_UTF8_LETTER * n, '\0');
+    ruEncodeUpper(tmp.data(), n, &out[0]);
+    return out;
+}
+
+/**
+ * @brief Расшифрование шифртекста в UTF-8 без преобразования в wstring
+ * @param cipher шифртекст в UTF-8
+ * @return открытый текст в UTF-8
+ * @details Ошибка определяется первым недопустимым символом, как в checkCipherText
+ * @throw cipher_error если текст пустой или содержит недопустимые символы
+ */
+ 
+string modAlphaCipher::decryptUtf8(string_view cipher) const
+{
+    if (cipher.empty())
+        throw cipher_error("Empty cipher text");
+    letterBuffer tmp(cipher.size() / RU_UTF8_LETTER);
+    ruDecodeResult res = ruDecodeCipher(cipher.data(), cipher.size(), tmp.data());
+    if (res.status == RU_TEXT_SPACE)
+        throw cipher_error("Whitespace in cipher text");
+    if (res.status == RU_TEXT_INVALID)
+        throw cipher_error("Invalid character in cipher text");
+    applyKey(tmp.data(), res.letters, 0, true);
+    string out(RU_UTF8_LETTER * res.letters, '\0');
+    ruEncodeUpper(tmp.data(), res.letters, &out[0]);
+    return out;
+}
+
+/**
+ * @brief Отпечаток ключа для заголовка упакованного формата
+ * @return FNV-1a 64 номеров букв ключа
+ */
+ 
+uint64_t modAlphaCipher::keyFingerprint() const
+{
+    return fnv1a64(keySeq.data(), keySeq.size());
+}
+
+/**
+ * @brief Шифрование открытого текста в упакованный контейнер
+ * @param plain открытый текст в UTF-8
+ * @return заголовок packedText и шифртекст по 6 бит на букву
+ * @throw cipher_error если в тексте нет букв
+ */
+ 
+string modAlphaCipher::encryptPacked(string_view plain) const
+{
+    letterBuffer tmp(plain.size() / RU_UTF8_LETTER);
+    size_t n = ruDecodeOpen(plain.data(), plain.size(), tmp.data());
+    if (n == 0)
+        throw cipher_error("Empty open text");
+    applyKey(tmp.data(), n, 0, false);
+    return packedEncode({PACKED_GRONSFELD, n, keyFingerprint()}, tmp.data());
+}
+
+/**
+ * @brief Расшифрование упакованного контейнера
+ * @param packed контейнер, записанный encryptPacked с тем же ключом
+ * @return открытый текст в UTF-8
+ * @throw cipher_error если контейнер поврежден, пуст, записан другим
+ * шифром или с другим ключом
+ */
+ 
+string modAlphaCipher::decryptPacked(string_view packed) const
+{
+    letterBuffer tmp;
+    packedStatus status = packedDecode(packed, PACKED_GRONSFELD, keyFingerprint(), tmp);
+    if (status != PACKED_OK)
+        throw cipher_error(packedMessage(status));
+    if (tmp.empty())
+        throw cipher_error("Empty cipher text");
+    applyKey(tmp.data(), tmp.size(), 0, true);
+    string out(RU_UTF8_LETTER * tmp.size(), '\0');
+    ruEncodeUpper(tmp.data(), tmp.size(), &out[0]);
+    return out;
+}
+
+/**
+ * @brief Расшифрование диапазона букв шифртекста в UTF-8
+ * @param cipher весь шифртекст в UTF-8
+ * @param offset номер первой буквы диапазона
+ * @param length количество букв; обрезается по концу шифртекста
+ * @return открытый текст диапазона в UTF-8
+ * @details Каждая буква шифртекста занимает два байта, поэтому диапазон
+ * начинается с байта 2 * offset, а ключ — с позиции offset % keySeq.size()
+ * @throw cipher_error если шифртекст пуст, имеет нечетную длину, offset
+ * за концом или диапазон содержит недопустимые символы
+ */
+ 
+string modAlphaCipher::decryptRange(string_view cipher, size_t offset, size_t length) const
+{
+    if (cipher.empty())
+        throw cipher_error("Empty cipher text");
+    if (cipher.size() % RU_UTF8_LETTER != 0)
+        throw cipher_error("Invalid character in cipher text");
+    size_t total = cipher.size() / RU_UTF8_LETTER;
+    if (offset > total)
+        throw cipher_error("Range out of cipher text");
+    length = min(length, total - offset);
+    letterBuffer tmp(length);
+    ruDecodeResult res = ruDecodeCipher(cipher.data() + RU_UTF8_LETTER * offset,
+                                        RU_UTF8_LETTER * length, tmp.data());
+    if (res.status == RU_TEXT_SPACE)
+        throw cipher_error("Whitespace in cipher text");
+    if (res.status == RU_TEXT_INVALID)
+        throw cipher_error("Invalid character in cipher text");
+    applyKey(tmp.data(), length, offset, true);
+    string out(RU_UTF8_LETTER * length, '\0');
+    ruEncodeUpper(tmp.data(), length, &out[0]);
+    return out;
+}
+
+/**
+ * @brief Расшифрование диапазона букв широкого шифртекста
+ * @param cipher весь шифртекст
+ * @param offset номер первой буквы диапазона
+ * @param length количество букв; обрезается по концу шифртекста
+ * @return открытый текст диапазона
+ * @throw cipher_error если шифртекст пуст, offset за концом или диапазон
+ * содержит недопустимые символы
+ */
+ 
+wstring modAlphaCipher::decryptRange(wstring_view cipher, size_t offset, size_t length) const
+{
+    if (cipher.empty())
+        throw cipher_error("Empty cipher text");
+    if (offset > cipher.size())
+        throw cipher_error("Range out of cipher text");
+    letterBuffer tmp = toNums(cipher.substr(offset, length), true);
+    applyKey(tmp.data(), tmp.size(), offset, true);
     return toStr(tmp);
 }
+
+/**
+ * @brief Пакетное шифрование многих открытых текстов за один вызов
+ * @param plains открытые тексты
+ * @return зашифрованные тексты в одном буфере с таблицей смещений
+ * @throw cipher_error если хотя бы один текст невалиден
+ */
+ 
+textBatch modAlphaCipher::encryptBatch(span<const wstring_view> plains) const
+{
+    return runBatch(plains, false);
+}
+
+/**
+ * @brief Пакетное расшифрование многих зашифрованных текстов за один вызов
+ * @param ciphers зашифрованные тексты
+ * @return расшифрованные тексты в одном буфере с таблицей смещений
+ * @throw cipher_error если хотя бы один текст невалиден
+ */
+ 
+textBatch modAlphaCipher::decryptBatch(span<const wstring_view> ciphers) const
+{
+    return runBatch(ciphers, true);
+}
+
+/**
+ * @brief Пакетное шифрование или расшифрование
+ * @param texts исходные тексты
+ * @param back true — расшифрование, false — шифрование
+ * @return результаты в одном буфере
+ * @details Результат не длиннее исходного текста, поэтому общий буфер
+ * выделяется один раз по суммарной длине пакета. Номера букв очередного
+ * текста записываются в один переиспользуемый буфер длины самого длинного текста.
+ * @throw cipher_error если хотя бы один текст невалиден
+ */
+ 
+textBatch modAlphaCipher::runBatch(span<const wstring_view> texts, bool back) const
+{
+    size_t total = 0;
+    size_t longest = 0;
+    for (auto t : texts) {
+        total += t.size();
+        longest = max(longest, t.size());
+    }
+    textBatch out;
+    out.text.reserve(total);
+    out.offsets.reserve(texts.size() + 1);
+    out.offsets.push_back(0);
+    letterBuffer nums(longest);
+    
+    for (size_t i = 0; i < texts.size(); ++i) {
+        size_t n = 0;
+        try {
+            n = toNums(texts[i], back, nums.data());
+            if (n == 0)
+                throw cipher_error(back ? "Empty cipher text" : "Empty open text");
+        } catch (const cipher_error& e) {
+            throw cipher_error(string(e.what()) + " in batch item " + to_string(i));
+        }
+        applyKey(nums.data(), n, 0, back);
+        size_t from = out.text.size();
+        out.text.resize(from + n);
+        ruEncodeUpper(nums.data(), n, &out.text[from]);
+        out.offsets.push_back(out.text.size());
+    }
+    return out;
+}
+
+/**
+ * @brief Шифрование или расшифрование в буфер вызывающего без выделения памяти
+ * @param in исходный текст
+ * @param out буфер результата, может совпадать с началом in
+ * @param cap размер буфера результата
+ * @param back true — расшифрование (in уже проверен), false — шифрование
+ * @return количество записанных букв
+ * @details Номера букв отрезков входа по INTO_BLOCK символов собираются
+ * в массив на стеке, к блоку применяется ядро, и результат пишется в out.
+ * Позиция записи никогда не обгоняет позицию чтения, поэтому out может
+ * совпадать с in.
+ * @throw cipher_error если буфер мал или в открытом тексте нет букв
+ */
+ 
+size_t modAlphaCipher::runInto(wstring_view in, wchar_t* out, size_t cap, bool back) const
+{
+    uint8_t block[INTO_BLOCK];
+    size_t written = 0;
+    
+    for (size_t pos = 0; pos < in.size(); pos += INTO_BLOCK) {
+        size_t len = ruDecodeOpen(in.substr(pos, INTO_BLOCK), block);
+        if (written + len > cap)
+            throw cipher_error("Output buffer too small");
+        applyKey(block, len, written, back);
+        ruEncodeUpper(block, len, out + written);
+        written += len;
+    }
+    if (written == 0)
+        throw cipher_error(back ? "Empty cipher text" : "Empty open text");
+    return written;
+}
+
+/**
+ * @brief Шифрование в буфер вызывающего без выделения памяти
+ * @param plain открытый текст
+ * @param out буфер результата
+ * @return количество записанных букв
+ * @throw cipher_error если текст невалиден или буфер мал
+ */
+ 
+size_t modAlphaCipher::encrypt(wstring_view plain, span<wchar_t> out) const
+{
+    return runInto(plain, out.data(), out.size(), false);
+}
+
+/**
+ * @brief Расшифрование в буфер вызывающего без выделения памяти
+ * @param cipher зашифрованный текст
+ * @param out буфер результата
+ * @return количество записанных букв
+ * @throw cipher_error если текст невалиден или буфер мал
+ */
+ 
+size_t modAlphaCipher::decrypt(wstring_view cipher, span<wchar_t> out) const
+{
+    checkCipherText(cipher);
+    return runInto(cipher, out.data(), out.size(), true);
+}
+
+/**
+ * @brief Шифрование на месте
+ * @param buf открытый текст; после вызова начало буфера содержит шифртекст
+ * @return длина шифртекста
+ * @throw cipher_error если текст невалиден
+ */
+ 
+size_t modAlphaCipher::encryptInPlace(span<wchar_t> buf) const
+{
+    return runInto(wstring_view(buf.data(), buf.size()), buf.data(), buf.size(), false);
+}
+
+/**
+ * @brief Расшифрование на месте
+ * @param buf шифртекст; после вызова содержит открытый текст той же длины
+ * @return длина открытого текста
+ * @throw cipher_error если текст невалиден
+ */
+ 
+size_t modAlphaCipher::decryptInPlace(span<wchar_t> buf) const
+{
+    wstring_view view(buf.data(), buf.size());
+    checkCipherText(view);
+    return runInto(view, buf.data(), buf.size(), true);
+}
+
+/**
+ * @brief Включение параллельного режима на общем пуле потоков
+ * @param p пул потоков, nullptr отключает параллельный режим
+ * @param threshold минимальная длина текста, при которой используется пул
+ */
+ 
+void modAlphaCipher::setParallel(shared_ptr<threadPool> p, size_t threshold)
+{
+    pool = move(p);
+    parallelThreshold = threshold;
+}
+
+/**
+ * @brief Включение параллельного режима на собственном пуле
+ * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+ * @param threshold минимальная длина текста, при которой используется пул
+ */
+ 
+void modAlphaCipher::setParallel(unsigned threads, size_t threshold)
+{
+    if (threads == 1) {
+        setParallel(nullptr, threshold);
+    } else {
+        setParallel(make_shared<threadPool>(threads), threshold);
+    }
+}
+
+/**
+ * @brief Параллельное шифрование или расшифрование на пуле потоков
+ * @param text исходный текст
+ * @param back true — расшифрование, false — шифрование
+ * @return результат, совпадающий с однопоточным encrypt/decrypt
+ * @details Первый проход по частям текста параллельно отбирает и нумерует буквы.
+ * По длинам частей вычисляется начальная позиция в ключе для каждой части,
+ * после чего второй проход параллельно накладывает ключ и пишет результат
+ * в общую строку на своем смещении.
+ * @throw cipher_error если текст невалиден
+ */
+ 
+wstring modAlphaCipher::runParallel(const wstring& text, bool back) const
+{
+    size_t parts = pool->size();
+    size_t chunk = (text.size() + parts - 1) / parts;
+    vector<letterBuffer> nums(parts);
+    wstring_view view(text);
+    
+    pool->parallelFor(parts, [&](size_t i) {
+        size_t from = min(text.size(), i * chunk);
+        nums[i] = toNums(view.substr(from, chunk), back);
+    });
+    
+    vector<size_t> offset(parts + 1, 0);
+    for (size_t i = 0; i < parts; ++i) {
+        offset[i + 1] = offset[i] + nums[i].size();
+    }
+    if (offset[parts] == 0)
+        throw cipher_error(back ? "Empty cipher text" : "Empty open text");
+    
+    wstring out(offset[parts], L' ');
+    pool->parallelFor(parts, [&](size_t i) {
+        applyKey(nums[i].data(), nums[i].size(), offset[i], back);
+        ruEncodeUpper(nums[i].data(), nums[i].size(), &out[offset[i]]);
+    });
+    return out;
+}
+
+/**
+ * @brief Конструктор потокового сеанса
+ * @param c шифр с установленным ключом
+ * @param decrypt true — расшифрование, false — шифрование
+ */
+ 
+modAlphaStream::modAlphaStream(const modAlphaCipher& c, bool decrypt):
+    cipher(c), back(decrypt)
+{
+}
+
+/**
+ * @brief Обработка очередной части текста
+ * @param chunk часть открытого или зашифрованного текста
+ * @return результат для этой части
+ * @details Позиция в ключе продолжается с места, где остановилась предыдущая часть
+ * @throw cipher_error если часть зашифрованного текста невалидна
+ */
+ 
+wstring modAlphaStream::update(const wstring& chunk)
+{
+    letterBuffer tmp = cipher.toNums(chunk, back);
+    cipher.applyKey(tmp.data(), tmp.size(), total, back);
+    total += tmp.size();
+    return cipher.toStr(tmp);
+}
+
+/**
+ * @brief Обработка очередной части текста в UTF-8
+ * @param data часть текста; может обрываться посреди символа
+ * @param len длина части в байтах
+ * @param out результат для этой части дописывается в конец (UTF-8)
+ * @details Номера букв собираются в блок на стеке и проходят через ядро
+ * с текущей позицией в ключе. Символ, оборванный на конце части, хранится
+ * в сеансе и дочитывается из начала следующей.
+ * @throw cipher_error если часть зашифрованного текста невалидна
+ */
+ 
+void modAlphaStream::update(const char* data, size_t len, string& out)
+{
+    uint8_t block[modAlphaCipher::INTO_BLOCK];
+    size_t n = 0;
+    
+    auto flush = [&] {
+        cipher.applyKey(block, n, total, back);
+        size_t at = out.size();
+        out.resize(at + RU_UTF8_LETTER * n);
+        ruEncodeUpper(block, n, &out[at]);
+        total += n;
+        n = 0;
+    };
+    auto take = [&](wchar_t c) {
+        uint8_t cls = ruClassify(c);
+        if (back) {
+            if (cls == RU_CLASS_SPACE)
+                throw cipher_error("Whitespace in cipher text");
+            if (!ruIsUpper(cls))
+                throw cipher_error("Invalid character in cipher text");
+        }
+        if (ruIsLetter(cls)) {
+            block[n++] = ruIndex(cls);
+            if (n == modAlphaCipher::INTO_BLOCK)
+                flush();
+        }
+    };
+    
+    ruUtf8Feed(tail, tailLen, data, len, take);
+    flush();
+}
+
+/**
+ * @brief Завершение сеанса
+ * @throw cipher_error если за весь сеанс не было обработано ни одной буквы
+ * или зашифрованный текст в UTF-8 оборвался посреди символа
+ */
+ 
+void modAlphaStream::finish()
+{
+    if (back && tailLen > 0)
+        throw cipher_error("Invalid character in cipher text");
+    if (total == 0)
+        throw cipher_error(back ? "Empty cipher text" : "Empty open text");
+}
@@ -8,59 +8,80 @@
  * @warning Реализация для русского языка
  */
 
+#pragma once
 #include <vector>
 #include <string>
-#include <map>
 #include <locale>
 #include <codecvt>
 #include <stdexcept>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include "../common/cipherError.h"
+#include "../common/textBatch.h"
+#include "../common/ruTranscode.h"
+#include "../common/mappedFile.h"
+#include "../common/stagedPipeline.h"
 using namespace std;
 
-/**
- * @brief Класс-исключение для ошибок шифрования
- * @details Наследуется от std::invalid_argument
- */
-class cipher_error: public invalid_argument {
-public:
-    /**
-     * @brief Конструктор с параметром string
-     * @param what_arg сообщение об ошибке
-     */
-    explicit cipher_error (const string& what_arg):
-        invalid_argument(what_arg) {}
-    
-    /**
-     * @brief Конструктор с параметром const char*
-     * @param what_arg сообщение об ошибке
-     */
-    explicit cipher_error (const char* what_arg):
-        invalid_argument(what_arg) {}
-};
+class threadPool;
 
 /**
  * @brief Класс для шифрования методом Гронсфельда
- * @details Реализует шифрование и расшифрование текста на русском языке
+ * @details Реализует шифрование и расшифрование текста на русском языке.
+ * Внутри текст хранится только как номера букв (letterBuffer, байт на букву),
+ * широкие строки и UTF-8 преобразуются на входе и выходе методов.
+ * Ключевые потоки keyFwd и keyBack строятся в конструкторе и дальше
+ * только читаются, так что шифрования с одним ключом в разных потоках
+ * делят один экземпляр.
  */
 class modAlphaCipher
 {
+    friend class modAlphaStream;
+    friend class modAlphaReader;
 private:
-    wstring alphabet = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ"; ///< Русский алфавит
-    map<wchar_t, int> alphaIndex; ///< Ассоциативный массив "символ-номер"
-    vector<int> keySeq; ///< Числовая последовательность ключа
+    const letterBuffer keySeq; ///< Номера букв ключа
+    const vector<uint8_t> keyFwd; ///< Ключевой поток для шифрования
+    const vector<uint8_t> keyBack; ///< Ключевой поток для расшифрования
+    shared_ptr<threadPool> pool; ///< Пул потоков для больших текстов (может быть пустым)
+    size_t parallelThreshold = PARALLEL_THRESHOLD; ///< Минимальная длина текста для пула
+    
+    /**
+     * @brief Преобразование текста в номера букв в буфер вызывающего
+     * @param s входная строка
+     * @param back true — шифртекст (проверяется), false — открытый текст
+     * (не-буквы пропускаются)
+     * @param out номера букв; достаточно s.size() элементов
+     * @return количество букв
+     * @throw cipher_error если шифртекст содержит пробелы или недопустимые символы
+     */
+    size_t toNums(wstring_view s, bool back, uint8_t* out) const;
     
     /**
-     * @brief Преобразование строки в числовой вектор
+     * @brief Преобразование текста в номера букв
      * @param s входная строка
-     * @return вектор чисел
+     * @param back true — шифртекст (проверяется), false — открытый текст
+     * @return номера букв
+     * @throw cipher_error если шифртекст содержит пробелы или недопустимые символы
+     */
+    letterBuffer toNums(wstring_view s, bool back) const;
+    
+    /**
+     * @brief Преобразование номеров букв в строку
+     * @param v номера букв
+     * @return строка прописных букв
      */
-    vector<int> toNums(const wstring& s);
+    wstring toStr(const letterBuffer& v) const;
     
     /**
-     * @brief Преобразование числового вектора в строку
-     * @param v входной вектор
-     * @return строка
+     * @brief Наложение ключа на числовой вектор векторным ядром
+     * @param v номера букв, изменяются на месте
+     * @param n количество букв
+     * @param phase позиция в ключе, соответствующая первому элементу
+     * @param back true — вычитание ключа (расшифрование), false — сложение
      */
-    wstring toStr(const vector<int>& v);
+    void applyKey(uint8_t* v, size_t n, size_t phase, bool back) const;
     
     /**
      * @brief Валидация и нормализация ключа
@@ -68,25 +89,87 @@ private:
      * @return валидированный ключ
      * @throw cipher_error если ключ пустой, содержит недопустимые символы или вырожден
      */
-    wstring getValidKey(const wstring& s);
+    wstring getValidKey(const wstring& s) const;
     
     /**
-     * @brief Валидация и нормализация открытого текста
+     * @brief Валидация открытого текста
      * @param s исходный открытый текст
-     * @return валидированный открытый текст
+     * @return номера букв текста
      * @throw cipher_error если текст пустой после удаления не-букв
      */
-    wstring getValidOpenText(const wstring& s);
+    letterBuffer getValidOpenText(wstring_view s) const;
     
     /**
      * @brief Валидация зашифрованного текста
      * @param s исходный зашифрованный текст
-     * @return валидированный зашифрованный текст
+     * @return номера букв текста
      * @throw cipher_error если текст пустой или содержит недопустимые символы
      */
-    wstring getValidCipherText(const wstring& s);
+    letterBuffer getValidCipherText(wstring_view s) const;
+    
+    /**
+     * @brief Проверка символов зашифрованного текста без проверки на пустоту
+     * @param s исходный зашифрованный текст
+     * @throw cipher_error если текст содержит пробелы или недопустимые символы
+     */
+    void checkCipherText(wstring_view s) const;
+    
+    /**
+     * @brief Пакетное шифрование или расшифрование
+     * @param texts исходные тексты
+     * @param back true — расшифрование, false — шифрование
+     * @return результаты в одном буфере
+     * @throw cipher_error если хотя бы один текст невалиден
+     */
+    textBatch runBatch(span<const wstring_view> texts, bool back) const;
+    
+    /**
+     * @brief Шифрование или расшифрование в буфер вызывающего без выделения памяти
+     * @param in исходный текст
+     * @param out буфер результата, может совпадать с началом in
+     * @param cap размер буфера результата
+     * @param back true — расшифрование (in уже проверен), false — шифрование
+     * @return количество записанных букв
+     * @throw cipher_error если буфер мал или в открытом тексте нет букв
+     */
+    size_t runInto(wstring_view in, wchar_t* out, size_t cap, bool back) const;
+    
+    /**
+     * @brief Параллельное шифрование или расшифрование на пуле потоков
+     * @param text исходный текст
+     * @param back true — расшифрование, false — шифрование
+     * @return результат, совпадающий с однопоточным encrypt/decrypt
+     * @throw cipher_error если текст невалиден
+     */
+    wstring runParallel(const wstring& text, bool back) const;
+    
+    /**
+     * @brief Шифрование или расшифрование файла UTF-8 через отображение в память
+     * @param inPath путь к исходному файлу
+     * @param outPath путь к результату
+     * @param back true — расшифрование, false — шифрование
+     * @param memoryBudget ограничение на объем страниц в памяти процесса, байт
+     * @throw cipher_error если текст невалиден
+     * @throw system_error при ошибке ввода-вывода
+     */
+    void runFile(const string& inPath, const string& outPath, bool back, size_t memoryBudget) const;
+    
+    /**
+     * @brief Отпечаток ключа для заголовка упакованного формата
+     * @return FNV-1a 64 номеров букв ключа
+     */
+    uint64_t keyFingerprint() const;
     
 public:
+    /// Длина текста по умолчанию, начиная с которой используется пул
+    static const size_t PARALLEL_THRESHOLD = 1 << 20;
+    
+    /// Размер блока номеров букв на стеке для API без выделения памяти
+    static const size_t INTO_BLOCK = 4096;
+    
+    /// Бюджет памяти по умолчанию для шифрования файлов, байт
+    static const size_t FILE_BUDGET = size_t(256) << 20;
+    
     /**
      * @brief Удаленный конструктор по умолчанию
      */
@@ -99,13 +182,28 @@ public:
      */
     modAlphaCipher(const wstring& keyStr);
     
+    /**
+     * @brief Включение параллельного режима на общем пуле потоков
+     * @param p пул потоков, nullptr отключает параллельный режим
+     * @param threshold минимальная длина текста, при которой используется пул
+     * @details Не синхронизируется с шифрованием в других потоках
+     */
+    void setParallel(shared_ptr<threadPool> p, size_t threshold = PARALLEL_THRESHOLD);
+    
+    /**
+     * @brief Включение параллельного режима на собственном пуле
+     * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+     * @param threshold минимальная длина текста, при которой используется пул
+     */
+    void setParallel(unsigned threads, size_t threshold = PARALLEL_THRESHOLD);
+    
     /**
      * @brief Шифрование открытого текста
      * @param plain открытый текст
      * @return зашифрованный текст
      * @throw cipher_error если текст невалиден
      */
-    wstring encrypt(const wstring& plain);
+    wstring encrypt(const wstring& plain) const;
     
     /**
      * @brief Расшифрование зашифрованного текста
@@ -113,5 +211,289 @@ public:
      * @return расшифрованный текст
      * @throw cipher_error если текст невалиден
      */
-    wstring decrypt(const wstring& cipher);
+    wstring decrypt(const wstring& cipher) const;
+    
+    /**
+     * @brief Проверка открытого текста теми же правилами, что и в encrypt
+     * @param plain открытый текст
+     * @return количество букв
+     * @throw cipher_error если текст пустой после удаления не-букв
+     */
+    size_t validateOpenText(wstring_view plain) const;
+    
+    /**
+     * @brief Проверка зашифрованного текста теми же правилами, что и в decrypt
+     * @param cipher зашифрованный текст
+     * @return количество букв
+     * @throw cipher_error если текст пустой или содержит недопустимые символы
+     */
+    size_t validateCipherText(wstring_view cipher) const;
+    
+    /**
+     * @brief Шифрование открытого текста в UTF-8 без преобразования в wstring
+     * @param plain открытый текст в UTF-8
+     * @return шифртекст в UTF-8
+     * @details Текст декодируется сразу в номера букв (ruDecodeOpen),
+     * результат кодируется из номеров (ruEncodeUpper)
+     * @throw cipher_error если в тексте нет букв
+     */
+    string encryptUtf8(string_view plain) const;
+    
+    /**
+     * @brief Расшифрование шифртекста в UTF-8 без преобразования в wstring
+     * @param cipher шифртекст в UTF-8
+     * @return открытый текст в UTF-8
+     * @throw cipher_error если текст пустой или содержит недопустимые символы
+     */
+    string decryptUtf8(string_view cipher) const;
+    
+    /**
+     * @brief Шифрование открытого текста в упакованный контейнер
+     * @param plain открытый текст в UTF-8
+     * @return заголовок packedText и шифртекст по 6 бит на букву
+     * @throw cipher_error если в тексте нет букв
+     */
+    string encryptPacked(string_view plain) const;
+    
+    /**
+     * @brief Расшифрование упакованного контейнера
+     * @param packed контейнер, записанный encryptPacked с тем же ключом
+     * @return открытый текст в UTF-8
+     * @throw cipher_error если контейнер поврежден, пуст, записан другим
+     * шифром или с другим ключом
+     */
+    string decryptPacked(string_view packed) const;
+    
+    /**
+     * @brief Расшифрование диапазона букв шифртекста в UTF-8
+     * @param cipher весь шифртекст в UTF-8 (например, отображенный файл)
+     * @param offset номер первой буквы диапазона
+     * @param length количество букв; обрезается по концу шифртекста
+     * @return открытый текст диапазона в UTF-8
+     * @details Буква p шифртекста занимает байты 2p и 2p + 1 и расшифровывается
+     * буквой ключа keySeq[p % keySeq.size()], поэтому читается и проверяется
+     * только сам диапазон, префикс не затрагивается. Результат совпадает
+     * с соответствующей частью decryptUtf8 для всего текста.
+     * @throw cipher_error если шифртекст пуст, имеет нечетную длину, offset
+     * больше числа букв или диапазон содержит недопустимые символы
+     */
+    string decryptRange(string_view cipher, size_t offset, size_t length) const;
+    
+    /**
+     * @brief Расшифрование диапазона букв широкого шифртекста
+     * @param cipher весь шифртекст
+     * @param offset номер первой буквы диапазона
+     * @param length количество букв; обрезается по концу шифртекста
+     * @return открытый текст диапазона, совпадающий с частью decrypt
+     * @throw cipher_error если шифртекст пуст, offset больше его длины или
+     * диапазон содержит недопустимые символы
+     */
+    wstring decryptRange(wstring_view cipher, size_t offset, size_t length) const;
+    
+    /**
+     * @brief Пакетное шифрование многих открытых текстов за один вызов
+     * @param plains открытые тексты
+     * @return зашифрованные тексты в одном буфере с таблицей смещений;
+     * каждый текст шифруется с начала ключа, как при вызове encrypt
+     * @throw cipher_error если хотя бы один текст невалиден (в сообщении указан номер)
+     */
+    textBatch encryptBatch(span<const wstring_view> plains) const;
+    
+    /**
+     * @brief Пакетное расшифрование многих зашифрованных текстов за один вызов
+     * @param ciphers зашифрованные тексты
+     * @return расшифрованные тексты в одном буфере с таблицей смещений
+     * @throw cipher_error если хотя бы один текст невалиден (в сообщении указан номер)
+     */
+    textBatch decryptBatch(span<const wstring_view> ciphers) const;
+    
+    /**
+     * @brief Шифрование в буфер вызывающего без выделения памяти
+     * @param plain открытый текст
+     * @param out буфер результата
+     * @return количество записанных букв
+     * @throw cipher_error если текст невалиден или буфер мал
+     */
+    size_t encrypt(wstring_view plain, span<wchar_t> out) const;
+    
+    /**
+     * @brief Расшифрование в буфер вызывающего без выделения памяти
+     * @param cipher зашифрованный текст
+     * @param out буфер результата
+     * @return количество записанных букв
+     * @throw cipher_error если текст невалиден или буфер мал
+     */
+    size_t decrypt(wstring_view cipher, span<wchar_t> out) const;
+    
+    /**
+     * @brief Шифрование на месте
+     * @param buf открытый текст; после вызова начало буфера содержит шифртекст
+     * @return длина шифртекста (не больше длины буфера)
+     * @throw cipher_error если текст невалиден
+     */
+    size_t encryptInPlace(span<wchar_t> buf) const;
+    
+    /**
+     * @brief Расшифрование на месте
+     * @param buf шифртекст; после вызова содержит открытый текст той же длины
+     * @return длина открытого текста
+     * @throw cipher_error если текст невалиден
+     */
+    size_t decryptInPlace(span<wchar_t> buf) const;
+    
+    /**
+     * @brief Шифрование файла UTF-8 в файл без загрузки текста в память
+     * @param inPath путь к открытому тексту
+     * @param outPath путь к результату (создается или перезаписывается)
+     * @param memoryBudget ограничение на объем страниц, одновременно
+     * находящихся в памяти процесса, байт
+     * @details Вход и выход отображаются в память, буквы идут через блок
+     * номеров на стеке; результат сначала получает размер входа, затем
+     * усекается до длины шифртекста
+     * @throw cipher_error если в тексте нет букв
+     * @throw system_error при ошибке ввода-вывода
+     */
+    void encryptFile(const string& inPath, const string& outPath,
+                     size_t memoryBudget = FILE_BUDGET) const;
+    
+    /**
+     * @brief Расшифрование файла UTF-8 в файл без загрузки текста в память
+     * @param inPath путь к шифртексту
+     * @param outPath путь к результату (создается или перезаписывается)
+     * @param memoryBudget ограничение на объем страниц в памяти процесса, байт
+     * @throw cipher_error если шифртекст невалиден
+     * @throw system_error при ошибке ввода-вывода
+     */
+    void decryptFile(const string& inPath, const string& outPath,
+                     size_t memoryBudget = FILE_BUDGET) const;
+    
+    /**
+     * @brief Стадии разбора и шифра для stagedPipeline
+     * @param decrypt true — расшифрование, false — шифрование
+     * @return набор стадий; ядро хранит позицию в ключе между блоками
+     * @details Результат конвейера совпадает с encryptUtf8/decryptUtf8 для
+     * всего входа. Шифртекст проверяется поблочно, поэтому сообщение
+     * определяется первым блоком с недопустимым символом
+     * @warning Набор хранит указатель на шифр, шифр должен существовать дольше
+     */
+    stageSet stages(bool decrypt) const;
+};
+
+/**
+ * @brief Потоковый сеанс шифрования/расшифрования методом Гронсфельда
+ * @details Принимает текст произвольными частями и сохраняет позицию в ключе
+ * между частями, поэтому результат совпадает с однократным вызовом
+ * modAlphaCipher::encrypt/decrypt для всего текста. Объем памяти не зависит
+ * от общей длины текста.
+ * @warning Сеанс хранит ссылку на шифр, шифр должен существовать дольше сеанса
+ */
+class modAlphaStream
+{
+private:
+    const modAlphaCipher& cipher; ///< Шифр с установленным ключом
+    bool back; ///< true — расшифрование, false — шифрование
+    size_t total = 0; ///< Количество обработанных букв (позиция в ключе)
+    unsigned char tail[4]; ///< Незавершенный символ UTF-8 с конца предыдущей части
+    size_t tailLen = 0; ///< Длина незавершенного символа
+    
+public:
+    /**
+     * @brief Удаленный конструктор по умолчанию
+     */
+    modAlphaStream() = delete;
+    
+    /**
+     * @brief Конструктор сеанса
+     * @param c шифр с установленным ключом
+     * @param decrypt true — расшифрование, false — шифрование
+     */
+    modAlphaStream(const modAlphaCipher& c, bool decrypt);
+    
+    /**
+     * @brief Обработка очередной части текста
+     * @param chunk часть открытого или зашифрованного текста
+     * @return результат для этой части (может быть пустым)
+     * @throw cipher_error если часть зашифрованного текста невалидна
+     */
+    wstring update(const wstring& chunk);
+    
+    /**
+     * @brief Обработка очередной части текста в UTF-8
+     * @param data часть текста; может обрываться посреди символа
+     * @param len длина части в байтах
+     * @param out результат для этой части дописывается в конец (UTF-8)
+     * @throw cipher_error если часть зашифрованного текста невалидна
+     */
+    void update(const char* data, size_t len, string& out);
+    
+    /**
+     * @brief Завершение сеанса
+     * @throw cipher_error если за весь сеанс не было обработано ни одной буквы
+     * или зашифрованный текст в UTF-8 оборвался посреди символа
+     */
+    void finish();
+    
+    /**
+     * @brief Количество обработанных букв
+     * @return число букв, прошедших через сеанс
+     */
+    size_t processed() const { return total; }
+};
+
+/**
+ * @brief Чтение произвольных участков зашифрованного файла
+ * @details Файл отображается в память один раз, формат (UTF-8 или
+ * упакованный packedText) определяется по сигнатуре. Каждое чтение
+ * обращается только к страницам запрошенного диапазона, поэтому время
+ * не зависит от размера файла и позиции. Символы проверяются только
+ * в прочитанных диапазонах; заголовок упакованного файла проверяется
+ * при открытии. Методы константные, один экземпляр можно читать из
+ * нескольких потоков.
+ * @warning Читатель хранит ссылку на шифр, шифр должен существовать дольше
+ */
+class modAlphaReader
+{
+private:
+    const modAlphaCipher& cipher; ///< Шифр с установленным ключом
+    mappedFile file; ///< Отображение файла
+    bool isPacked = false; ///< true — упакованный формат
+    size_t letters = 0; ///< Количество букв шифртекста
+    
+public:
+    /**
+     * @brief Удаленный конструктор по умолчанию
+     */
+    modAlphaReader() = delete;
+    
+    /**
+     * @brief Открытие файла шифртекста
+     * @param c шифр с установленным ключом
+     * @param path путь к шифртексту в UTF-8 или в упакованном формате
+     * @throw cipher_error если файл пуст, имеет нечетную длину (UTF-8) или
+     * заголовок не подходит к шифру и ключу (упакованный формат)
+     * @throw system_error при ошибке ввода-вывода
+     */
+    modAlphaReader(const modAlphaCipher& c, const string& path);
+    
+    /**
+     * @brief Количество букв шифртекста
+     * @return длина расшифрованного текста в буквах
+     */
+    size_t size() const { return letters; }
+    
+    /**
+     * @brief Формат файла
+     * @return true — упакованный, false — UTF-8
+     */
+    bool packed() const { return isPacked; }
+    
+    /**
+     * @brief Расшифрование участка файла
+     * @param offset номер первой буквы
+     * @param length количество букв; обрезается по концу файла
+     * @return открытый текст участка в UTF-8
+     * @throw cipher_error если offset больше size() или участок содержит
+     * недопустимые символы
+     */
+    string read(size_t offset, size_t length) const;
 };
@@ -0,0 +1,220 @@
+/**
+ * @file modAlphaFile.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Шифрование методом Гронсфельда файлов через отображение в память
+ * @details Вход читается прямо из отображенных страниц, номера букв
+ * собираются в блок на стеке, обрабатываются ядром с учетом позиции в ключе
+ * и записываются в отображение результата двухбайтовыми словами UTF-8.
+ * Каждая буква входа занимает не меньше двух байт, поэтому результат размера
+ * входа гарантированно вмещает текст и в конце усекается. Обработанные
+ * страницы освобождаются через madvise(MADV_DONTNEED) по мере продвижения.
+ * Здесь же modAlphaReader — чтение отдельных участков зашифрованного файла.
+ */
+
+#include "modAlphaCipher.h"
+#include "../common/mappedFile.h"
+#include "../common/ruAlphabet.h"
+#include "../common/ruUtf8.h"
+#include "../common/ruTranscode.h"
+#include "../common/packedText.h"
+#include <algorithm>
+#include <sys/mman.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @brief Шифрование или расшифрование файла UTF-8 через отображение в память
+ * @param inPath путь к исходному файлу
+ * @param outPath путь к результату
+ * @param back true — расшифрование, false — шифрование
+ * @param memoryBudget ограничение на объем страниц в памяти процесса, байт
+ * @details Шифртекст проверяется по тем же правилам, что и в checkCipherText,
+ * с остановкой на первом недопустимом символе. При ошибке результат удаляется.
+ * @throw cipher_error если текст невалиден
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+void modAlphaCipher::runFile(const string& inPath, const string& outPath, bool back,
+                             size_t memoryBudget) const
+{
+    checkDistinctFiles(inPath, outPath);
+    mappedFile src(inPath);
+    if (back && src.size() == 0)
+        throw cipher_error("Empty cipher text");
+    src.advise(0, src.size(), MADV_SEQUENTIAL);
+    mappedFile dst(outPath, src.size());
+    
+    try {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(src.data());
+        char* out = dst.data();
+        uint8_t block[INTO_BLOCK];
+        size_t len = 0;
+        size_t written = 0;
+        size_t released = 0;
+        size_t releasedOut = 0;
+        
+        auto flush = [&] {
+            applyKey(block, len, written, back);
+            ruEncodeUpper(block, len, out + RU_UTF8_LETTER * written);
+            written += len;
+            len = 0;
+        };
+        
+        for (size_t pos = 0; pos < src.size();) {
+            wchar_t c;
+            pos += ruUtf8Next(p + pos, src.size() - pos, c);
+            uint8_t cls = ruClassify(c);
+            if (back) {
+                if (cls == RU_CLASS_SPACE)
+                    throw cipher_error("Whitespace in cipher text");
+                if (!ruIsUpper(cls))
+                    throw cipher_error("Invalid character in cipher text");
+            }
+            if (ruIsLetter(cls)) {
+                block[len++] = ruIndex(cls);
+                if (len == INTO_BLOCK)
+                    flush();
+            }
+            if (pos - released >= memoryBudget / 2) {
+                flush();
+                src.release(released, pos - released);
+                dst.release(releasedOut, RU_UTF8_LETTER * written - releasedOut);
+                released = pos;
+                releasedOut = RU_UTF8_LETTER * written;
+            }
+        }
+        flush();
+        src.release(0, src.size());
+        if (written == 0)
+            throw cipher_error(back ? "Empty cipher text" : "Empty open text");
+        dst.resize(RU_UTF8_LETTER * written);
+    } catch (...) {
+        unlink(outPath.c_str());
+        throw;
+    }
+}
+
+/**
+ * @brief Шифрование файла UTF-8 в файл без загрузки текста в память
+ * @param inPath путь к открытому тексту
+ * @param outPath путь к результату (создается или перезаписывается)
+ * @param memoryBudget ограничение на объем страниц в памяти процесса, байт
+ * @throw cipher_error если в тексте нет букв
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+void modAlphaCipher::encryptFile(const string& inPath, const string& outPath,
+                                 size_t memoryBudget) const
+{
+    runFile(inPath, outPath, false, memoryBudget);
+}
+
+/**
+ * @brief Расшифрование файла UTF-8 в файл без загрузки текста в память
+ * @param inPath путь к шифртексту
+ * @param outPath путь к результату (создается или перезаписывается)
+ * @param memoryBudget ограничение на объем страниц в памяти процесса, байт
+ * @throw cipher_error если шифртекст невалиден
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+void modAlphaCipher::decryptFile(const string& inPath, const string& outPath,
+                                 size_t memoryBudget) const
+{
+    runFile(inPath, outPath, true, memoryBudget);
+}
+
+/**
+ * @brief Открытие файла шифртекста
+ * @param c шифр с установленным ключом
+ * @param path путь к шифртексту в UTF-8 или в упакованном формате
+ * @details Доступ к страницам случайный (MADV_RANDOM): читатель не должен
+ * подкачивать соседние участки файла
+ * @throw cipher_error если файл пуст, имеет нечетную длину или заголовок
+ * не подходит к шифру и ключу
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+modAlphaReader::modAlphaReader(const modAlphaCipher& c, const string& path):
+    cipher(c), file(path)
+{
+    string_view data(file.data(), file.size());
+    if (packedIsContainer(data)) {
+        packedHeader header;
+        packedStatus status = packedOpen(data, PACKED_GRONSFELD, cipher.keyFingerprint(), header);
+        if (status != PACKED_OK)
+            throw cipher_error(packedMessage(status));
+        isPacked = true;
+        letters = header.length;
+    } else {
+        if (data.size() % RU_UTF8_LETTER != 0)
+            throw cipher_error("Invalid character in cipher text");
+        letters = data.size() / RU_UTF8_LETTER;
+    }
+    if (letters == 0)
+        throw cipher_error("Empty cipher text");
+    file.advise(0, file.size(), MADV_RANDOM);
+}
+
+/**
+ * @brief Расшифрование участка файла
+ * @param offset номер первой буквы
+ * @param length количество букв; обрезается по концу файла
+ * @return открытый текст участка в UTF-8
+ * @throw cipher_error если offset больше size() или участок содержит
+ * недопустимые символы
+ */
+ 
+string modAlphaReader::read(size_t offset, size_t length) const
+{
+    if (!isPacked)
+        return cipher.decryptRange(string_view(file.data(), file.size()), offset, length);
+    if (offset > letters)
+        throw cipher_error("Range out of cipher text");
+    length = min(length, letters - offset);
+    letterBuffer tmp(length);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(file.data()) + PACKED_HEADER;
+    if (!unpackRange(p, offset, length, tmp.data()))
+        throw cipher_error(packedMessage(PACKED_BAD_LETTER));
+    cipher.applyKey(tmp.data(), length, offset, true);
+    string out(RU_UTF8_LETTER * length, '\0');
+    ruEncodeUpper(tmp.data(), length, &out[0]);
+    return out;
+}
+
+/**
+ * @brief Стадии разбора и шифра для stagedPipeline
+ * @param decrypt true — расшифрование, false — шифрование
+ * @return набор стадий
+ * @details Разбор — те же декодеры, что в encryptUtf8/decryptUtf8. Ядро
+ * накладывает ключ с позиции total, равной числу букв предыдущих блоков,
+ * и проверяет пустоту текста на последнем блоке
+ */
+ 
+stageSet modAlphaCipher::stages(bool decrypt) const
+{
+    stageSet set;
+    if (decrypt) {
+        set.decode = [](const char* data, size_t len, uint8_t* out) {
+            ruDecodeResult res = ruDecodeCipher(data, len, out);
+            if (res.status == RU_TEXT_SPACE)
+                throw cipher_error("Whitespace in cipher text");
+            if (res.status == RU_TEXT_INVALID)
+                throw cipher_error("Invalid character in cipher text");
+            return res.letters;
+        };
+    } else {
+        set.decode = [](const char* data, size_t len, uint8_t* out) {
+            return ruDecodeOpen(data, len, out);
+        };
+    }
+    set.kernel = [this, decrypt, total = size_t(0)](letterBuffer& letters, bool last) mutable {
+        if (last && total + letters.size() == 0)
+            throw cipher_error(decrypt ? "Empty cipher text" : "Empty open text");
+        applyKey(letters.data(), letters.size(), total, decrypt);
+        total += letters.size();
+    };
+    return set;
+}
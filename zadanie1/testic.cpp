@@ -9,9 +9,69 @@
 
 #include <UnitTest++/UnitTest++.h>
 #include <string>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <codecvt>
+#include <cstdio>
+#include <locale>
+#include <poll.h>
+#include <unistd.h>
 #include "modAlphaCipher.h"
+#include "gronsfeldKernel.h"
+#include "gronsfeldAnalysis.h"
+#include "../common/ruAlphabet.h"
+#include "../common/threadPool.h"
+#include "../common/linePipe.h"
+#include "../common/asyncIo.h"
+#include "../common/ruTranscode.h"
+#include "../common/packedText.h"
+#include "../common/spscRing.h"
+#include "../common/stagedPipeline.h"
 using namespace std;
 
+/// Счетчик выделений памяти через operator new во всей тестовой программе
+static atomic<size_t> allocationCount(0);
+
+/**
+ * @brief Замена глобального operator new со счетчиком выделений
+ * @param size размер блока
+ * @return выделенный блок
+ */
+ 
+[[gnu::noinline]] void* operator new(size_t size)
+{
+    ++allocationCount;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+/**
+ * @brief Парный operator delete
+ * @param p освобождаемый блок
+ */
+ 
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+/**
+ * @brief Парный operator delete с размером
+ * @param p освобождаемый блок
+ */
+ 
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
 /**
  * @brief Преобразование широкой строки в UTF-8
  * @param ws широкая строка
@@ -170,6 +230,1113 @@ SUITE(DecryptTest)
         modAlphaCipher cipher(L"Я");
         CHECK_WIDE_EQUAL(L"ПРИВЕТМИР", cipher.decrypt(L"ОПЗБДСЛЗП"));
     }
+    
+    TEST_FIXTURE(KeyBFixture, ValidateWithoutCipher) {
+        CHECK_EQUAL(size_t(9), cipher->validateOpenText(L"Привет, мир!"));
+        CHECK_EQUAL(size_t(9), cipher->validateCipherText(L"РСЙГЁУНЙС"));
+        CHECK_THROW(cipher->validateOpenText(L"1234"), cipher_error);
+        CHECK_THROW(cipher->validateCipherText(L""), cipher_error);
+        CHECK_THROW(cipher->validateCipherText(L"РСЙ ГЁУ"), cipher_error);
+        CHECK_THROW(cipher->validateCipherText(L"рсй"), cipher_error);
+    }
+}
+
+/**
+ * @brief Тестовый набор для потокового сеанса modAlphaStream
+ * @details Проверяет совпадение результата с однократным вызовом encrypt/decrypt
+ */
+ 
+SUITE(StreamTest)
+{
+    TEST(EncryptChunksMatchWhole) {
+        modAlphaCipher cipher(L"БВГ");
+        modAlphaStream stream(cipher, false);
+        wstring out = stream.update(L"При");
+        out += stream.update(L"вет, ");
+        out += stream.update(L"");
+        out += stream.update(L"мир!");
+        stream.finish();
+        CHECK_WIDE_EQUAL(cipher.encrypt(L"Привет, мир!"), out);
+        CHECK_EQUAL(9u, stream.processed());
+    }
+    
+    TEST(DecryptChunksMatchWhole) {
+        modAlphaCipher cipher(L"БВГ");
+        modAlphaStream stream(cipher, true);
+        wstring enc = cipher.encrypt(L"ПРИВЕТМИР");
+        wstring out;
+        for (size_t i = 0; i < enc.size(); i += 2) {
+            out += stream.update(enc.substr(i, 2));
+        }
+        stream.finish();
+        CHECK_WIDE_EQUAL(L"ПРИВЕТМИР", out);
+    }
+    
+    TEST(ChunkWithoutLetters) {
+        modAlphaCipher cipher(L"БВГ");
+        modAlphaStream stream(cipher, false);
+        CHECK_WIDE_EQUAL(L"", stream.update(L"123, "));
+        CHECK_THROW(stream.finish(), cipher_error);
+    }
+    
+    TEST(InvalidCipherChunk) {
+        modAlphaCipher cipher(L"БВГ");
+        modAlphaStream stream(cipher, true);
+        CHECK_WIDE_EQUAL(L"БВГ", stream.update(L"ВДЁ"));
+        CHECK_THROW(stream.update(L"ВД Ё"), cipher_error);
+    }
+    
+    TEST(Utf8ChunksSplitInsideCharacters) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        string text = wideToUtf8(L"Съешь же ещё этих мягких булок, €𝄞 да выпей чаю!");
+        string expected = wideToUtf8(cipher.encrypt(utf8ToWide(text)));
+        for (size_t step = 1; step <= 5; ++step) {
+            modAlphaStream stream(cipher, false);
+            string out;
+            for (size_t i = 0; i < text.size(); i += step)
+                stream.update(text.data() + i, min(step, text.size() - i), out);
+            stream.finish();
+            CHECK_EQUAL(expected, out);
+        }
+    }
+    
+    TEST(Utf8CipherCutMidCharacter) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        string enc = wideToUtf8(cipher.encrypt(L"ПРИВЕТ"));
+        modAlphaStream stream(cipher, true);
+        string out;
+        stream.update(enc.data(), enc.size() - 1, out);
+        CHECK_EQUAL(wideToUtf8(L"ПРИВЕ"), out);
+        CHECK_THROW(stream.finish(), cipher_error);
+        modAlphaStream spaced(cipher, true);
+        CHECK_THROW(spaced.update("\xd0\x9f \xd0\x9f", 5, out), cipher_error);
+    }
+}
+
+/**
+ * @brief Тестовый набор для векторных ядер шифра
+ * @details Сравнивает SSE2/AVX2 со скалярной эталонной реализацией
+ * на разных длинах ключа, текста и начальных позициях в ключе
+ */
+ 
+SUITE(KernelTest)
+{
+    TEST(VectorMatchesScalar) {
+        mt19937 gen(2025);
+        uniform_int_distribution<int> letter(0, GRONSFELD_MOD - 1);
+        for (size_t period : {1, 2, 3, 7, 16, 31, 32, 33, 64, 100}) {
+            vector<uint8_t> key(period);
+            for (auto& k : key)
+                k = letter(gen);
+            for (bool back : {false, true}) {
+                vector<uint8_t> ks = gronsfeldKeyStream(key, back);
+                for (size_t n : {0, 1, 15, 16, 17, 33, 100, 1000}) {
+                    vector<uint8_t> text(n);
+                    for (auto& t : text)
+                        t = letter(gen);
+                    size_t phase = letter(gen) % period;
+                    vector<uint8_t> expected = text;
+                    gronsfeldAdd(ISA_SCALAR, expected.data(), n, ks.data(), period, phase);
+                    for (gronsfeldIsa isa : {ISA_SSE2, ISA_AVX2}) {
+                        if (!gronsfeldSupported(isa))
+                            continue;
+                        vector<uint8_t> actual = text;
+                        gronsfeldAdd(isa, actual.data(), n, ks.data(), period, phase);
+                        CHECK(expected == actual);
+                    }
+                }
+            }
+        }
+    }
+    
+    TEST(DecryptStreamInvertsEncrypt) {
+        vector<uint8_t> key = {1, 32, 0, 17};
+        vector<uint8_t> fwd = gronsfeldKeyStream(key, false);
+        vector<uint8_t> back = gronsfeldKeyStream(key, true);
+        vector<uint8_t> text(200);
+        for (size_t i = 0; i < text.size(); ++i)
+            text[i] = i % GRONSFELD_MOD;
+        vector<uint8_t> work = text;
+        gronsfeldAdd(work.data(), work.size(), fwd.data(), key.size(), 3);
+        gronsfeldAdd(work.data(), work.size(), back.data(), key.size(), 3);
+        CHECK(text == work);
+    }
+}
+
+/**
+ * @brief Случайный текст UTF-8 из фрагментов, важных для декодера
+ * @param gen генератор
+ * @param pieces количество фрагментов
+ * @param broken добавлять ли оборванные последовательности
+ * @return текст с буквами обоих регистров, ASCII, соседями алфавита
+ * в блоках D0/D1 и многобайтовыми символами
+ */
+ 
+static string randomUtf8(mt19937& gen, size_t pieces, bool broken = true)
+{
+    static const vector<string> parts = {
+        "А", "Я", "Ё", "ё", "а", "п", "р", "я", "Ж", "щ", " ", "\n", ",", "x",
+        "Ѐ", "ѐ", "Ђ", "ѣ", "€", "𝄞", "ПРИВЕТ", "мир", "\x80", "\xD0", "\xD1"
+    };
+    uniform_int_distribution<size_t> pick(0, parts.size() - (broken ? 1 : 4));
+    string s;
+    for (size_t i = 0; i < pieces; ++i)
+        s += parts[pick(gen)];
+    return s;
+}
+
+/**
+ * @brief Тестовый набор для перекодирования UTF-8 в номера букв
+ * @details Сравнивает AVX2 со скалярной реализацией и API UTF-8
+ * шифра с широкими строками
+ */
+ 
+SUITE(TranscodeTest)
+{
+    TEST(OpenMatchesScalar) {
+        mt19937 gen(16);
+        for (size_t pieces : {0, 1, 5, 20, 40, 100, 400}) {
+            for (int round = 0; round < 20; ++round) {
+                string s = randomUtf8(gen, pieces);
+                vector<uint8_t> expected(s.size() / 2);
+                size_t n = ruDecodeOpen(RU_TRANSCODE_SCALAR, s.data(), s.size(), expected.data());
+                if (!ruTranscodeSupported(RU_TRANSCODE_AVX2))
+                    continue;
+                vector<uint8_t> actual(s.size() / 2);
+                CHECK_EQUAL(n, ruDecodeOpen(RU_TRANSCODE_AVX2, s.data(), s.size(), actual.data()));
+                CHECK(equal(expected.begin(), expected.begin() + n, actual.begin()));
+            }
+        }
+    }
+    
+    TEST(OpenIndicesFollowAlphabet) {
+        string s = wideToUtf8(wstring(RU_UPPER) + L" " + RU_LOWER + L"!");
+        s += s + s;
+        vector<uint8_t> idx(s.size() / 2);
+        CHECK_EQUAL(size_t(198), ruDecodeOpen(s.data(), s.size(), idx.data()));
+        for (size_t i = 0; i < 198; ++i)
+            CHECK_EQUAL(int(i % 33), int(idx[i]));
+    }
+    
+    TEST(CipherReportsFirstError) {
+        string letters = wideToUtf8(wstring(300, L'Ё') + RU_UPPER);
+        for (size_t at : {0, 2, 62, 64, 126, 300, 600}) {
+            for (const string bad : {" ", "\t", "а", "x", "\xD0", "€"}) {
+                string s = letters.substr(0, at) + bad + letters.substr(at);
+                for (ruTranscodeIsa isa : {RU_TRANSCODE_SCALAR, RU_TRANSCODE_AVX2}) {
+                    if (!ruTranscodeSupported(isa))
+                        continue;
+                    vector<uint8_t> idx(s.size() / 2);
+                    ruDecodeResult res = ruDecodeCipher(isa, s.data(), s.size(), idx.data());
+                    bool space = bad == " " || bad == "\t";
+                    CHECK_EQUAL(int(space ? RU_TEXT_SPACE : RU_TEXT_INVALID), int(res.status));
+                    CHECK_EQUAL(at, res.errorPos);
+                    CHECK_EQUAL(at / 2, res.letters);
+                }
+            }
+        }
+    }
+    
+    TEST(RejectsOverlongAndSurrogates) {
+        // Избыточные формы буквы А (U+0410), суррогат U+D800 и код выше U+10FFFF
+        const char* forms[] = {"\xE0\x90\x90", "\xF0\x80\x90\x90", "\xED\xA0\x80", "\xF4\x90\x80\x80"};
+        string letters = wideToUtf8(wstring(100, L'Ж'));
+        modAlphaCipher cipher(L"КЛЮЧ");
+        for (const char* bad : forms) {
+            for (size_t at : {0, 2, 64, 200}) {
+                string s = letters.substr(0, at) + bad + letters.substr(at);
+                for (ruTranscodeIsa isa : {RU_TRANSCODE_SCALAR, RU_TRANSCODE_AVX2}) {
+                    if (!ruTranscodeSupported(isa))
+                        continue;
+                    vector<uint8_t> idx(s.size());
+                    ruDecodeResult res = ruDecodeCipher(isa, s.data(), s.size(), idx.data());
+                    CHECK_EQUAL(int(RU_TEXT_INVALID), int(res.status));
+                    CHECK_EQUAL(at, res.errorPos);
+                    CHECK_EQUAL(size_t(100), ruDecodeOpen(isa, s.data(), s.size(), idx.data()));
+                }
+            }
+            CHECK_THROW(cipher.decryptUtf8(bad), cipher_error);
+            CHECK_THROW(cipher.encryptUtf8(bad), cipher_error);
+        }
+    }
+    
+    TEST(EncodeRoundTrip) {
+        vector<uint8_t> idx(1000);
+        for (size_t i = 0; i < idx.size(); ++i)
+            idx[i] = (i * 7) % 33;
+        string s(2 * idx.size(), '\0');
+        ruEncodeUpper(idx.data(), idx.size(), &s[0]);
+        wstring expected;
+        for (uint8_t k : idx)
+            expected += RU_UPPER[k];
+        CHECK_EQUAL(wideToUtf8(expected), s);
+        for (ruTranscodeIsa isa : {RU_TRANSCODE_SCALAR, RU_TRANSCODE_AVX2}) {
+            if (!ruTranscodeSupported(isa))
+                continue;
+            vector<uint8_t> back(idx.size());
+            ruDecodeResult res = ruDecodeCipher(isa, s.data(), s.size(), back.data());
+            CHECK_EQUAL(int(RU_TEXT_OK), int(res.status));
+            CHECK(idx == back);
+        }
+    }
+    
+    TEST(WideEdgeMatchesUtf8) {
+        mt19937 gen(18);
+        string s = randomUtf8(gen, 500, false);
+        wstring ws = utf8ToWide(s);
+        letterBuffer narrow(s.size() / 2);
+        letterBuffer wide(ws.size());
+        size_t n = ruDecodeOpen(s.data(), s.size(), narrow.data());
+        CHECK_EQUAL(n, ruDecodeOpen(ws, wide.data()));
+        CHECK(equal(narrow.begin(), narrow.begin() + n, wide.begin()));
+        wstring upper(n, L' ');
+        ruEncodeUpper(wide.data(), n, &upper[0]);
+        wstring bad = upper + L"Жx" + upper;
+        letterBuffer checked(bad.size());
+        ruDecodeResult res = ruDecodeCipher(bad, checked.data());
+        CHECK_EQUAL(int(RU_TEXT_INVALID), int(res.status));
+        CHECK_EQUAL(n + 1, res.errorPos);
+    }
+    
+    TEST(WideKernelsMatchScalar) {
+        if (!ruTranscodeSupported(RU_TRANSCODE_AVX2))
+            return;
+        mt19937 gen(21);
+        // Соседи границ диапазонов кириллицы и пробельные символы
+        const wchar_t odd[] = {0x400, 0x401, 0x402, 0x40F, 0x410, 0x42F, 0x430, 0x44F,
+                               0x450, 0x451, 0x452, 0x10410, L' ', L'\t', L'\u00A0', L'x'};
+        for (size_t len : {0, 1, 31, 32, 33, 95, 1000}) {
+            for (int round = 0; round < 20; ++round) {
+                wstring s(len, L' ');
+                for (auto& c : s)
+                    c = gen() % 3 ? RU_UPPER[gen() % 33] : gen() % 2 ? RU_LOWER[gen() % 33]
+                                                                   : odd[gen() % size(odd)];
+                letterBuffer a(len + 1), b(len + 1);
+                size_t n = ruDecodeOpen(RU_TRANSCODE_SCALAR, s, a.data());
+                CHECK_EQUAL(n, ruDecodeOpen(RU_TRANSCODE_AVX2, s, b.data()));
+                CHECK(equal(a.begin(), a.begin() + n, b.begin()));
+                
+                // Шифртекст из прописных с одной ошибкой в случайной позиции
+                wstring c(len, L' ');
+                for (auto& ch : c)
+                    ch = RU_UPPER[gen() % 33];
+                if (len != 0 && round % 4 != 0)
+                    c[gen() % len] = odd[gen() % size(odd)];
+                ruDecodeResult ra = ruDecodeCipher(RU_TRANSCODE_SCALAR, c, a.data());
+                ruDecodeResult rb = ruDecodeCipher(RU_TRANSCODE_AVX2, c, b.data());
+                ruDecodeResult rc = ruDecodeCipher(RU_TRANSCODE_AVX2, c, nullptr);
+                CHECK_EQUAL(int(ra.status), int(rb.status));
+                CHECK_EQUAL(int(ra.status), int(rc.status));
+                CHECK_EQUAL(ra.letters, rb.letters);
+                CHECK_EQUAL(ra.letters, rc.letters);
+                if (ra.status != RU_TEXT_OK) {
+                    CHECK_EQUAL(ra.errorPos, rb.errorPos);
+                    CHECK_EQUAL(ra.errorPos, rc.errorPos);
+                }
+                CHECK(equal(a.begin(), a.begin() + ra.letters, b.begin()));
+            }
+        }
+    }
+    
+    TEST(Utf8ApiMatchesWide) {
+        modAlphaCipher cipher(L"ШИФРОВАЛЬЩИК");
+        mt19937 gen(17);
+        for (size_t pieces : {1, 10, 100, 1000}) {
+            string text = randomUtf8(gen, pieces, false) + "ё";
+            wstring enc = cipher.encrypt(utf8ToWide(text));
+            CHECK_EQUAL(wideToUtf8(enc), cipher.encryptUtf8(text));
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(enc)), cipher.decryptUtf8(wideToUtf8(enc)));
+        }
+    }
+    
+    TEST(Utf8ApiErrors) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        CHECK_THROW(cipher.encryptUtf8("123, !"), cipher_error);
+        CHECK_THROW(cipher.decryptUtf8(""), cipher_error);
+        try {
+            cipher.decryptUtf8(wideToUtf8(L"АБВ1 ГД"));
+            CHECK(false);
+        } catch (const cipher_error& e) {
+            CHECK_EQUAL("Invalid character in cipher text", string(e.what()));
+        }
+        try {
+            cipher.decryptUtf8(wideToUtf8(L"АБВ Г1Д"));
+            CHECK(false);
+        } catch (const cipher_error& e) {
+            CHECK_EQUAL("Whitespace in cipher text", string(e.what()));
+        }
+    }
+}
+
+/**
+ * @brief Тестовый набор для упакованного формата 6 бит на букву
+ * @details Сравнивает ядра упаковки между собой, проверяет обратимость
+ * через API шифра и отказ на поврежденных контейнерах
+ */
+ 
+SUITE(PackedTest)
+{
+    TEST(KernelsMatchScalar) {
+        mt19937 gen(18);
+        uniform_int_distribution<int> letter(0, RU_ALPHABET_SIZE - 1);
+        for (size_t n = 0; n < 200; ++n) {
+            letterBuffer text(n);
+            for (auto& t : text)
+                t = letter(gen);
+            vector<uint8_t> expected(packedBytes(n));
+            packLetters(RU_TRANSCODE_SCALAR, text.data(), n, expected.data());
+            for (ruTranscodeIsa isa : {RU_TRANSCODE_SCALAR, RU_TRANSCODE_AVX2}) {
+                if (!ruTranscodeSupported(isa))
+                    continue;
+                vector<uint8_t> packed(packedBytes(n));
+                packLetters(isa, text.data(), n, packed.data());
+                CHECK(expected == packed);
+                letterBuffer back(n);
+                CHECK(unpackLetters(isa, packed.data(), n, back.data()));
+                CHECK(text == back);
+            }
+        }
+    }
+    
+    TEST(LayoutIsLittleEndianSextets) {
+        uint8_t letters[5] = {1, 2, 3, 32, 5};
+        uint8_t packed[4];
+        packLetters(letters, 5, packed);
+        uint32_t v = 1 | 2 << 6 | 3 << 12 | 32 << 18;
+        CHECK_EQUAL(int(v & 0xFF), int(packed[0]));
+        CHECK_EQUAL(int((v >> 8) & 0xFF), int(packed[1]));
+        CHECK_EQUAL(int(v >> 16), int(packed[2]));
+        CHECK_EQUAL(5, int(packed[3]));
+    }
+    
+    TEST(RejectsValuesAbove32) {
+        for (ruTranscodeIsa isa : {RU_TRANSCODE_SCALAR, RU_TRANSCODE_AVX2}) {
+            if (!ruTranscodeSupported(isa))
+                continue;
+            for (size_t at : {0, 31, 32, 100, 127}) {
+                letterBuffer text(128, 7);
+                vector<uint8_t> packed(packedBytes(text.size()));
+                packLetters(text.data(), text.size(), packed.data());
+                size_t byte = at / 4 * 3;
+                packed[byte] |= 0x3F; // номер 63 у первой буквы группы
+                letterBuffer back(text.size());
+                CHECK(!unpackLetters(isa, packed.data(), text.size(), back.data()));
+            }
+        }
+    }
+    
+    TEST(RoundTripMatchesStringApi) {
+        modAlphaCipher cipher(L"ШИФРОВАЛЬЩИК");
+        for (size_t reps : {1, 3, 50, 1000}) {
+            wstring text;
+            for (size_t i = 0; i < reps; ++i)
+                text += L"Съешь же ещё этих мягких французских булок, да выпей чаю! ";
+            string packed = cipher.encryptPacked(wideToUtf8(text));
+            wstring enc = cipher.encrypt(text);
+            CHECK_EQUAL(PACKED_HEADER + packedBytes(enc.size()), packed.size());
+            if (reps >= 50)
+                CHECK(packed.size() * 5 < wideToUtf8(enc).size() * 2);
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(enc)), cipher.decryptPacked(packed));
+            packedHeader header;
+            CHECK_EQUAL(int(PACKED_OK), int(packedReadHeader(packed, header)));
+            CHECK_EQUAL(int(PACKED_GRONSFELD), int(header.cipher));
+            CHECK_EQUAL(enc.size(), header.length);
+        }
+    }
+    
+    TEST(RejectsDamagedContainers) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        string packed = cipher.encryptPacked("Привет, мир!");
+        auto message = [&](const string& data) {
+            try {
+                cipher.decryptPacked(data);
+            } catch (const cipher_error& e) {
+                return string(e.what());
+            }
+            return string();
+        };
+        CHECK_EQUAL("Packed text key mismatch", message(modAlphaCipher(L"ЗАМОК").encryptPacked("Привет")));
+        CHECK_EQUAL("Invalid packed header", message(packed.substr(0, 10)));
+        CHECK_EQUAL("Invalid packed length", message(packed + "x"));
+        CHECK_EQUAL("Invalid packed length", message(packed.substr(0, packed.size() - 1)));
+        string other = packed;
+        other[5] = PACKED_TABLE;
+        CHECK_EQUAL("Packed text belongs to another cipher", message(other));
+        string bad = packed;
+        bad[PACKED_HEADER] |= 0x3F;
+        CHECK_EQUAL("Invalid letter in packed text", message(bad));
+        packedHeader empty;
+        CHECK_EQUAL(int(PACKED_OK), int(packedReadHeader(packed, empty)));
+        empty.length = 0;
+        CHECK_EQUAL("Empty cipher text", message(packedEncode(empty, nullptr)));
+        CHECK_THROW(cipher.encryptPacked("123"), cipher_error);
+    }
+}
+
+/**
+ * @brief Тестовый набор для общей таблицы классификации символов
+ * @details Проверяет номера букв обоих регистров, пробелы и отказ
+ */
+ 
+SUITE(ClassifyTest)
+{
+    TEST(Letters) {
+        for (uint8_t k = 0; k < RU_ALPHABET_SIZE; ++k) {
+            CHECK_EQUAL(int(k), int(ruClassify(RU_UPPER[k])));
+            CHECK_EQUAL(int(k | RU_CLASS_LOWER), int(ruClassify(RU_LOWER[k])));
+        }
+        CHECK_EQUAL(6, int(ruIndex(ruClassify(L'ё'))));
+    }
+    
+    TEST(SpacesAndRejects) {
+        CHECK_EQUAL(int(RU_CLASS_SPACE), int(ruClassify(L' ')));
+        CHECK_EQUAL(int(RU_CLASS_SPACE), int(ruClassify(L'\t')));
+        CHECK_EQUAL(int(RU_CLASS_REJECT), int(ruClassify(L'A')));
+        CHECK_EQUAL(int(RU_CLASS_REJECT), int(ruClassify(L'1')));
+        CHECK_EQUAL(int(RU_CLASS_REJECT), int(ruClassify(L'є')));
+        CHECK_EQUAL(int(RU_CLASS_REJECT), int(ruClassify(L'€')));
+        CHECK_EQUAL(int(RU_CLASS_REJECT), int(ruClassify(wchar_t(-1))));
+    }
+}
+
+/**
+ * @brief Тестовый набор для параллельного режима
+ * @details Проверяет совпадение с однопоточным результатом при малом пороге
+ */
+ 
+SUITE(ParallelTest)
+{
+    TEST(MatchesSingleThread) {
+        wstring text;
+        for (int i = 0; i < 500; ++i)
+            text += L"Съешь же ещё этих мягких французских булок, да выпей чаю! ";
+        modAlphaCipher single(L"ШИФРОВАНИЕ");
+        modAlphaCipher parallel(L"ШИФРОВАНИЕ");
+        parallel.setParallel(4, 64);
+        wstring enc = single.encrypt(text);
+        CHECK_WIDE_EQUAL(enc, parallel.encrypt(text));
+        CHECK_WIDE_EQUAL(single.decrypt(enc), parallel.decrypt(enc));
+    }
+    
+    TEST(SharedPool) {
+        auto pool = make_shared<threadPool>(3);
+        modAlphaCipher a(L"БВГ");
+        modAlphaCipher b(L"ЯЮЭ");
+        a.setParallel(pool, 1);
+        b.setParallel(pool, 1);
+        CHECK_WIDE_EQUAL(L"ПРИВЕТМИР", b.decrypt(b.encrypt(L"привет, мир")));
+        CHECK_WIDE_EQUAL(L"БВГБВ", a.encrypt(L"ААААА"));
+    }
+    
+    TEST(Errors) {
+        modAlphaCipher cipher(L"БВГ");
+        cipher.setParallel(4, 1);
+        CHECK_THROW(cipher.encrypt(L"1234, 5678"), cipher_error);
+        CHECK_THROW(cipher.decrypt(L"АБВГДЕЖЗ ИЙКЛМН"), cipher_error);
+        CHECK_THROW(cipher.decrypt(L""), cipher_error);
+    }
+}
+
+/**
+ * @brief Тестовый набор для пакетного API
+ * @details Проверяет совпадение с поштучными вызовами encrypt/decrypt
+ */
+ 
+SUITE(BatchTest)
+{
+    TEST(MatchesSingleCalls) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        vector<wstring> plains = {L"Привет, мир!", L"а", L"С Новым 2024 Годом", L"ЁЖИК"};
+        vector<wstring_view> views(plains.begin(), plains.end());
+        textBatch enc = cipher.encryptBatch(views);
+        CHECK_EQUAL(plains.size(), enc.size());
+        vector<wstring_view> encViews;
+        for (size_t i = 0; i < enc.size(); ++i) {
+            CHECK_WIDE_EQUAL(cipher.encrypt(plains[i]), wstring(enc[i]));
+            encViews.push_back(enc[i]);
+        }
+        textBatch dec = cipher.decryptBatch(encViews);
+        for (size_t i = 0; i < dec.size(); ++i) {
+            CHECK_WIDE_EQUAL(cipher.decrypt(wstring(enc[i])), wstring(dec[i]));
+        }
+    }
+    
+    TEST(EmptyBatch) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        CHECK_EQUAL(0u, cipher.encryptBatch({}).size());
+    }
+    
+    TEST(InvalidItem) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        vector<wstring_view> bad = {L"АБВ", L"123"};
+        CHECK_THROW(cipher.encryptBatch(bad), cipher_error);
+        vector<wstring_view> badCipher = {L"АБВ", L"АБ В"};
+        CHECK_THROW(cipher.decryptBatch(badCipher), cipher_error);
+    }
+}
+
+/**
+ * @brief Тестовый набор для API с буфером вызывающего
+ * @details Проверяет результат и отсутствие выделений памяти в установившемся цикле
+ */
+ 
+SUITE(IntoTest)
+{
+    TEST(IntoCallerBuffer) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        wstring plain = L"Съешь же ещё этих мягких булок, да выпей чаю!";
+        wstring enc = cipher.encrypt(plain);
+        wchar_t out[64];
+        size_t n = cipher.encrypt(plain, out);
+        CHECK_WIDE_EQUAL(enc, wstring(out, n));
+        n = cipher.decrypt(enc, out);
+        CHECK_WIDE_EQUAL(cipher.decrypt(enc), wstring(out, n));
+        CHECK_THROW(cipher.encrypt(plain, span<wchar_t>(out, 3)), cipher_error);
+    }
+    
+    TEST(InPlace) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        wstring buf = L"Привет, мир!";
+        size_t n = cipher.encryptInPlace(buf);
+        CHECK_WIDE_EQUAL(cipher.encrypt(L"Привет, мир!"), buf.substr(0, n));
+        buf.resize(n);
+        CHECK_EQUAL(n, cipher.decryptInPlace(buf));
+        CHECK_WIDE_EQUAL(L"ПРИВЕТМИР", buf);
+    }
+    
+    TEST(LongTextInPlace) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        wstring text;
+        for (int i = 0; i < 1000; ++i)
+            text += L"Ёжик в тумане, ";
+        wstring buf = text;
+        size_t n = cipher.encryptInPlace(buf);
+        CHECK_WIDE_EQUAL(cipher.encrypt(text), buf.substr(0, n));
+    }
+    
+    TEST(SteadyStateWithoutAllocations) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        wstring plain = L"Съешь же ещё этих мягких булок, да выпей чаю!";
+        wchar_t enc[64];
+        wchar_t dec[64];
+        wchar_t work[64];
+        cipher.encrypt(plain, enc);
+        size_t before = allocationCount;
+        for (int i = 0; i < 1000; ++i) {
+            size_t n = cipher.encrypt(plain, enc);
+            cipher.decrypt(wstring_view(enc, n), dec);
+            copy(plain.begin(), plain.end(), work);
+            cipher.encryptInPlace(span<wchar_t>(work, plain.size()));
+        }
+        CHECK_EQUAL(before, size_t(allocationCount));
+    }
+}
+
+/**
+ * @brief Прогон строк через linePipe с шифром
+ * @param input входные строки
+ * @param threads количество потоков
+ * @param failed количество строк с ошибкой
+ * @return выход
+ */
+ 
+static string pipeThrough(const string& input, unsigned threads, size_t& failed)
+{
+    modAlphaCipher cipher(L"КЛЮЧ");
+    FILE* in = tmpfile();
+    FILE* out = tmpfile();
+    fwrite(input.data(), 1, input.size(), in);
+    fflush(in);
+    rewind(in);
+    // Маленький блок, чтобы строки разрывались на границах блоков
+    linePipe pipe([&](const string& line) {
+        thread_local wstring_convert<codecvt_utf8<wchar_t>> conv;
+        return conv.to_bytes(cipher.encrypt(conv.from_bytes(line)));
+    }, threads, 7);
+    failed = pipe.run(fileno(in), fileno(out));
+    string result(lseek(fileno(out), 0, SEEK_END), '\0');
+    lseek(fileno(out), 0, SEEK_SET);
+    result.resize(read(fileno(out), result.data(), result.size()));
+    fclose(in);
+    fclose(out);
+    return result;
+}
+
+SUITE(PipeTest)
+{
+    TEST(RecordsInOrder) {
+        string input;
+        for (int i = 0; i < 500; ++i)
+            input += string("ёжиквтумане").substr(0, 2 + 2 * (i % 11)) + "\n";
+        size_t failed = 0;
+        string serial = pipeThrough(input, 1, failed);
+        CHECK_EQUAL(0u, failed);
+        CHECK_EQUAL(input.size(), serial.size());
+        CHECK_EQUAL(serial, pipeThrough(input, 4, failed));
+    }
+    
+    TEST(ErrorKeepsLine) {
+        size_t failed = 0;
+        string out = pipeThrough("аб\n\n12\nвг", 2, failed);
+        CHECK_EQUAL(2u, failed);
+        CHECK_EQUAL(4, count(out.begin(), out.end(), '\n'));
+        CHECK_EQUAL('\n', out[out.find('\n') + 1]);
+    }
+    
+    TEST(AnswersBeforeChunkFills) {
+        int in[2], out[2];
+        CHECK_EQUAL(0, pipe(in));
+        CHECK_EQUAL(0, pipe(out));
+        linePipe lines([](const string& line) { return line + "!"; });
+        thread worker([&] { lines.run(in[0], out[1]); });
+        string line = "аб\n";
+        CHECK_EQUAL(ssize_t(line.size()), write(in[1], line.data(), line.size()));
+        // Ответ на строку приходит, пока вход еще открыт и блок не заполнен
+        pollfd p = {out[0], POLLIN, 0};
+        char buf[16];
+        ssize_t got = poll(&p, 1, 5000) == 1 ? read(out[0], buf, sizeof(buf)) : 0;
+        CHECK_EQUAL("аб!\n", string(buf, max<ssize_t>(got, 0)));
+        close(in[1]);
+        worker.join();
+        close(in[0]);
+        close(out[0]);
+        close(out[1]);
+    }
+    
+    TEST(Arguments) {
+        const char* ok[] = {"prog", "-k", "КЛЮЧ", "-d", "-j", "4"};
+        pipeArgs args;
+        CHECK(parsePipeArgs(6, const_cast<char**>(ok), args));
+        CHECK(args.decrypt);
+        CHECK_EQUAL(4u, args.threads);
+        const char* noMode[] = {"prog", "-k", "КЛЮЧ"};
+        pipeArgs bad;
+        CHECK(!parsePipeArgs(3, const_cast<char**>(noMode), bad));
+        for (const char* count : {"abc", "-1", "4x", "", "99999999999"}) {
+            const char* threads[] = {"prog", "-k", "КЛЮЧ", "-e", "-j", count};
+            CHECK(!parsePipeArgs(6, const_cast<char**>(threads), bad));
+            const char* depth[] = {"prog", "-k", "КЛЮЧ", "-e", "-i", "in", "-o", "out", "-q", count};
+            CHECK(!parsePipeArgs(10, const_cast<char**>(depth), bad));
+        }
+    }
+    
+    TEST(CrlfLines) {
+        int in[2], out[2];
+        CHECK_EQUAL(0, pipe(in));
+        CHECK_EQUAL(0, pipe(out));
+        string input = "ab\r\ncd\r\n\r\nef\r";
+        CHECK_EQUAL(ssize_t(input.size()), write(in[1], input.data(), input.size()));
+        close(in[1]);
+        linePipe lines([](const string& line) { return "[" + line + "]"; });
+        CHECK_EQUAL(0u, lines.run(in[0], out[1]));
+        close(out[1]);
+        char buf[64];
+        ssize_t got = read(out[0], buf, sizeof(buf));
+        CHECK_EQUAL("[ab]\n[cd]\n[]\n[ef]\n", string(buf, max<ssize_t>(got, 0)));
+        close(in[0]);
+        close(out[0]);
+    }
+}
+
+/**
+ * @brief Запись строки в файл
+ * @param path путь
+ * @param text содержимое
+ */
+ 
+void writeFile(const string& path, const string& text)
+{
+    ofstream(path, ios::binary) << text;
+}
+
+/**
+ * @brief Чтение файла целиком
+ * @param path путь
+ * @return содержимое ("" если файла нет)
+ */
+ 
+string readFile(const string& path)
+{
+    ifstream in(path, ios::binary);
+    stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+SUITE(FileTest)
+{
+    TEST(MatchesStringApi) {
+        wstring text;
+        for (int i = 0; i < 400; ++i)
+            text += L"Съешь же ещё этих мягких булок, 2025! ";
+        writeFile("cipher_file_test.in", wideToUtf8(text));
+        for (const wchar_t* key : {L"Б", L"КЛЮЧ", L"ДЛИННЫЙКЛЮЧШИФРА"}) {
+            modAlphaCipher cipher(key);
+            // Маленький бюджет, чтобы страницы освобождались по ходу
+            cipher.encryptFile("cipher_file_test.in", "cipher_file_test.enc", 1 << 13);
+            wstring enc = cipher.encrypt(text);
+            CHECK_EQUAL(wideToUtf8(enc), readFile("cipher_file_test.enc"));
+            cipher.decryptFile("cipher_file_test.enc", "cipher_file_test.dec", 1 << 13);
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(enc)), readFile("cipher_file_test.dec"));
+        }
+        remove("cipher_file_test.in");
+        remove("cipher_file_test.enc");
+        remove("cipher_file_test.dec");
+    }
+    
+    TEST(InvalidFilesLeaveNoOutput) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        writeFile("cipher_file_test.in", "1234, 5678");
+        CHECK_THROW(cipher.encryptFile("cipher_file_test.in", "cipher_file_test.out"), cipher_error);
+        writeFile("cipher_file_test.in", wideToUtf8(L"ЩЦЁ ЁЮЛ"));
+        CHECK_THROW(cipher.decryptFile("cipher_file_test.in", "cipher_file_test.out"), cipher_error);
+        writeFile("cipher_file_test.in", wideToUtf8(L"ЩЦЁёюл"));
+        CHECK_THROW(cipher.decryptFile("cipher_file_test.in", "cipher_file_test.out"), cipher_error);
+        writeFile("cipher_file_test.in", "");
+        CHECK_THROW(cipher.decryptFile("cipher_file_test.in", "cipher_file_test.out"), cipher_error);
+        CHECK(!ifstream("cipher_file_test.out"));
+        remove("cipher_file_test.in");
+    }
+    
+    TEST(SameFileRefused) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        string text = wideToUtf8(L"ПРИВЕТМИР");
+        writeFile("cipher_same_test.in", text);
+        // Другая запись пути к тому же файлу
+        const string same = "./cipher_same_test.in";
+        CHECK_THROW(cipher.encryptFile("cipher_same_test.in", same), system_error);
+        CHECK_THROW(cipher.decryptFile("cipher_same_test.in", same), system_error);
+        filePipeline pipeline;
+        CHECK_THROW(pipeline.run("cipher_same_test.in", same,
+            [](const char*, size_t, bool, string&) {}), system_error);
+        stagedPipeline staged(cipher.stages(false));
+        CHECK_THROW(staged.run("cipher_same_test.in", same), system_error);
+        CHECK_EQUAL(text, readFile("cipher_same_test.in"));
+        remove("cipher_same_test.in");
+    }
+}
+
+SUITE(PipelineTest)
+{
+    TEST(BlocksMatchStringApi) {
+        wstring text;
+        for (int i = 0; i < 300; ++i)
+            text += L"Ёжик в тумане, 2025! ";
+        writeFile("cipher_pipe_test.in", wideToUtf8(text));
+        modAlphaCipher cipher(L"КЛЮЧ");
+        for (bool uring : {true, false}) {
+            // Нечетный размер блока разрывает двухбайтовые буквы
+            modAlphaStream enc(cipher, false);
+            filePipeline pipeline(3, 101, uring);
+            pipelineStats stats = pipeline.run("cipher_pipe_test.in", "cipher_pipe_test.enc",
+                [&](const char* data, size_t len, bool last, string& out) {
+                    enc.update(data, len, out);
+                    if (last)
+                        enc.finish();
+                });
+            string expected = wideToUtf8(cipher.encrypt(text));
+            CHECK_EQUAL(expected, readFile("cipher_pipe_test.enc"));
+            CHECK_EQUAL(expected.size(), stats.bytesOut);
+            CHECK(stats.maxInFlight <= 3);
+            
+            modAlphaStream dec(cipher, true);
+            pipeline.run("cipher_pipe_test.enc", "cipher_pipe_test.dec",
+                [&](const char* data, size_t len, bool last, string& out) {
+                    dec.update(data, len, out);
+                    if (last)
+                        dec.finish();
+                });
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(cipher.encrypt(text))),
+                        readFile("cipher_pipe_test.dec"));
+        }
+        remove("cipher_pipe_test.in");
+        remove("cipher_pipe_test.enc");
+        remove("cipher_pipe_test.dec");
+    }
+    
+    TEST(ErrorRemovesOutput) {
+        writeFile("cipher_pipe_test.in", "ПРИВЕТ МИР");
+        modAlphaCipher cipher(L"КЛЮЧ");
+        modAlphaStream dec(cipher, true);
+        filePipeline pipeline(2, 4);
+        CHECK_THROW(pipeline.run("cipher_pipe_test.in", "cipher_pipe_test.out",
+            [&](const char* data, size_t len, bool, string& out) {
+                dec.update(data, len, out);
+            }), cipher_error);
+        CHECK(!ifstream("cipher_pipe_test.out"));
+        remove("cipher_pipe_test.in");
+    }
+}
+
+SUITE(StagedTest)
+{
+    TEST(RingOrderAndBackpressure) {
+        spscRing<int> ring(5);
+        CHECK_EQUAL(8u, ring.capacity());
+        for (int i = 0; i < 8; ++i)
+            CHECK(ring.tryPush(i));
+        CHECK(!ring.tryPush(8));
+        int v = -1;
+        for (int i = 0; i < 8; ++i) {
+            CHECK(ring.tryPop(v));
+            CHECK_EQUAL(i, v);
+        }
+        CHECK(!ring.tryPop(v));
+        
+        // Писатель упирается в полную очередь и ждет читателя
+        const int count = 100000;
+        thread producer([&] {
+            for (int i = 0; i < count; ++i)
+                ring.push(i);
+        });
+        int mismatches = 0;
+        for (int i = 0; i < count; ++i) {
+            if (!ring.pop(v) || v != i)
+                ++mismatches;
+        }
+        producer.join();
+        CHECK_EQUAL(0, mismatches);
+        
+        thread closer([&] { ring.close(); });
+        CHECK(!ring.pop(v));
+        closer.join();
+        CHECK(!ring.push(0));
+    }
+    
+    TEST(MatchesStringApi) {
+        wstring text;
+        for (int i = 0; i < 300; ++i)
+            text += L"Ёжик в тумане, 2025! ";
+        string plain = wideToUtf8(text);
+        writeFile("cipher_staged_test.in", plain);
+        modAlphaCipher cipher(L"КЛЮЧ");
+        // Нечетный размер блока разрывает двухбайтовые буквы
+        stagedPipeline enc(cipher.stages(false), 3, 101);
+        stagedStats stats = enc.run("cipher_staged_test.in", "cipher_staged_test.enc");
+        string expected = cipher.encryptUtf8(plain);
+        CHECK_EQUAL(expected, readFile("cipher_staged_test.enc"));
+        CHECK_EQUAL(plain.size(), stats.bytesIn);
+        CHECK_EQUAL(expected.size(), stats.bytesOut);
+        CHECK_EQUAL(4u, stats.stages.size());
+        for (const stageStats& s : stats.stages) {
+            CHECK_EQUAL(stats.stages[0].blocks, s.blocks);
+            CHECK(s.queue <= 3);
+        }
+        CHECK(stats.report().find("bottleneck") != string::npos);
+        
+        // Набор копируется на прогон, повторный прогон начинает ключ сначала
+        enc.run("cipher_staged_test.in", "cipher_staged_test.enc");
+        CHECK_EQUAL(expected, readFile("cipher_staged_test.enc"));
+        
+        stagedPipeline dec(cipher.stages(true), 2, 7);
+        dec.run("cipher_staged_test.enc", "cipher_staged_test.dec");
+        CHECK_EQUAL(cipher.decryptUtf8(expected), readFile("cipher_staged_test.dec"));
+        remove("cipher_staged_test.in");
+        remove("cipher_staged_test.enc");
+        remove("cipher_staged_test.dec");
+    }
+    
+    TEST(ErrorsRemoveOutput) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        writeFile("cipher_staged_test.in", "1234, 5678");
+        stagedPipeline enc(cipher.stages(false), 2, 4);
+        CHECK_THROW(enc.run("cipher_staged_test.in", "cipher_staged_test.out"), cipher_error);
+        CHECK(!ifstream("cipher_staged_test.out"));
+        
+        // Ошибка в середине текста останавливает все стадии
+        writeFile("cipher_staged_test.in", wideToUtf8(wstring(5000, L'Щ') + L"ЦЁ ЁЮЛ"));
+        stagedPipeline dec(cipher.stages(true), 2, 64);
+        CHECK_THROW(dec.run("cipher_staged_test.in", "cipher_staged_test.out"), cipher_error);
+        CHECK(!ifstream("cipher_staged_test.out"));
+        writeFile("cipher_staged_test.in", "");
+        CHECK_THROW(dec.run("cipher_staged_test.in", "cipher_staged_test.out"), cipher_error);
+        remove("cipher_staged_test.in");
+    }
+    
+    TEST(Arguments) {
+        const char* ok[] = {"prog", "-k", "КЛЮЧ", "-e", "-i", "in", "-o", "out", "-s"};
+        pipeArgs args;
+        CHECK(parsePipeArgs(9, const_cast<char**>(ok), args));
+        CHECK(args.staged);
+        const char* noFiles[] = {"prog", "-k", "КЛЮЧ", "-e", "-s"};
+        pipeArgs bad;
+        CHECK(!parsePipeArgs(5, const_cast<char**>(noFiles), bad));
+        const char* packed[] = {"prog", "-k", "КЛЮЧ", "-e", "-i", "in", "-o", "out", "-s", "-p"};
+        CHECK(!parsePipeArgs(10, const_cast<char**>(packed), bad));
+    }
+}
+
+SUITE(RangeTest)
+{
+    TEST(MatchesFullDecrypt) {
+        wstring text;
+        for (int i = 0; i < 200; ++i)
+            text += L"Широкая электрификация южных губерний даст мощный толчок! ";
+        for (const wchar_t* key : {L"Б", L"КЛЮЧ", L"ДЛИННЫЙКЛЮЧШИФРА"}) {
+            modAlphaCipher cipher(key);
+            wstring enc = cipher.encrypt(text);
+            wstring dec = cipher.decrypt(enc);
+            string enc8 = wideToUtf8(enc);
+            for (size_t off : {size_t(0), size_t(1), size_t(7), size_t(4095), enc.size() - 3}) {
+                for (size_t len : {size_t(0), size_t(1), size_t(33), size_t(5000)}) {
+                    wstring part = dec.substr(off, len);
+                    CHECK(part == cipher.decryptRange(wstring_view(enc), off, len));
+                    CHECK_EQUAL(wideToUtf8(part), cipher.decryptRange(string_view(enc8), off, len));
+                }
+            }
+            CHECK(cipher.decryptRange(wstring_view(enc), enc.size(), 10).empty());
+        }
+    }
+    
+    TEST(ChecksOnlyTheRange) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        string enc8 = wideToUtf8(L"ЩЦЁЮЛ") + "!!" + wideToUtf8(L"ЖЗ");
+        CHECK_EQUAL(wideToUtf8(cipher.decrypt(L"ЩЦЁ")), cipher.decryptRange(enc8, 0, 3));
+        CHECK_THROW(cipher.decryptRange(enc8, 4, 2), cipher_error);
+        CHECK_THROW(cipher.decryptRange(enc8, 9, 1), cipher_error);
+        CHECK_THROW(cipher.decryptRange(enc8 + " ", 0, 1), cipher_error);
+        CHECK_THROW(cipher.decryptRange(string_view(), 0, 1), cipher_error);
+        CHECK_THROW(cipher.decryptRange(wstring_view(L"ЩЦ ЁЮ"), 1, 2), cipher_error);
+    }
+    
+    TEST(UnpackRangeMatchesFullUnpack) {
+        letterBuffer letters(301);
+        for (size_t i = 0; i < letters.size(); ++i)
+            letters[i] = (i * 7 + 3) % 33;
+        vector<uint8_t> packed(packedBytes(letters.size()));
+        packLetters(letters.data(), letters.size(), packed.data());
+        for (size_t off = 0; off < letters.size(); off += 13) {
+            for (size_t len : {size_t(0), size_t(1), size_t(2), size_t(3), size_t(150)}) {
+                len = min(len, letters.size() - off);
+                letterBuffer out(len);
+                CHECK(unpackRange(packed.data(), off, len, out.data()));
+                CHECK(equal(out.begin(), out.end(), letters.begin() + off));
+            }
+        }
+        // Вторая буква первой группы становится 63
+        packed[0] |= 0xC0;
+        packed[1] |= 0x0F;
+        letterBuffer out(3);
+        CHECK(!unpackRange(packed.data(), 1, 3, out.data()));
+        CHECK(unpackRange(packed.data(), 4, 3, out.data()));
+    }
+    
+    TEST(ReaderBothFormats) {
+        wstring text;
+        for (int i = 0; i < 500; ++i)
+            text += L"Ёжик в тумане, 2025! ";
+        modAlphaCipher cipher(L"ШИФРОВАЛЬЩИК");
+        string dec = wideToUtf8(cipher.decrypt(cipher.encrypt(text)));
+        writeFile("cipher_range_test.enc", wideToUtf8(cipher.encrypt(text)));
+        writeFile("cipher_range_test.pak", cipher.encryptPacked(wideToUtf8(text)));
+        for (const char* path : {"cipher_range_test.enc", "cipher_range_test.pak"}) {
+            modAlphaReader reader(cipher, path);
+            CHECK_EQUAL(string(path).ends_with(".pak"), reader.packed());
+            CHECK_EQUAL(dec.size() / 2, reader.size());
+            for (size_t off : {size_t(0), size_t(5), size_t(1234), reader.size() - 1})
+                CHECK_EQUAL(dec.substr(2 * off, 2 * 77), reader.read(off, 77));
+            CHECK(reader.read(reader.size(), 1).empty());
+            CHECK_THROW(reader.read(reader.size() + 1, 1), cipher_error);
+        }
+        CHECK_THROW(modAlphaReader(modAlphaCipher(L"КЛЮЧ"), "cipher_range_test.pak"), cipher_error);
+        writeFile("cipher_range_test.enc", "");
+        CHECK_THROW(modAlphaReader(cipher, "cipher_range_test.enc"), cipher_error);
+        remove("cipher_range_test.enc");
+        remove("cipher_range_test.pak");
+    }
+}
+
+/// Связный русский текст для частотного анализа
+static const char* analysisText =
+    "В конце тысяча восемьсот одиннадцатого года, в эпоху нам достопамятную, "
+    "жил в своем поместье добрый помещик. Он славился во всей округе "
+    "гостеприимством и радушием; соседи поминутно ездили к нему поесть, попить, "
+    "поиграть по пяти копеек в бостон с его женою, а некоторые для того, чтоб "
+    "поглядеть на дочку их, стройную, бледную и семнадцатилетнюю девицу. "
+    "Она считалась богатой невестою, и многие прочили ее за себя или за сыновей. "
+    "Девушка была воспитана на французских романах и, следственно, была влюблена. "
+    "Предмет, избранный ею, был бедный армейский прапорщик, находившийся "
+    "в отпуску в своей деревне. Само по себе разумеется, что молодой человек "
+    "пылал равною страстию и что родители его любезной, заметя их взаимную "
+    "склонность, запретили дочери о нем и думать, а его принимали хуже, "
+    "нежели отставного заседателя. ";
+
+SUITE(AnalysisTest)
+{
+    TEST(RecoversKey) {
+        string text;
+        for (int i = 0; i < 8; ++i)
+            text += analysisText;
+        gronsfeldAnalyzer analyzer;
+        for (const wchar_t* key : {L"Б", L"КЛЮЧ", L"ШИФРОВАЛЬЩИК", L"ДЛИННЫЙКЛЮЧДЛЯАНАЛИЗА"}) {
+            modAlphaCipher cipher(key);
+            string enc = cipher.encryptUtf8(text);
+            keyRecovery res = analyzer.analyze(enc);
+            CHECK(res.key == key);
+            CHECK_EQUAL(wcslen(key), res.period);
+            CHECK_EQUAL(enc.size() / 2, res.letters);
+            CHECK_EQUAL(size_t(gronsfeldAnalyzer::MAX_PERIOD), res.periods.size());
+            CHECK(res.periods[res.period - 1].ioc > 0.05);
+            CHECK_EQUAL(cipher.decryptUtf8(enc), modAlphaCipher(res.key).decryptUtf8(enc));
+        }
+    }
+    
+    TEST(ParallelMatchesSingleThread) {
+        string enc = modAlphaCipher(L"ШИФРОВАЛЬЩИК").encryptUtf8(string(analysisText) + analysisText);
+        gronsfeldAnalyzer single(40);
+        gronsfeldAnalyzer parallel(40);
+        parallel.setParallel(4);
+        keyRecovery a = single.analyze(enc);
+        keyRecovery b = parallel.analyze(enc);
+        CHECK_EQUAL(size_t(40), b.periods.size());
+        for (size_t k = 0; k < a.periods.size(); ++k) {
+            CHECK_EQUAL(k + 1, b.periods[k].period);
+            CHECK_EQUAL(a.periods[k].ioc, b.periods[k].ioc);
+            CHECK(a.periods[k].shifts == b.periods[k].shifts);
+        }
+        CHECK(a.key == b.key);
+        CHECK(b.periodsPerSecond > 0);
+    }
+    
+    TEST(Errors) {
+        CHECK_THROW(gronsfeldAnalyzer(0), cipher_error);
+        gronsfeldAnalyzer analyzer;
+        CHECK_THROW(analyzer.analyze(wideToUtf8(L"Щ")), cipher_error);
+        CHECK_THROW(analyzer.analyze(wideToUtf8(L"ЩЦЁ ЮЛ")), cipher_error);
+        CHECK_THROW(analyzer.analyze(wideToUtf8(L"ЩЦЁюл")), cipher_error);
+        // Длины больше половины текста не проверяются
+        CHECK_EQUAL(size_t(3), analyzer.analyze(wideToUtf8(L"ЩЦЁЮЛЖЗ")).periods.size());
+    }
+}
+
+SUITE(SharedInstanceTest)
+{
+    TEST(ConstCipherAcrossThreads) {
+        const modAlphaCipher cipher(L"ШИФРОВАЛЬЩИК");
+        vector<wstring> texts;
+        vector<wstring> expected;
+        for (int i = 0; i < 16; ++i) {
+            texts.push_back(wstring(1 + i * 37, L'А' + i) + L", привет мир " + to_wstring(i));
+            expected.push_back(cipher.encrypt(texts.back()));
+        }
+        atomic<int> mismatches(0);
+        vector<thread> workers;
+        for (int t = 0; t < 8; ++t) {
+            workers.emplace_back([&, t] {
+                wchar_t buf[1024];
+                for (int round = 0; round < 200; ++round) {
+                    size_t i = (t + round) % texts.size();
+                    wstring enc = cipher.encrypt(texts[i]);
+                    size_t n = cipher.decrypt(enc, buf);
+                    if (enc != expected[i] || cipher.decrypt(enc) != wstring(buf, n))
+                        ++mismatches;
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+        CHECK_EQUAL(0, mismatches.load());
+    }
 }
 
 /**
@@ -0,0 +1,115 @@
+/**
+ * @file bench.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Замеры производительности табличной маршрутной перестановки
+ * @details Измеряет шифрование и расшифрование при разном количестве столбцов,
+ * отдельно валидацию текста, перекодирование UTF-8 и саму перестановку
+ * (простой и блочный обход), а также подбор количества столбцов
+ * на сообщениях от 16 байт до --max-size
+ * (по умолчанию 16 МБ, для 1 ГБ — --max-size 1073741824).
+ * Результаты выводятся в JSON, --compare сравнивает их с базой.
+ */
+
+#include <codecvt>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <locale>
+#include <string>
+#include <vector>
+#include "table.h"
+#include "routeTranspose.h"
+#include "tableSolver.h"
+#include "../common/benchHarness.h"
+#include "../common/ruAlphabet.h"
+#include "../common/ruTranscode.h"
+using namespace std;
+
+/**
+ * @brief Главная функция замеров
+ * @param argc количество аргументов
+ * @param argv аргументы benchSuite
+ * @return 0, или 1 при регрессии относительно базы
+ */
+ 
+int main(int argc, char** argv)
+{
+    benchSuite suite("Table", argc, argv);
+    wstring_convert<codecvt_utf8<wchar_t>> conv;
+    Table validator(8);
+    
+    for (size_t size : suite.sizes()) {
+        string sz = "/size=" + to_string(size);
+        string text8 = benchText(size);
+        wstring text = conv.from_bytes(text8);
+        wstring cipher = validator.encrypt(text);
+        string cipher8 = conv.to_bytes(cipher);
+        volatile size_t sink = 0;
+        
+        suite.run("utf8/decode" + sz, size, [&] { sink = conv.from_bytes(text8).size(); });
+        suite.run("utf8/encode" + sz, size, [&] { sink = conv.to_bytes(text).size(); });
+        suite.run("validate/open" + sz, size, [&] {
+            sink = validator.validateOpenText(text);
+        });
+        suite.run("validate/cipher" + sz, size, [&] {
+            sink = validator.validateCipherText(cipher);
+        });
+        
+        // Модель триграмм по самому тексту; каждое выполнение проверяет 256 столбцов
+        if (size <= (1 << 20)) {
+            letterBuffer letters(text8.size());
+            letters.resize(ruDecodeOpen(text8.data(), text8.size(), letters.data()));
+            map<size_t, size_t> counts;
+            for (size_t i = 0; i + 3 <= letters.size(); ++i)
+                ++counts[(letters[i] * 33 + letters[i + 1]) * 33 + letters[i + 2]];
+            const string path = "bench_table_solver.model";
+            {
+                ofstream model(path);
+                for (auto [index, count] : counts)
+                    model << conv.to_bytes(wstring{RU_UPPER[index / 1089], RU_UPPER[index / 33 % 33],
+                                                   RU_UPPER[index % 33]}) << ' ' << count << '\n';
+            }
+            if (!counts.empty()) {
+                ngramModel model(path);
+                tableSolver single(model);
+                tableSolver parallel(model);
+                parallel.setParallel(0u);
+                string enc = Table(16).encryptUtf8(text8);
+                suite.run("solve/threads=1" + sz, enc.size(), [&] {
+                    sink = single.solve(enc, 256, 10)[0].cols;
+                });
+                suite.run("solve/threads=all" + sz, enc.size(), [&] {
+                    sink = parallel.solve(enc, 256, 10)[0].cols;
+                });
+            }
+            remove(path.c_str());
+        }
+        
+        for (int cols : {2, 16, 1000, 65536}) {
+            Table t(cols);
+            string k = "/cols=" + to_string(cols);
+            suite.run("encrypt" + k + sz, size, [&] { sink = t.encrypt(text).size(); });
+            suite.run("decrypt" + k + sz, size, [&] { sink = t.decrypt(cipher).size(); });
+            suite.run("encrypt/utf8" + k + sz, size, [&] { sink = t.encryptUtf8(text8).size(); });
+            suite.run("decrypt/utf8" + k + sz, size, [&] { sink = t.decryptUtf8(cipher8).size(); });
+            // Страница из середины: время не должно зависеть от size
+            size_t page = min<size_t>(4096, cipher.size() / 2);
+            suite.run("decrypt/range" + k + sz, 2 * page, [&] {
+                sink = t.decryptRange(string_view(cipher8), cipher.size() / 2, page).size();
+            });
+            
+            tableRoute route(cipher.size(), cols);
+            vector<wchar_t> out(cipher.size());
+            suite.run("route/simple" + k + sz, size, [&] {
+                routeSimple(cipher.data(), out.data(), route, false);
+            });
+            suite.run("route/tiled" + k + sz, size, [&] {
+                routeTiled(cipher.data(), out.data(), route, false,
+                           0, route.rows, 0, min(route.cols, route.n));
+            });
+        }
+    }
+    return suite.finish();
+}
@@ -9,47 +9,121 @@
 
 #include <iostream>
 #include <locale>
-#include <codecvt>
 #include <algorithm>
 #include <cwctype>
 #include <limits>
+#include <cstring>
 #include <string>
+#include <charconv>
 #include "table.h"
+#include "../common/linePipe.h"
+#include "../common/asyncIo.h"
+#include "../common/mappedFile.h"
 using namespace std;
 
 /**
- * @brief Преобразование строки UTF-8 в широкую строку
- * @param s строка в UTF-8
- * @return широкая строка
+ * @brief Строгий разбор количества столбцов
+ * @param s ключ из командной строки или диалога
+ * @return количество столбцов
+ * @throw cipher_error если строка не является целым десятичным числом целиком
  */
  
-wstring str8_to_w(const string& s)
+int parseColumns(const string& s)
 {
-    wstring_convert<codecvt_utf8<wchar_t>> conv;
-    return conv.from_bytes(s);
+    int cols = 0;
+    auto [end, ec] = from_chars(s.data(), s.data() + s.size(), cols);
+    if (s.empty() || ec != errc() || end != s.data() + s.size())
+        throw cipher_error("Invalid key");
+    return cols;
 }
 
 /**
- * @brief Преобразование широкой строки в строку UTF-8
- * @param ws широкая строка
- * @return строка в UTF-8
+ * @brief Неинтерактивный режим
+ * @param args ключ, направление, количество потоков и пути файлов
+ * @return 0 если все записи обработаны, иначе 1
+ * @details С -i/-o файл обрабатывается целиком через отображение в память,
+ * с -q — блоками через очередь io_uring (или pread/pwrite) с отчетом
+ * о скорости, с -p шифртекст записывается и читается в упакованном формате
+ * packedText, с -s — конвейером стадий в отдельных потоках с отчетом
+ * по стадиям. Для -s перестановка идет одним кадром Table::STAGE_WHOLE,
+ * поэтому шифртекст совместим с остальными режимами; без них каждая строка стандартного ввода — отдельная запись
  */
  
-string w_to_str8(const wstring& ws)
+int runPipe(const pipeArgs& args)
 {
-    wstring_convert<codecvt_utf8<wchar_t>> conv;
-    return conv.to_bytes(ws);
+    bool ready = false;
+    try {
+        Table cipher(parseColumns(args.key));
+        ready = true;
+        if (!args.inPath.empty() && args.queueDepth > 0) {
+            tableStream stream(cipher, args.decrypt);
+            filePipeline pipeline(args.queueDepth);
+            pipelineStats stats = pipeline.run(args.inPath, args.outPath,
+                [&](const char* data, size_t len, bool last, string& out) {
+                    stream.update(data, len);
+                    if (last)
+                        stream.finish(out);
+                });
+            cerr << stats.report() << endl;
+            return 0;
+        }
+        if (args.staged) {
+            stagedPipeline pipeline(cipher.stages(args.decrypt, Table::STAGE_WHOLE));
+            cerr << pipeline.run(args.inPath, args.outPath).report() << endl;
+            return 0;
+        }
+        if (args.packed) {
+            checkDistinctFiles(args.inPath, args.outPath);
+            mappedFile src(args.inPath);
+            string_view text(src.data(), src.size());
+            string out = args.decrypt ? cipher.decryptPacked(text) : cipher.encryptPacked(text);
+            mappedFile dst(args.outPath, out.size());
+            memcpy(dst.data(), out.data(), out.size());
+            return 0;
+        }
+        if (!args.inPath.empty()) {
+            if (args.decrypt) {
+                cipher.decryptFile(args.inPath, args.outPath);
+            } else {
+                cipher.encryptFile(args.inPath, args.outPath);
+            }
+            return 0;
+        }
+        linePipe pipe([&](const string& line) {
+            return args.decrypt ? cipher.decryptUtf8(line) : cipher.encryptUtf8(line);
+        }, args.threads);
+        return pipe.run() ? 1 : 0;
+    } catch (const cipher_error& e) {
+        cerr << (ready ? "Ошибка при обработке текста: " : "Ошибка инициализации шифра: ")
+             << e.what() << endl;
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+    }
+    return 1;
 }
 
 /**
  * @brief Главная функция программы
+ * @param argc количество аргументов
+ * @param argv аргументы неинтерактивного режима: -k КЛЮЧ (-e|-d) [-j N]
+ * [-i ВХОД -o ВЫХОД [-q ГЛУБИНА | -p | -s]];
+ * без аргументов запускается диалог
  * @return код завершения программы
  * @details Реализует диалоговый интерфейс для шифрования/расшифрования табличной перестановкой
  */
  
-int main()
+int main(int argc, char** argv)
 {
     setlocale(LC_ALL, "ru_RU.UTF-8");
+    if (argc > 1) {
+        pipeArgs args;
+        if (!parsePipeArgs(argc, argv, args)) {
+            cerr << "Использование: " << argv[0] << " -k СТОЛБЦОВ (-e|-d) [-j ПОТОКОВ] [-i ВХОД -o ВЫХОД [-q ГЛУБИНА | -p | -s]]" << endl;
+            return 2;
+        }
+        return runPipe(args);
+    }
+
     string keyLine;
     string msgLine;
     unsigned action;
@@ -58,7 +132,7 @@ int main()
     getline(cin, keyLine);
 
     try {
-        int cols = stoi(keyLine);
+        int cols = parseColumns(keyLine);
         Table cipher(cols);
         cout << "Таблица создана." << endl;
 
@@ -79,11 +153,9 @@ int main()
 
                 try {
                     if (action == 1) {
-                        wstring enc = cipher.encrypt(str8_to_w(msgLine));
-                        cout << "Зашифровано: " << w_to_str8(enc) << endl;
+                        cout << "Зашифровано: " << cipher.encryptUtf8(msgLine) << endl;
                     } else {
-                        wstring dec = cipher.decrypt(str8_to_w(msgLine));
-                        cout << "Расшифровано: " << w_to_str8(dec) << endl;
+                        cout << "Расшифровано: " << cipher.decryptUtf8(msgLine) << endl;
                     }
                 } catch (const cipher_error& e) {
                     cerr << "Ошибка при обработке текста: " << e.what() << endl;
@@ -0,0 +1,134 @@
+/**
+ * @file routeTranspose.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Перестановка по маршруту таблицы блоками, помещающимися в кэш
+ * @details Простой обход копирует текст столбец за столбцом: каждое чтение
+ * столбца попадает в новую строку таблицы, и на больших текстах почти каждое
+ * обращение промахивается мимо кэша. Блочный обход разбивает таблицу на
+ * плитки ROUTE_TILE_ROWS x ROUTE_TILE_COLS: внутри плитки читаются короткие
+ * отрезки строк и пишутся короткие отрезки столбцов, и обе стороны остаются
+ * в кэше. Результат совпадает с простым обходом.
+ */
+
+#pragma once
+#include "table.h"
+#include "../common/threadPool.h"
+#include <algorithm>
+#include <cstddef>
+using namespace std;
+
+const size_t ROUTE_TILE_ROWS = 256; ///< Высота плитки в строках
+const size_t ROUTE_TILE_COLS = 64; ///< Ширина плитки в столбцах
+const size_t ROUTE_TILED_MIN = 1 << 14; ///< Длина текста, с которой выгоден блочный обход
+
+/**
+ * @brief Простая перестановка по столбцам
+ * @param in исходный текст
+ * @param out результат
+ * @param route геометрия таблицы
+ * @param back false — шифрование (out[cipherPos(i)] = in[i]),
+ * true — расшифрование (out[i] = in[cipherPos(i)])
+ */
+template <class T>
+void routeSimple(const T* in, T* out, const tableRoute& route, bool back)
+{
+    for (size_t c = 0; c < min(route.cols, route.n); ++c) {
+        size_t start = route.columnStart(c);
+        size_t h = route.columnHeight(c);
+        for (size_t r = 0; r < h; ++r) {
+            if (back) {
+                out[r * route.cols + c] = in[start + r];
+            } else {
+                out[start + r] = in[r * route.cols + c];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Перестановка плитками в прямоугольнике строк [r0, r1) и столбцов [c0, c1)
+ * @details Разные прямоугольники пишут в непересекающиеся позиции результата,
+ * поэтому их можно обрабатывать в разных потоках без синхронизации
+ * @param in исходный текст
+ * @param out результат
+ * @param route геометрия таблицы
+ * @param back false — шифрование, true — расшифрование
+ * @param r0 первая строка
+ * @param r1 строка за последней
+ * @param c0 первый столбец
+ * @param c1 столбец за последним
+ */
+template <class T>
+void routeTiled(const T* in, T* out, const tableRoute& route, bool back,
+                size_t r0, size_t r1, size_t c0, size_t c1)
+{
+    for (size_t tr = r0; tr < r1; tr += ROUTE_TILE_ROWS) {
+        size_t trEnd = min(r1, tr + ROUTE_TILE_ROWS);
+        for (size_t tc = c0; tc < c1; tc += ROUTE_TILE_COLS) {
+            size_t tcEnd = min(c1, tc + ROUTE_TILE_COLS);
+            for (size_t c = tc; c < tcEnd; ++c) {
+                size_t start = route.columnStart(c);
+                size_t h = min(trEnd, route.columnHeight(c));
+                for (size_t r = tr; r < h; ++r) {
+                    if (back) {
+                        out[r * route.cols + c] = in[start + r];
+                    } else {
+                        out[start + r] = in[r * route.cols + c];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Перестановка по маршруту с выбором обхода по длине текста
+ * @param in исходный текст
+ * @param out результат
+ * @param route геометрия таблицы
+ * @param back false — шифрование, true — расшифрование
+ */
+template <class T>
+void routeTranspose(const T* in, T* out, const tableRoute& route, bool back)
+{
+    if (route.n < ROUTE_TILED_MIN) {
+        routeSimple(in, out, route, back);
+    } else {
+        routeTiled(in, out, route, back, 0, route.rows, 0, min(route.cols, route.n));
+    }
+}
+
+/**
+ * @brief Параллельная перестановка по маршруту на пуле потоков
+ * @details Таблица делится на полосы строк, кратные высоте плитки, а если
+ * строк слишком мало — на полосы столбцов. Начало каждого столбца в
+ * шифртексте известно из tableRoute::columnStart, поэтому полосы пишут
+ * в непересекающиеся позиции и не требуют синхронизации.
+ * @param pool пул потоков
+ * @param in исходный текст
+ * @param out результат
+ * @param route геометрия таблицы
+ * @param back false — шифрование, true — расшифрование
+ */
+template <class T>
+void routeParallel(threadPool& pool, const T* in, T* out, const tableRoute& route, bool back)
+{
+    size_t parts = pool.size();
+    size_t usedCols = min(route.cols, route.n);
+    if (route.rows >= parts * ROUTE_TILE_ROWS) {
+        size_t band = (route.rows + parts - 1) / parts;
+        band = (band + ROUTE_TILE_ROWS - 1) / ROUTE_TILE_ROWS * ROUTE_TILE_ROWS;
+        pool.parallelFor(parts, [&](size_t i) {
+            size_t r0 = min(route.rows, i * band);
+            routeTiled(in, out, route, back, r0, min(route.rows, r0 + band), 0, usedCols);
+        });
+    } else {
+        size_t band = (usedCols + parts - 1) / parts;
+        pool.parallelFor(parts, [&](size_t i) {
+            size_t c0 = min(usedCols, i * band);
+            routeTiled(in, out, route, back, 0, route.rows, c0, min(usedCols, c0 + band));
+        });
+    }
+}
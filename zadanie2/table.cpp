@@ -7,9 +7,14 @@
  */
 
 #include "table.h"
+#include "routeTranspose.h"
+#include "../common/ruAlphabet.h"
+#include "../common/ruUtf8.h"
+#include "../common/ruTranscode.h"
+#include "../common/packedText.h"
+#include "../common/threadPool.h"
 #include <algorithm>
 #include <vector>
-#include <cwctype>  
 using namespace std;
 
 /**
@@ -19,7 +24,7 @@ using namespace std;
  * @throw cipher_error если ключ неположительный
  */
  
-int Table::getValidKey(const int key)
+int Table::getValidKey(const int key) const
 {
     if (key <= 0)
         throw cipher_error("Invalid key: key must be positive");
@@ -27,30 +32,16 @@ int Table::getValidKey(const int key)
 }
 
 /**
- * @brief Валидация и нормализация открытого текста
+ * @brief Валидация открытого текста
  * @param s исходный открытый текст
- * @return валидированный текст в верхнем регистре без пробелов и не-букв
+ * @return номера букв текста, пробелы и не-буквы удалены
  * @throw cipher_error если текст пустой после обработки
  */
  
-wstring Table::getValidOpenText(const wstring& s)
+letterBuffer Table::getValidOpenText(wstring_view s) const
 {
-    wstring tmp;
-    wstring lower = L"абвгдеёжзийклмнопрстуфхцчшщъыьэюя";
-    wstring upper = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
-    
-    for (auto c : s) {
-        if (!iswspace(c)) { 
-            if (upper.find(c) != wstring::npos) {
-                tmp.push_back(c);
-            } else {
-                size_t pos = lower.find(c);
-                if (pos != wstring::npos) {
-                    tmp.push_back(upper[pos]); 
-                }
-            }
-        }
-    }
+    letterBuffer tmp(s.size());
+    tmp.resize(ruDecodeOpen(s, tmp.data()));
     if (tmp.empty())
         throw cipher_error("Empty open text");
     return tmp;
@@ -59,32 +50,64 @@ wstring Table::getValidOpenText(const wstring& s)
 /**
  * @brief Валидация зашифрованного текста
  * @param s исходный зашифрованный текст
- * @return валидированный зашифрованный текст
+ * @return номера букв текста
+ * @details Корректный текст проверяется и декодируется за один проход;
+ * при ошибке сообщение с приоритетом пробелов выбирает checkCipherText
  * @throw cipher_error если текст пустой или содержит недопустимые символы
  */
  
-wstring Table::getValidCipherText(const wstring& s)
+letterBuffer Table::getValidCipherText(wstring_view s) const
 {
     if (s.empty())
         throw cipher_error("Empty cipher text");
-    
-    for (auto c : s) {
-        if (iswspace(c)) {
-            throw cipher_error("Whitespace in cipher text");
-        }
+    letterBuffer tmp(s.size());
+    if (ruDecodeCipher(s, tmp.data()).status != RU_TEXT_OK)
+        checkCipherText(s);
+    return tmp;
+}
+
+/**
+ * @brief Перестановка номеров букв, на пуле потоков для длинных текстов
+ * @param in номера букв исходного текста
+ * @param back false — шифрование, true — расшифрование
+ * @return переставленные номера букв
+ * @details Столбцы считываются справа налево, каждый занимает в шифртексте
+ * непрерывный отрезок длины columnHeight(c) начиная с columnStart(c)
+ */
+ 
+letterBuffer Table::permute(const letterBuffer& in, bool back) const
+{
+    tableRoute route(in.size(), cols);
+    letterBuffer out(route.n);
+    if (pool && route.n >= parallelThreshold) {
+        routeParallel(*pool, in.data(), out.data(), route, back);
+    } else {
+        routeTranspose(in.data(), out.data(), route, back);
     }
+    return out;
+}
+
+/**
+ * @brief Проверка зашифрованного текста без копирования
+ * @param s исходный зашифрованный текст
+ * @throw cipher_error если текст пустой или содержит недопустимые символы
+ */
+ 
+void Table::checkCipherText(wstring_view s) const
+{
+    if (s.empty())
+        throw cipher_error("Empty cipher text");
     
-    wstring tmp;
-    for (auto c : s) {
-        tmp.push_back(c);
-    }
+    ruDecodeResult res = ruDecodeCipher(s, nullptr);
+    if (res.status == RU_TEXT_OK)
+        return;
     
-    wstring upper = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";  
-    for (auto c : tmp) {
-        if (upper.find(c) == wstring::npos)
-            throw cipher_error("Invalid cipher text");
+    // Пробелы проверяются раньше прочих недопустимых символов во всем тексте
+    for (size_t i = res.errorPos; i < s.size(); ++i) {
+        if (ruClassify(s[i]) == RU_CLASS_SPACE)
+            throw cipher_error("Whitespace in cipher text");
     }
-    return tmp;
+    throw cipher_error("Invalid cipher text");
 }
 
 /**
@@ -93,9 +116,36 @@ wstring Table::getValidCipherText(const wstring& s)
  * @throw cipher_error если ключ невалиден
  */
  
-Table::Table(int key)
+Table::Table(int key):
+    cols(getValidKey(key))
+{
+}
+
+/**
+ * @brief Включение параллельного режима на общем пуле потоков
+ * @param p пул потоков, nullptr отключает параллельный режим
+ * @param threshold минимальная длина текста, при которой используется пул
+ */
+ 
+void Table::setParallel(shared_ptr<threadPool> p, size_t threshold)
 {
-    cols = getValidKey(key);
+    pool = move(p);
+    parallelThreshold = threshold;
+}
+
+/**
+ * @brief Включение параллельного режима на собственном пуле
+ * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+ * @param threshold минимальная длина текста, при которой используется пул
+ */
+ 
+void Table::setParallel(unsigned threads, size_t threshold)
+{
+    if (threads == 1) {
+        setParallel(nullptr, threshold);
+    } else {
+        setParallel(make_shared<threadPool>(threads), threshold);
+    }
 }
 
 /**
@@ -107,82 +157,422 @@ Table::Table(int key)
  * @throw cipher_error если открытый текст невалиден
  */
  
-wstring Table::encrypt(const wstring& plain)
+wstring Table::encrypt(const wstring& plain) const
+{
+    letterBuffer letters = permute(getValidOpenText(plain), false);
+    wstring out(letters.size(), L' ');
+    ruEncodeUpper(letters.data(), letters.size(), &out[0]);
+    return out;
+}
+
+/**
+ * @brief Расшифрование зашифрованного текста табличной перестановкой
+ * @param cipher зашифрованный текст для расшифрования
+ * @return расшифрованный текст
+ * @details Обратный процесс шифрованию: буква открытого текста в позиции i
+ * берется из позиции tableRoute::cipherPos(i) шифртекста
+ * @throw cipher_error если зашифрованный текст невалиден
+ */
+ 
+wstring Table::decrypt(const wstring& cipher) const
 {
-    wstring validText = getValidOpenText(plain);
-    int n = static_cast<int>(validText.length());
-    int rows = (n + cols - 1) / cols;
+    letterBuffer letters = permute(getValidCipherText(cipher), true);
+    wstring out(letters.size(), L' ');
+    ruEncodeUpper(letters.data(), letters.size(), &out[0]);
+    return out;
+}
 
-    vector<vector<wchar_t>> grid(rows, vector<wchar_t>(cols, L' '));
-    int pos = 0;
+/**
+ * @brief Проверка открытого текста теми же правилами, что и в encrypt
+ * @param plain открытый текст
+ * @return количество букв
+ * @details Вызывает getValidOpenText без последующего шифрования
+ * @throw cipher_error если текст пустой после удаления не-букв
+ */
+ 
+size_t Table::validateOpenText(wstring_view plain) const
+{
+    return getValidOpenText(plain).size();
+}
 
-    // Заполнение таблицы по горизонтали слева направо, сверху вниз
-    for (int r = 0; r < rows; ++r) {
-        for (int c = 0; c < cols; ++c) {
-            if (pos < n) {
-                grid[r][c] = validText[pos++];
-            }
-        }
-    }
+/**
+ * @brief Проверка зашифрованного текста теми же правилами, что и в decrypt
+ * @param cipher зашифрованный текст
+ * @return количество букв
+ * @details Вызывает getValidCipherText без последующего расшифрования
+ * @throw cipher_error если текст пустой или содержит недопустимые символы
+ */
+ 
+size_t Table::validateCipherText(wstring_view cipher) const
+{
+    return getValidCipherText(cipher).size();
+}
 
-    wstring out;
-    out.reserve(n);
-    
-    // Считывание таблицы сверху вниз, справа налево
-    for (int c = cols - 1; c >= 0; --c) {
-        for (int r = 0; r < rows; ++r) {
-            if (grid[r][c] != L' ') {
-                out += grid[r][c];
-            }
+/**
+ * @brief Шифрование открытого текста в UTF-8 без преобразования в wstring
+ * @param plain открытый текст в UTF-8
+ * @return шифртекст в UTF-8
+ * @throw cipher_error если в тексте нет букв
+ */
+ 
+string Table::encryptUtf8(string_view plain) const
+{
+    letterBuffer src(plain.size() / RU_UTF8_LETTER);
+    src.resize(ruDecodeOpen(plain.data(), plain.size(), src.data()));
+    if (src.empty())
+        throw cipher_error("Empty open text");
+    letterBuffer dst = permute(src, false);
+    string out(RU_UTF8_LETTER * dst.size(), '\0');
+    ruEncodeUpper(dst.data(), dst.size(), &out[0]);
+    return out;
+}
+
+/**
+ * @brief Декодирование шифртекста UTF-8 с проверкой по правилам checkCipherText
+ * @param cipher шифртекст в UTF-8
+ * @param out номера букв
+ * @return количество букв
+ * @details Декодер останавливается на первом недопустимом символе; если это
+ * не пробел, остаток текста еще проверяется на пробелы, которые, как
+ * в checkCipherText, имеют приоритет
+ * @throw cipher_error если текст содержит пробелы или недопустимые символы
+ */
+ 
+size_t Table::decodeCipher(string_view cipher, uint8_t* out) const
+{
+    ruDecodeResult res = ruDecodeCipher(cipher.data(), cipher.size(), out);
+    if (res.status == RU_TEXT_INVALID) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(cipher.data());
+        for (size_t pos = res.errorPos; pos < cipher.size();) {
+            wchar_t c;
+            pos += ruUtf8Next(p + pos, cipher.size() - pos, c);
+            if (ruClassify(c) == RU_CLASS_SPACE)
+                throw cipher_error("Whitespace in cipher text");
         }
+        throw cipher_error("Invalid cipher text");
     }
+    if (res.status == RU_TEXT_SPACE)
+        throw cipher_error("Whitespace in cipher text");
+    return res.letters;
+}
+
+/**
+ * @brief Расшифрование шифртекста в UTF-8 без преобразования в wstring
+ * @param cipher шифртекст в UTF-8
+ * @return открытый текст в UTF-8
+ * @details Текст проверяется и декодируется decodeCipher
+ * @throw cipher_error если текст невалиден
+ */
+ 
+string Table::decryptUtf8(string_view cipher) const
+{
+    if (cipher.empty())
+        throw cipher_error("Empty cipher text");
+    letterBuffer src(cipher.size() / RU_UTF8_LETTER);
+    src.resize(decodeCipher(cipher, src.data()));
+    letterBuffer dst = permute(src, true);
+    string out(RU_UTF8_LETTER * dst.size(), '\0');
+    ruEncodeUpper(dst.data(), dst.size(), &out[0]);
     return out;
 }
 
 /**
- * @brief Расшифрование зашифрованного текста табличной перестановкой
- * @param cipher зашифрованный текст для расшифрования
- * @return расшифрованный текст
- * @details Обратный процесс шифрованию с учетом маршрутов
- * @throw cipher_error если зашифрованный текст невалиден
+ * @brief Отпечаток ключа для заголовка упакованного формата
+ * @return FNV-1a 64 количества столбцов (8 байт little-endian)
  */
  
-wstring Table::decrypt(const wstring& cipher)
+uint64_t Table::keyFingerprint() const
 {
-    wstring validText = getValidCipherText(cipher);
-    int n = static_cast<int>(validText.length());
-    int rows = (n + cols - 1) / cols;
-    
-    int fullCols = n % cols;
-    if (fullCols == 0) fullCols = cols;
+    uint8_t bytes[8];
+    for (size_t i = 0; i < sizeof(bytes); ++i)
+        bytes[i] = static_cast<uint8_t>(uint64_t(cols) >> (8 * i));
+    return fnv1a64(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Шифрование открытого текста в упакованный контейнер
+ * @param plain открытый текст в UTF-8
+ * @return заголовок packedText и шифртекст по 6 бит на букву
+ * @throw cipher_error если в тексте нет букв
+ */
+ 
+string Table::encryptPacked(string_view plain) const
+{
+    letterBuffer src(plain.size() / RU_UTF8_LETTER);
+    src.resize(ruDecodeOpen(plain.data(), plain.size(), src.data()));
+    if (src.empty())
+        throw cipher_error("Empty open text");
+    letterBuffer dst = permute(src, false);
+    return packedEncode({PACKED_TABLE, dst.size(), keyFingerprint()}, dst.data());
+}
+
+/**
+ * @brief Расшифрование упакованного контейнера
+ * @param packed контейнер, записанный encryptPacked с тем же ключом
+ * @return открытый текст в UTF-8
+ * @throw cipher_error если контейнер поврежден, пуст, записан другим
+ * шифром или с другим ключом
+ */
+ 
+string Table::decryptPacked(string_view packed) const
+{
+    letterBuffer src;
+    packedStatus status = packedDecode(packed, PACKED_TABLE, keyFingerprint(), src);
+    if (status != PACKED_OK)
+        throw cipher_error(packedMessage(status));
+    if (src.empty())
+        throw cipher_error("Empty cipher text");
+    letterBuffer dst = permute(src, true);
+    string out(RU_UTF8_LETTER * dst.size(), '\0');
+    ruEncodeUpper(dst.data(), dst.size(), &out[0]);
+    return out;
+}
+
+/**
+ * @brief Расшифрование диапазона букв шифртекста в UTF-8
+ * @param cipher весь шифртекст в UTF-8
+ * @param offset номер первой буквы открытого текста
+ * @param length количество букв; обрезается по концу текста
+ * @return открытый текст диапазона в UTF-8
+ * @details Перестановка не меняет букв, поэтому собранные двухбайтовые
+ * символы после проверки и есть открытый текст
+ * @throw cipher_error если шифртекст пуст, имеет нечетную длину, offset
+ * за концом или собранные буквы недопустимы
+ */
+ 
+string Table::decryptRange(string_view cipher, size_t offset, size_t length) const
+{
+    if (cipher.empty())
+        throw cipher_error("Empty cipher text");
+    if (cipher.size() % RU_UTF8_LETTER != 0)
+        throw cipher_error("Invalid cipher text");
+    size_t total = cipher.size() / RU_UTF8_LETTER;
+    if (offset > total)
+        throw cipher_error("Range out of cipher text");
+    length = min(length, total - offset);
+    tableRoute route(total, cols);
+    string out(RU_UTF8_LETTER * length, '\0');
+    route.forEachCipherPos(offset, length, [&](size_t k, size_t pos) {
+        out[RU_UTF8_LETTER * k] = cipher[RU_UTF8_LETTER * pos];
+        out[RU_UTF8_LETTER * k + 1] = cipher[RU_UTF8_LETTER * pos + 1];
+    });
+    letterBuffer check(length);
+    decodeCipher(out, check.data());
+    return out;
+}
+
+/**
+ * @brief Расшифрование диапазона букв широкого шифртекста
+ * @param cipher весь шифртекст
+ * @param offset номер первой буквы открытого текста
+ * @param length количество букв; обрезается по концу текста
+ * @return открытый текст диапазона
+ * @throw cipher_error если шифртекст пуст, offset за концом или собранные
+ * буквы недопустимы
+ */
+ 
+wstring Table::decryptRange(wstring_view cipher, size_t offset, size_t length) const
+{
+    if (cipher.empty())
+        throw cipher_error("Empty cipher text");
+    if (offset > cipher.size())
+        throw cipher_error("Range out of cipher text");
+    length = min(length, cipher.size() - offset);
+    tableRoute route(cipher.size(), cols);
+    wstring out(length, L' ');
+    route.forEachCipherPos(offset, length, [&](size_t k, size_t pos) {
+        out[k] = cipher[pos];
+    });
+    if (length != 0)
+        checkCipherText(out);
+    return out;
+}
 
-    vector<vector<wchar_t>> grid(rows, vector<wchar_t>(cols, L' '));
-    int pos = 0;
+/**
+ * @brief Пакетное шифрование многих открытых текстов за один вызов
+ * @param plains открытые тексты
+ * @return зашифрованные тексты в одном буфере с таблицей смещений
+ * @throw cipher_error если хотя бы один текст невалиден
+ */
+ 
+textBatch Table::encryptBatch(span<const wstring_view> plains) const
+{
+    return runBatch(plains, false);
+}
+
+/**
+ * @brief Пакетное расшифрование многих зашифрованных текстов за один вызов
+ * @param ciphers зашифрованные тексты
+ * @return расшифрованные тексты в одном буфере с таблицей смещений
+ * @throw cipher_error если хотя бы один текст невалиден
+ */
+ 
+textBatch Table::decryptBatch(span<const wstring_view> ciphers) const
+{
+    return runBatch(ciphers, true);
+}
 
-    // Заполнение таблицы по маршруту считывания (сверху вниз, справа налево)
-    for (int c = cols - 1; c >= 0; --c) {
-        int h = rows;
+/**
+ * @brief Пакетное шифрование или расшифрование
+ * @param texts исходные тексты
+ * @param back true — расшифрование, false — шифрование
+ * @return результаты в одном буфере
+ * @details Общий буфер выделяется один раз по суммарной длине пакета.
+ * Номера букв очередного текста отбираются и переставляются в двух
+ * переиспользуемых буферах длины самого длинного текста, затем
+ * записываются на свое место в общем буфере.
+ * @throw cipher_error если хотя бы один текст невалиден
+ */
+ 
+textBatch Table::runBatch(span<const wstring_view> texts, bool back) const
+{
+    size_t total = 0;
+    size_t longest = 0;
+    for (auto t : texts) {
+        total += t.size();
+        longest = max(longest, t.size());
+    }
+    textBatch out;
+    out.text.reserve(total);
+    out.offsets.reserve(texts.size() + 1);
+    out.offsets.push_back(0);
+    letterBuffer letters(longest);
+    letterBuffer routed(longest);
     
-        if (c >= fullCols) {
-            h = rows - 1;
-        }
-        for (int r = 0; r < h; ++r) {
-            if (pos < n) {
-                grid[r][c] = validText[pos++];
-            }
+    for (size_t i = 0; i < texts.size(); ++i) {
+        size_t n = 0;
+        try {
+            if (back)
+                checkCipherText(texts[i]);
+            n = ruDecodeOpen(texts[i], letters.data());
+            if (n == 0)
+                throw cipher_error("Empty open text");
+        } catch (const cipher_error& e) {
+            throw cipher_error(string(e.what()) + " in batch item " + to_string(i));
         }
+        routeTranspose(letters.data(), routed.data(), tableRoute(n, cols), back);
+        size_t from = out.text.size();
+        out.text.resize(from + n);
+        ruEncodeUpper(routed.data(), n, &out.text[from]);
+        out.offsets.push_back(out.text.size());
     }
+    return out;
+}
 
-    wstring out;
-    out.reserve(n);
+/**
+ * @brief Шифрование в буфер вызывающего без выделения памяти
+ * @param plain открытый текст
+ * @param out буфер результата, не пересекается с plain
+ * @return количество записанных букв
+ * @details Первый проход считает буквы, второй пишет букву с номером
+ * i = r * cols + c в позицию columnStart(c) + r
+ * @throw cipher_error если текст невалиден или буфер мал
+ */
+ 
+size_t Table::encrypt(wstring_view plain, span<wchar_t> out) const
+{
+    size_t n = 0;
+    for (auto c : plain) {
+        if (ruIsLetter(ruClassify(c)))
+            ++n;
+    }
+    if (n == 0)
+        throw cipher_error("Empty open text");
+    if (n > out.size())
+        throw cipher_error("Output buffer too small");
     
-    // Считывание таблицы по маршруту записи (по горизонтали слева направо, сверху вниз)
-    for (int r = 0; r < rows; ++r) {
-        for (int c = 0; c < cols; ++c) {
-            if (grid[r][c] != L' ') {
-                out += grid[r][c];
+    tableRoute route(n, cols);
+    size_t r = 0;
+    size_t c = 0;
+    for (auto sym : plain) {
+        uint8_t cls = ruClassify(sym);
+        if (ruIsLetter(cls)) {
+            out[route.columnStart(c) + r] = RU_UPPER[ruIndex(cls)];
+            if (++c == route.cols) {
+                c = 0;
+                ++r;
             }
         }
     }
-    return out;
+    return n;
+}
+
+/**
+ * @brief Расшифрование в буфер вызывающего без выделения памяти
+ * @param cipher зашифрованный текст
+ * @param out буфер результата, не пересекается с cipher
+ * @return количество записанных букв
+ * @throw cipher_error если текст невалиден или буфер мал
+ */
+ 
+size_t Table::decrypt(wstring_view cipher, span<wchar_t> out) const
+{
+    checkCipherText(cipher);
+    if (cipher.size() > out.size())
+        throw cipher_error("Output buffer too small");
+    tableRoute route(cipher.size(), cols);
+    routeTranspose(cipher.data(), out.data(), route, true);
+    return route.n;
+}
+
+/**
+ * @brief Конструктор сеанса
+ * @param t шифр с установленным ключом
+ * @param decrypt true — расшифрование, false — шифрование
+ */
+ 
+tableStream::tableStream(const Table& t, bool decrypt):
+    table(t), back(decrypt)
+{
+}
+
+/**
+ * @brief Прием очередной части текста в UTF-8
+ * @param data часть текста; может обрываться посреди символа
+ * @param len длина части в байтах
+ * @details Пробельный символ в шифртексте — ошибка сразу, прочие недопустимые
+ * символы запоминаются до finish: так сохраняется порядок проверок checkCipherText
+ * @throw cipher_error если в шифртексте есть пробельный символ
+ */
+ 
+void tableStream::update(const char* data, size_t len)
+{
+    bytes += len;
+    ruUtf8Feed(tail, tailLen, data, len, [&](wchar_t c) {
+        uint8_t cls = ruClassify(c);
+        if (back) {
+            if (cls == RU_CLASS_SPACE)
+                throw cipher_error("Whitespace in cipher text");
+            if (!ruIsUpper(cls))
+                invalid = true;
+        }
+        if (ruIsLetter(cls))
+            letters.push_back(ruIndex(cls));
+    });
+}
+
+/**
+ * @brief Завершение сеанса и перестановка
+ * @param out результат в UTF-8 дописывается в конец
+ * @throw cipher_error если текст невалиден
+ */
+ 
+void tableStream::finish(string& out)
+{
+    if (back) {
+        if (bytes == 0)
+            throw cipher_error("Empty cipher text");
+        if (invalid || tailLen > 0)
+            throw cipher_error("Invalid cipher text");
+    } else if (letters.empty()) {
+        throw cipher_error("Empty open text");
+    }
+    
+    // Накопленный текст освобождается до выделения результата в UTF-8
+    letterBuffer routed = table.permute(letters, back);
+    letterBuffer().swap(letters);
+    size_t at = out.size();
+    out.resize(at + RU_UTF8_LETTER * routed.size());
+    ruEncodeUpper(routed.data(), routed.size(), &out[at]);
+    bytes = 0;
 }
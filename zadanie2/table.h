@@ -8,42 +8,135 @@
  */
 
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <string_view>
+#include "../common/cipherError.h"
+#include "../common/textBatch.h"
+#include "../common/ruTranscode.h"
+#include "../common/mappedFile.h"
+#include "../common/stagedPipeline.h"
 using namespace std;
 
+class threadPool;
+
 /**
- * @brief Класс-исключение для ошибок шифрования
- * @details Наследуется от std::invalid_argument
+ * @brief Геометрия таблицы маршрутной перестановки
+ * @details Таблица из rows строк и cols столбцов заполняется по строкам,
+ * последняя строка занята только в первых fullCols столбцах. Столбцы
+ * считываются справа налево, поэтому позиция любой буквы в шифртексте
+ * вычисляется по формуле без построения самой таблицы.
  */
-class cipher_error: public invalid_argument {
-public:
+struct tableRoute {
+    size_t n; ///< Количество букв
+    size_t cols; ///< Количество столбцов
+    size_t rows; ///< Количество строк
+    size_t fullCols; ///< Количество столбцов полной высоты
+    
+    /**
+     * @brief Конструктор геометрии
+     * @param len количество букв (больше нуля)
+     * @param columns количество столбцов (больше нуля)
+     */
+    tableRoute(size_t len, size_t columns):
+        n(len), cols(columns), rows((len + columns - 1) / columns),
+        fullCols(len % columns == 0 ? columns : len % columns) {}
+    
     /**
-     * @brief Конструктор с параметром string
-     * @param what_arg сообщение об ошибке
+     * @brief Высота столбца
+     * @param c номер столбца
+     * @return rows для первых fullCols столбцов, rows - 1 для остальных
      */
-    explicit cipher_error (const string& what_arg):
-        invalid_argument(what_arg) {}
+    size_t columnHeight(size_t c) const
+    {
+        return c < fullCols ? rows : rows - 1;
+    }
     
     /**
-     * @brief Конструктор с параметром const char*
-     * @param what_arg сообщение об ошибке
+     * @brief Позиция начала столбца в шифртексте
+     * @param c номер столбца
+     * @return суммарная высота столбцов правее c
      */
-    explicit cipher_error (const char* what_arg):
-        invalid_argument(what_arg) {}
+    size_t columnStart(size_t c) const
+    {
+        size_t after = cols - 1 - c;
+        size_t shortAfter = cols - max(c + 1, fullCols);
+        return after * rows - shortAfter;
+    }
+    
+    /**
+     * @brief Позиция буквы открытого текста в шифртексте
+     * @param i позиция в открытом тексте
+     * @return позиция в шифртексте
+     */
+    size_t cipherPos(size_t i) const
+    {
+        return columnStart(i % cols) + i / cols;
+    }
+    
+    /**
+     * @brief Обход позиций шифртекста для отрезка открытого текста
+     * @param offset первая позиция в открытом тексте
+     * @param length количество позиций
+     * @param f вызывается как f(k, cipherPos(offset + k)) для k по возрастанию
+     * @details Начало следующего столбца получается вычитанием его высоты,
+     * поэтому деление выполняется один раз на весь отрезок
+     */
+    template <class F>
+    void forEachCipherPos(size_t offset, size_t length, F f) const
+    {
+        size_t c = offset % cols;
+        size_t r = offset / cols;
+        size_t start = columnStart(c);
+        for (size_t k = 0; k < length; ++k) {
+            f(k, start + r);
+            if (++c == cols) {
+                c = 0;
+                ++r;
+                start = columnStart(0);
+            } else {
+                start -= columnHeight(c);
+            }
+        }
+    }
 };
 
 /**
  * @brief Класс для шифрования табличной маршрутной перестановкой
  * @details Реализует шифрование и расшифрование текста методом табличной перестановки
  * с маршрутом записи: по горизонтали слева направо, сверху вниз
- * с маршрутом считывания: сверху вниз, справа налево
+ * с маршрутом считывания: сверху вниз, справа налево.
+ * Количество столбцов после конструктора не меняется, а маршрут tableRoute
+ * строится заново в каждом вызове, поэтому вызовы из разных потоков
+ * не мешают друг другу. Перестановка выполняется над номерами букв (letterBuffer,
+ * байт на букву), широкие строки и UTF-8 преобразуются на входе и выходе.
  */
 class Table
 {
+    friend class tableStream;
+    friend class tableReader;
+public:
+    /// Длина текста по умолчанию, начиная с которой используется пул
+    static const size_t PARALLEL_THRESHOLD = 1 << 20;
+    
+    /// Бюджет памяти по умолчанию для шифрования файлов, байт
+    static const size_t FILE_BUDGET = size_t(256) << 20;
+    
+    /// Длина кадра по умолчанию для stagedPipeline, букв
+    static const size_t STAGE_FRAME = size_t(1) << 20;
+    
+    /// Кадр во весь текст: стадии дают тот же шифртекст, что encryptUtf8, ценой буфера на весь текст
+    static const size_t STAGE_WHOLE = SIZE_MAX;
+    
 private:
-    int cols; ///< Количество столбцов таблицы (ключ шифрования)
+    const int cols; ///< Количество столбцов таблицы (ключ шифрования)
+    shared_ptr<threadPool> pool; ///< Пул потоков для больших текстов (может быть пустым)
+    size_t parallelThreshold = PARALLEL_THRESHOLD; ///< Минимальная длина текста для пула
     
     /**
      * @brief Валидация ключа (количества столбцов)
@@ -52,25 +145,69 @@ private:
      * @throw cipher_error если ключ неположительный
      */
      
-    int getValidKey(const int key);
+    int getValidKey(const int key) const;
     
     /**
-     * @brief Валидация и нормализация открытого текста
+     * @brief Валидация открытого текста
      * @param s исходный открытый текст
-     * @return валидированный открытый текст
+     * @return номера букв текста
      * @throw cipher_error если текст пустой после удаления не-букв
      */
      
-    wstring getValidOpenText(const wstring& s);
+    letterBuffer getValidOpenText(wstring_view s) const;
     
     /**
      * @brief Валидация зашифрованного текста
      * @param s исходный зашифрованный текст
-     * @return валидированный зашифрованный текст
+     * @return номера букв текста
      * @throw cipher_error если текст пустой или содержит недопустимые символы
      */
      
-    wstring getValidCipherText(const wstring& s);
+    letterBuffer getValidCipherText(wstring_view s) const;
+    
+    /**
+     * @brief Перестановка номеров букв, на пуле потоков для длинных текстов
+     * @param in номера букв исходного текста
+     * @param back false — шифрование, true — расшифрование
+     * @return переставленные номера букв
+     */
+     
+    letterBuffer permute(const letterBuffer& in, bool back) const;
+    
+    /**
+     * @brief Отпечаток ключа для заголовка упакованного формата
+     * @return FNV-1a 64 количества столбцов (8 байт little-endian)
+     */
+     
+    uint64_t keyFingerprint() const;
+    
+    /**
+     * @brief Проверка зашифрованного текста без копирования
+     * @param s исходный зашифрованный текст
+     * @throw cipher_error если текст пустой или содержит недопустимые символы
+     */
+     
+    void checkCipherText(wstring_view s) const;
+    
+    /**
+     * @brief Декодирование шифртекста UTF-8 с проверкой по правилам checkCipherText
+     * @param cipher шифртекст в UTF-8 (пустота не проверяется)
+     * @param out номера букв; достаточно cipher.size() / 2 элементов
+     * @return количество букв
+     * @throw cipher_error если текст содержит пробелы или недопустимые символы
+     */
+     
+    size_t decodeCipher(string_view cipher, uint8_t* out) const;
+    
+    /**
+     * @brief Пакетное шифрование или расшифрование
+     * @param texts исходные тексты
+     * @param back true — расшифрование, false — шифрование
+     * @return результаты в одном буфере
+     * @throw cipher_error если хотя бы один текст невалиден
+     */
+     
+    textBatch runBatch(span<const wstring_view> texts, bool back) const;
     
 public:
     /**
@@ -81,6 +218,23 @@ public:
      
     explicit Table(int key);
     
+    /**
+     * @brief Включение параллельного режима на общем пуле потоков
+     * @param p пул потоков, nullptr отключает параллельный режим
+     * @param threshold минимальная длина текста, при которой используется пул
+     * @details Не синхронизируется с шифрованием в других потоках
+     */
+     
+    void setParallel(shared_ptr<threadPool> p, size_t threshold = PARALLEL_THRESHOLD);
+    
+    /**
+     * @brief Включение параллельного режима на собственном пуле
+     * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+     * @param threshold минимальная длина текста, при которой используется пул
+     */
+     
+    void setParallel(unsigned threads, size_t threshold = PARALLEL_THRESHOLD);
+    
     /**
      * @brief Шифрование открытого текста
      * @param plain открытый текст для шифрования
@@ -88,7 +242,7 @@ public:
      * @throw cipher_error если текст невалиден
      */
      
-    wstring encrypt(const wstring& plain);
+    wstring encrypt(const wstring& plain) const;
     
     /**
      * @brief Расшифрование зашифрованного текста
@@ -97,5 +251,272 @@ public:
      * @throw cipher_error если текст невалиден
      */
      
-    wstring decrypt(const wstring& cipher);
+    wstring decrypt(const wstring& cipher) const;
+    
+    /**
+     * @brief Проверка открытого текста теми же правилами, что и в encrypt
+     * @param plain открытый текст
+     * @return количество букв
+     * @throw cipher_error если текст пустой после удаления не-букв
+     */
+     
+    size_t validateOpenText(wstring_view plain) const;
+    
+    /**
+     * @brief Проверка зашифрованного текста теми же правилами, что и в decrypt
+     * @param cipher зашифрованный текст
+     * @return количество букв
+     * @throw cipher_error если текст пустой или содержит недопустимые символы
+     */
+     
+    size_t validateCipherText(wstring_view cipher) const;
+    
+    /**
+     * @brief Шифрование открытого текста в UTF-8 без преобразования в wstring
+     * @param plain открытый текст в UTF-8
+     * @return шифртекст в UTF-8
+     * @details Перестановка выполняется над однобайтовыми номерами букв
+     * из ruDecodeOpen, результат кодируется ruEncodeUpper
+     * @throw cipher_error если в тексте нет букв
+     */
+     
+    string encryptUtf8(string_view plain) const;
+    
+    /**
+     * @brief Расшифрование шифртекста в UTF-8 без преобразования в wstring
+     * @param cipher шифртекст в UTF-8
+     * @return открытый текст в UTF-8
+     * @throw cipher_error если текст невалиден (правила как у decrypt)
+     */
+     
+    string decryptUtf8(string_view cipher) const;
+    
+    /**
+     * @brief Шифрование открытого текста в упакованный контейнер
+     * @param plain открытый текст в UTF-8
+     * @return заголовок packedText и шифртекст по 6 бит на букву
+     * @throw cipher_error если в тексте нет букв
+     */
+     
+    string encryptPacked(string_view plain) const;
+    
+    /**
+     * @brief Расшифрование упакованного контейнера
+     * @param packed контейнер, записанный encryptPacked с тем же ключом
+     * @return открытый текст в UTF-8
+     * @throw cipher_error если контейнер поврежден, пуст, записан другим
+     * шифром или с другим ключом
+     */
+     
+    string decryptPacked(string_view packed) const;
+    
+    /**
+     * @brief Расшифрование диапазона букв шифртекста в UTF-8
+     * @param cipher весь шифртекст в UTF-8 (например, отображенный файл)
+     * @param offset номер первой буквы открытого текста
+     * @param length количество букв; обрезается по концу текста
+     * @return открытый текст диапазона в UTF-8
+     * @details Геометрия таблицы (tableRoute) определяется длиной шифртекста,
+     * буква i открытого текста — это два байта шифртекста по смещению
+     * 2 * cipherPos(i). Собираются и проверяются только эти байты, таблица
+     * не строится. Результат совпадает с частью decryptUtf8 для всего текста.
+     * @throw cipher_error если шифртекст пуст, имеет нечетную длину, offset
+     * больше числа букв или собранные буквы недопустимы
+     */
+     
+    string decryptRange(string_view cipher, size_t offset, size_t length) const;
+    
+    /**
+     * @brief Расшифрование диапазона букв широкого шифртекста
+     * @param cipher весь шифртекст
+     * @param offset номер первой буквы открытого текста
+     * @param length количество букв; обрезается по концу текста
+     * @return открытый текст диапазона, совпадающий с частью decrypt
+     * @throw cipher_error если шифртекст пуст, offset больше его длины или
+     * собранные буквы недопустимы
+     */
+     
+    wstring decryptRange(wstring_view cipher, size_t offset, size_t length) const;
+    
+    /**
+     * @brief Пакетное шифрование многих открытых текстов за один вызов
+     * @param plains открытые тексты
+     * @return зашифрованные тексты в одном буфере с таблицей смещений
+     * @throw cipher_error если хотя бы один текст невалиден (в сообщении указан номер)
+     */
+     
+    textBatch encryptBatch(span<const wstring_view> plains) const;
+    
+    /**
+     * @brief Пакетное расшифрование многих зашифрованных текстов за один вызов
+     * @param ciphers зашифрованные тексты
+     * @return расшифрованные тексты в одном буфере с таблицей смещений
+     * @throw cipher_error если хотя бы один текст невалиден (в сообщении указан номер)
+     */
+     
+    textBatch decryptBatch(span<const wstring_view> ciphers) const;
+    
+    /**
+     * @brief Шифрование в буфер вызывающего без выделения памяти
+     * @param plain открытый текст
+     * @param out буфер результата, не пересекается с plain
+     * @return количество записанных букв
+     * @details Каждая буква открытого текста пишется сразу в свою позицию
+     * tableRoute::cipherPos, поэтому промежуточный буфер не нужен
+     * @throw cipher_error если текст невалиден или буфер мал
+     */
+     
+    size_t encrypt(wstring_view plain, span<wchar_t> out) const;
+    
+    /**
+     * @brief Расшифрование в буфер вызывающего без выделения памяти
+     * @param cipher зашифрованный текст
+     * @param out буфер результата, не пересекается с cipher
+     * @return количество записанных букв
+     * @throw cipher_error если текст невалиден или буфер мал
+     */
+     
+    size_t decrypt(wstring_view cipher, span<wchar_t> out) const;
+    
+    /**
+     * @brief Шифрование файла UTF-8 в файл без загрузки текста в память
+     * @param inPath путь к открытому тексту
+     * @param outPath путь к результату (создается или перезаписывается)
+     * @param memoryBudget ограничение на объем страниц, одновременно
+     * находящихся в памяти процесса, байт
+     * @details Буквы входного файла сначала переписываются во временный файл
+     * рядом с результатом, затем перестановка выполняется полосами столбцов
+     * с освобождением обработанных страниц
+     * @throw cipher_error если текст невалиден
+     * @throw system_error при ошибке ввода-вывода
+     */
+     
+    void encryptFile(const string& inPath, const string& outPath,
+                     size_t memoryBudget = FILE_BUDGET) const;
+    
+    /**
+     * @brief Расшифрование файла UTF-8 в файл без загрузки текста в память
+     * @param inPath путь к шифртексту
+     * @param outPath путь к результату (создается или перезаписывается)
+     * @param memoryBudget ограничение на объем страниц, одновременно
+     * находящихся в памяти процесса, байт
+     * @throw cipher_error если текст невалиден
+     * @throw system_error при ошибке ввода-вывода
+     */
+     
+    void decryptFile(const string& inPath, const string& outPath,
+                     size_t memoryBudget = FILE_BUDGET) const;
+    
+    /**
+     * @brief Стадии разбора и перестановки для stagedPipeline
+     * @param decrypt true — расшифрование, false — шифрование
+     * @param frame длина кадра, букв (больше нуля)
+     * @return набор стадий
+     * @details Перестановка зависит от длины всего текста, поэтому конвейер
+     * делит поток букв на кадры по frame букв (последний короче) и переставляет
+     * каждый кадр отдельно. Если текст не длиннее кадра, результат совпадает
+     * с encryptUtf8/decryptUtf8; иначе шифртекст расшифровывается только
+     * стадиями с тем же frame, а другие режимы примут его без ошибки и выдадут
+     * неверный текст. С frame = STAGE_WHOLE перестановка ждет конца потока
+     * и результат всегда совпадает с encryptUtf8/decryptUtf8.
+     * Шифртекст проверяется поблочно, поэтому
+     * пробел имеет приоритет над другими ошибками только внутри блока
+     * @warning Набор хранит указатель на шифр, шифр должен существовать дольше
+     */
+    stageSet stages(bool decrypt, size_t frame = STAGE_FRAME) const;
+};
+
+/**
+ * @brief Потоковый сеанс шифрования/расшифрования текста в UTF-8 по частям
+ * @details Перестановка зависит от длины всего текста, поэтому части только
+ * проверяются и накапливаются как номера букв (байт на букву),
+ * а результат целиком выдается в finish. Позволяет совместить разбор текста
+ * с чтением следующих частей с диска.
+ * @warning Сеанс хранит ссылку на шифр, шифр должен существовать дольше сеанса
+ */
+class tableStream
+{
+private:
+    const Table& table; ///< Шифр с установленным ключом
+    bool back; ///< true — расшифрование, false — шифрование
+    letterBuffer letters; ///< Накопленные номера букв
+    size_t bytes = 0; ///< Количество принятых байтов
+    bool invalid = false; ///< В шифртексте встретился недопустимый символ
+    unsigned char tail[4]; ///< Незавершенный символ UTF-8 с конца предыдущей части
+    size_t tailLen = 0; ///< Длина незавершенного символа
+    
+public:
+    /**
+     * @brief Конструктор сеанса
+     * @param t шифр с установленным ключом
+     * @param decrypt true — расшифрование, false — шифрование
+     */
+    tableStream(const Table& t, bool decrypt);
+    
+    /**
+     * @brief Прием очередной части текста в UTF-8
+     * @param data часть текста; может обрываться посреди символа
+     * @param len длина части в байтах
+     * @throw cipher_error если в шифртексте есть пробельный символ
+     */
+    void update(const char* data, size_t len);
+    
+    /**
+     * @brief Завершение сеанса и перестановка
+     * @param out результат в UTF-8 дописывается в конец
+     * @throw cipher_error если текст невалиден (правила как у encrypt/decrypt)
+     */
+    void finish(string& out);
+};
+
+/**
+ * @brief Чтение произвольных участков зашифрованного файла
+ * @details Файл отображается в память один раз, формат (UTF-8 или
+ * упакованный packedText) определяется по сигнатуре. Чтение участка
+ * открытого текста собирает буквы по позициям tableRoute::cipherPos,
+ * касаясь только страниц с этими буквами. Буквы проверяются только
+ * при чтении, заголовок упакованного файла — при открытии. Методы
+ * константные, один экземпляр можно читать из нескольких потоков.
+ * @warning Читатель хранит ссылку на шифр, шифр должен существовать дольше
+ */
+class tableReader
+{
+private:
+    const Table& table; ///< Шифр с установленным ключом
+    mappedFile file; ///< Отображение файла
+    bool isPacked = false; ///< true — упакованный формат
+    size_t letters = 0; ///< Количество букв шифртекста
+    
+public:
+    /**
+     * @brief Открытие файла шифртекста
+     * @param t шифр с установленным ключом
+     * @param path путь к шифртексту в UTF-8 или в упакованном формате
+     * @throw cipher_error если файл пуст, имеет нечетную длину (UTF-8) или
+     * заголовок не подходит к шифру и ключу (упакованный формат)
+     * @throw system_error при ошибке ввода-вывода
+     */
+    tableReader(const Table& t, const string& path);
+    
+    /**
+     * @brief Количество букв шифртекста
+     * @return длина расшифрованного текста в буквах
+     */
+    size_t size() const { return letters; }
+    
+    /**
+     * @brief Формат файла
+     * @return true — упакованный, false — UTF-8
+     */
+    bool packed() const { return isPacked; }
+    
+    /**
+     * @brief Расшифрование участка файла
+     * @param offset номер первой буквы открытого текста
+     * @param length количество букв; обрезается по концу текста
+     * @return открытый текст участка в UTF-8
+     * @throw cipher_error если offset больше size() или участок содержит
+     * недопустимые буквы
+     */
+    string read(size_t offset, size_t length) const;
 };
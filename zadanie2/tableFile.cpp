@@ -0,0 +1,269 @@
+/**
+ * @file tableFile.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Шифрование табличной перестановкой файлов, не помещающихся в память
+ * @details Прописная буква в UTF-8 занимает ровно два байта, поэтому
+ * валидированный текст хранится в файле как массив 16-битных слов и
+ * переставляется между двумя отображениями (mmap) без перекодирования.
+ * Перестановка идет квадратными плитками: полоса столбцов, внутри нее полосы
+ * строк. После каждой плитки ее страницы с обеих сторон освобождаются через
+ * madvise(MADV_DONTNEED), поэтому объем страниц в памяти процесса ограничен
+ * бюджетом, а не размером файла. Сверх бюджета ядро может отобразить соседние
+ * чистые страницы из страничного кэша (fault-around), они вытесняются без записи.
+ * Здесь же tableReader — чтение отдельных участков зашифрованного файла.
+ */
+
+#include "table.h"
+#include "routeTranspose.h"
+#include "../common/mappedFile.h"
+#include "../common/ruUtf8.h"
+#include "../common/packedText.h"
+#include <cmath>
+#include <sys/mman.h>
+using namespace std;
+
+/**
+ * @brief Каталог, в котором находится файл
+ * @param path путь к файлу
+ * @return путь к каталогу
+ */
+ 
+static string dirOf(const string& path)
+{
+    size_t slash = path.rfind('/');
+    return slash == string::npos ? string(".") : path.substr(0, slash);
+}
+
+/**
+ * @brief Перестановка между отображенными файлами плитками с освобождением страниц
+ * @param inMap исходный текст (16-битные слова)
+ * @param outMap результат (16-битные слова)
+ * @param route геометрия таблицы
+ * @param back false — шифрование, true — расшифрование
+ * @param budget бюджет памяти, байт
+ * @details Плитка side x side букв занимает около 2 * side * side байт с каждой
+ * стороны, отсюда side = sqrt(budget / 4). Нижняя граница 2048 букв дает
+ * отрезки строк и столбцов не короче страницы.
+ */
+ 
+static void transposeFile(const mappedFile& inMap, const mappedFile& outMap,
+                          const tableRoute& route, bool back, size_t budget)
+{
+    const uint16_t* in = reinterpret_cast<const uint16_t*>(inMap.data());
+    uint16_t* out = reinterpret_cast<uint16_t*>(outMap.data());
+    const mappedFile& plainMap = back ? outMap : inMap;
+    const mappedFile& cipherMap = back ? inMap : outMap;
+    size_t side = max<size_t>(2048, sqrt(double(budget) / 4));
+    size_t usedCols = min(route.cols, route.n);
+    
+    for (size_t c0 = 0; c0 < usedCols; c0 += side) {
+        size_t c1 = min(usedCols, c0 + side);
+        size_t cipherFrom = route.columnStart(c1 - 1);
+        size_t cipherTo = route.columnStart(c0) + route.columnHeight(c0);
+        for (size_t r0 = 0; r0 < route.rows; r0 += side) {
+            size_t r1 = min(route.rows, r0 + side);
+            routeTiled(in, out, route, back, r0, r1, c0, c1);
+            plainMap.release(RU_UTF8_LETTER * r0 * route.cols,
+                             RU_UTF8_LETTER * (r1 - r0) * route.cols);
+            cipherMap.release(RU_UTF8_LETTER * cipherFrom,
+                              RU_UTF8_LETTER * (cipherTo - cipherFrom));
+        }
+    }
+}
+
+/**
+ * @brief Шифрование файла UTF-8 в файл без загрузки текста в память
+ * @param inPath путь к открытому тексту
+ * @param outPath путь к результату
+ * @param memoryBudget ограничение на объем страниц в памяти процесса, байт
+ * @throw cipher_error если текст невалиден
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+void Table::encryptFile(const string& inPath, const string& outPath, size_t memoryBudget) const
+{
+    checkDistinctFiles(inPath, outPath);
+    mappedFile src(inPath);
+    src.advise(0, src.size(), MADV_SEQUENTIAL);
+    
+    // Каждая буква занимает во входном UTF-8 не меньше двух байт,
+    // поэтому временный файл размера входного гарантированно вмещает текст
+    mappedFile letters = mappedFile::temporary(dirOf(outPath), src.size());
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(src.data());
+    uint16_t* units = reinterpret_cast<uint16_t*>(letters.data());
+    size_t n = 0;
+    size_t released = 0;
+    size_t releasedLetters = 0;
+    
+    for (size_t pos = 0; pos < src.size();) {
+        wchar_t c;
+        pos += ruUtf8Next(p + pos, src.size() - pos, c);
+        uint8_t cls = ruClassify(c);
+        if (ruIsLetter(cls)) {
+            units[n++] = ruUtf8Unit(ruIndex(cls));
+        }
+        if (pos - released >= memoryBudget / 2) {
+            src.release(released, pos - released);
+            letters.release(RU_UTF8_LETTER * releasedLetters,
+                            RU_UTF8_LETTER * (n - releasedLetters));
+            released = pos;
+            releasedLetters = n;
+        }
+    }
+    src.release(0, src.size());
+    if (n == 0)
+        throw cipher_error("Empty open text");
+    
+    tableRoute route(n, cols);
+    mappedFile dst(outPath, RU_UTF8_LETTER * n);
+    transposeFile(letters, dst, route, false, memoryBudget);
+}
+
+/**
+ * @brief Расшифрование файла UTF-8 в файл без загрузки текста в память
+ * @param inPath путь к шифртексту
+ * @param outPath путь к результату
+ * @param memoryBudget ограничение на объем страниц в памяти процесса, байт
+ * @details Проверка шифртекста выполняется по тем же правилам, что и в
+ * getValidCipherText. Корректный шифртекст уже является массивом 16-битных
+ * слов, поэтому переставляется прямо из отображения входного файла.
+ * @throw cipher_error если текст невалиден
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+void Table::decryptFile(const string& inPath, const string& outPath, size_t memoryBudget) const
+{
+    checkDistinctFiles(inPath, outPath);
+    mappedFile src(inPath);
+    if (src.size() == 0)
+        throw cipher_error("Empty cipher text");
+    src.advise(0, src.size(), MADV_SEQUENTIAL);
+    
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(src.data());
+    bool invalid = false;
+    size_t released = 0;
+    for (size_t pos = 0; pos < src.size();) {
+        wchar_t c;
+        pos += ruUtf8Next(p + pos, src.size() - pos, c);
+        uint8_t cls = ruClassify(c);
+        if (cls == RU_CLASS_SPACE)
+            throw cipher_error("Whitespace in cipher text");
+        if (!ruIsUpper(cls))
+            invalid = true;
+        if (pos - released >= memoryBudget / 2) {
+            src.release(released, pos - released);
+            released = pos;
+        }
+    }
+    if (invalid)
+        throw cipher_error("Invalid cipher text");
+    src.release(0, src.size());
+    
+    tableRoute route(src.size() / RU_UTF8_LETTER, cols);
+    mappedFile dst(outPath, src.size());
+    transposeFile(src, dst, route, true, memoryBudget);
+}
+
+/**
+ * @brief Открытие файла шифртекста
+ * @param t шифр с установленным ключом
+ * @param path путь к шифртексту в UTF-8 или в упакованном формате
+ * @details Доступ к страницам случайный (MADV_RANDOM): буквы участка
+ * разбросаны по столбцам, упреждающее чтение соседних страниц не нужно
+ * @throw cipher_error если файл пуст, имеет нечетную длину или заголовок
+ * не подходит к шифру и ключу
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+tableReader::tableReader(const Table& t, const string& path):
+    table(t), file(path)
+{
+    string_view data(file.data(), file.size());
+    if (packedIsContainer(data)) {
+        packedHeader header;
+        packedStatus status = packedOpen(data, PACKED_TABLE, table.keyFingerprint(), header);
+        if (status != PACKED_OK)
+            throw cipher_error(packedMessage(status));
+        isPacked = true;
+        letters = header.length;
+    } else {
+        if (data.size() % RU_UTF8_LETTER != 0)
+            throw cipher_error("Invalid cipher text");
+        letters = data.size() / RU_UTF8_LETTER;
+    }
+    if (letters == 0)
+        throw cipher_error("Empty cipher text");
+    file.advise(0, file.size(), MADV_RANDOM);
+}
+
+/**
+ * @brief Расшифрование участка файла
+ * @param offset номер первой буквы открытого текста
+ * @param length количество букв; обрезается по концу текста
+ * @return открытый текст участка в UTF-8
+ * @throw cipher_error если offset больше size() или участок содержит
+ * недопустимые буквы
+ */
+ 
+string tableReader::read(size_t offset, size_t length) const
+{
+    if (!isPacked)
+        return table.decryptRange(string_view(file.data(), file.size()), offset, length);
+    if (offset > letters)
+        throw cipher_error("Range out of cipher text");
+    length = min(length, letters - offset);
+    tableRoute route(letters, table.cols);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(file.data()) + PACKED_HEADER;
+    letterBuffer tmp(length);
+    bool valid = true;
+    route.forEachCipherPos(offset, length, [&](size_t k, size_t pos) {
+        valid &= unpackRange(p, pos, 1, &tmp[k]);
+    });
+    if (!valid)
+        throw cipher_error(packedMessage(PACKED_BAD_LETTER));
+    string out(RU_UTF8_LETTER * length, '\0');
+    ruEncodeUpper(tmp.data(), length, &out[0]);
+    return out;
+}
+
+/**
+ * @brief Стадии разбора и перестановки для stagedPipeline
+ * @param decrypt true — расшифрование, false — шифрование
+ * @param frame длина кадра, букв
+ * @return набор стадий
+ * @details Ядро копит буквы в неполном кадре и отдает только целые кадры,
+ * переставленные по tableRoute длины кадра; на последнем блоке отдается
+ * и остаток. Блок без целого кадра уходит на запись пустым
+ */
+ 
+stageSet Table::stages(bool decrypt, size_t frame) const
+{
+    stageSet set;
+    if (decrypt) {
+        set.decode = [this](const char* data, size_t len, uint8_t* out) {
+            return decodeCipher(string_view(data, len), out);
+        };
+    } else {
+        set.decode = [](const char* data, size_t len, uint8_t* out) {
+            return ruDecodeOpen(data, len, out);
+        };
+    }
+    frame = max<size_t>(frame, 1);
+    set.kernel = [this, decrypt, frame, pending = letterBuffer(), total = size_t(0)]
+                 (letterBuffer& letters, bool last) mutable {
+        total += letters.size();
+        if (last && total == 0)
+            throw cipher_error(decrypt ? "Empty cipher text" : "Empty open text");
+        pending.insert(pending.end(), letters.begin(), letters.end());
+        size_t ready = last ? pending.size() : pending.size() / frame * frame;
+        letters.resize(ready);
+        for (size_t pos = 0; pos < ready; pos += frame) {
+            tableRoute route(min(frame, ready - pos), cols);
+            routeTranspose(pending.data() + pos, letters.data() + pos, route, decrypt);
+        }
+        pending.erase(pending.begin(), pending.begin() + ready);
+    };
+    return set;
+}
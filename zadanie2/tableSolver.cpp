@@ -0,0 +1,244 @@
+/**
+ * @file tableSolver.cpp
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Реализация подбора количества столбцов табличной перестановки
+ */
+
+#include "tableSolver.h"
+#include "../common/mappedFile.h"
+#include "../common/ruAlphabet.h"
+#include "../common/ruUtf8.h"
+#include "../common/threadPool.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+/**
+ * @brief Загрузка модели из файла
+ * @param path путь к файлу модели
+ * @details Строка разбирается на n-грамму до первого пробела и десятичное
+ * количество после него; n-грамма декодируется ruDecodeOpen и должна
+ * состоять только из букв
+ * @throw cipher_error если файл пуст или строка не соответствует формату
+ * @throw system_error при ошибке ввода-вывода
+ */
+ 
+ngramModel::ngramModel(const string& path)
+{
+    mappedFile file(path);
+    string_view data(file.data(), file.size());
+    vector<pair<size_t, double>> counts;
+    double total = 0;
+    while (!data.empty()) {
+        size_t eol = data.find('\n');
+        string_view line = data.substr(0, eol);
+        data.remove_prefix(eol == string_view::npos ? data.size() : eol + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (line.empty())
+            continue;
+        
+        size_t space = line.find(' ');
+        string_view gram = line.substr(0, space);
+        string_view number = space == string_view::npos ? string_view() : line.substr(space + 1);
+        uint8_t letters[MAX_ORDER + 1];
+        size_t len = gram.size() / RU_UTF8_LETTER;
+        if (len == 0 || len > MAX_ORDER || gram.size() != RU_UTF8_LETTER * len ||
+            ruDecodeOpen(gram.data(), gram.size(), letters) != len ||
+            (order != 0 && len != order) || number.empty() || number.size() > 15 ||
+            !all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            throw cipher_error("Invalid n-gram model");
+        order = len;
+        size_t index = 0;
+        for (size_t i = 0; i < len; ++i)
+            index = index * RU_ALPHABET_SIZE + letters[i];
+        double count = stod(string(number));
+        counts.emplace_back(index, count);
+        total += count;
+    }
+    if (order == 0 || total == 0)
+        throw cipher_error("Invalid n-gram model");
+    
+    for (size_t i = 0; i < order; ++i)
+        modulus *= RU_ALPHABET_SIZE;
+    logProb.assign(modulus, float(log10(0.01 / total)));
+    for (auto [index, count] : counts) {
+        if (count > 0)
+            logProb[index] = float(log10(count / total));
+    }
+}
+
+/**
+ * @brief Оценка текста
+ * @param letters номера букв
+ * @param n количество букв
+ * @return сумма оценок всех n-грамм текста
+ */
+ 
+double ngramModel::score(const uint8_t* letters, size_t n) const
+{
+    double total = 0;
+    size_t index = 0;
+    for (size_t k = 0; k < n; ++k) {
+        index = (index * RU_ALPHABET_SIZE + letters[k]) % modulus;
+        if (k + 1 >= order)
+            total += logProb[index];
+    }
+    return total;
+}
+
+/**
+ * @brief Порядок кандидатов: большая оценка, при равенстве меньше столбцов
+ * @param a первый кандидат
+ * @param b второй кандидат
+ * @return true если a лучше b
+ */
+ 
+static bool betterCandidate(const columnCandidate& a, const columnCandidate& b)
+{
+    return a.score > b.score || (a.score == b.score && a.cols < b.cols);
+}
+
+/**
+ * @brief Конструктор
+ * @param m n-граммная модель
+ */
+ 
+tableSolver::tableSolver(const ngramModel& m):
+    model(m)
+{
+}
+
+/**
+ * @brief Разбор кандидатов на общем пуле потоков
+ * @param p пул потоков, nullptr — однопоточный режим
+ * @details Не синхронизируется с solve в других потоках
+ */
+ 
+void tableSolver::setParallel(shared_ptr<threadPool> p)
+{
+    pool = move(p);
+}
+
+/**
+ * @brief Разбор кандидатов на собственном пуле
+ * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+ */
+ 
+void tableSolver::setParallel(unsigned threads)
+{
+    setParallel(threads == 1 ? nullptr : make_shared<threadPool>(threads));
+}
+
+/**
+ * @brief Оценка одного кандидата без выделения памяти
+ * @param cipher номера букв шифртекста
+ * @param n количество букв
+ * @param cols количество столбцов
+ * @return сумма оценок n-грамм открытого текста для cols
+ * @details Номер n-граммы обновляется без деления: вычитается вклад
+ * буквы, покинувшей окно (последние буквы хранятся по байту в слове).
+ */
+ 
+double tableSolver::scoreColumns(const uint8_t* cipher, size_t n, size_t cols) const
+{
+    const size_t order = model.length();
+    const size_t modulus = model.size();
+    const unsigned leaving = 8 * (order - 1);
+    tableRoute route(n, cols);
+    size_t index = 0;
+    uint32_t window = 0;
+    double total = 0;
+    route.forEachCipherPos(0, n, [&](size_t k, size_t pos) {
+        uint8_t letter = cipher[pos];
+        index = index * RU_ALPHABET_SIZE + letter - ((window >> leaving) & 0xFF) * modulus;
+        window = window << 8 | letter;
+        if (k + 1 >= order)
+            total += model[index];
+    });
+    return total;
+}
+
+/**
+ * @brief Подбор количества столбцов по номерам букв шифртекста
+ * @param cipher номера букв
+ * @param n количество букв
+ * @param maxCols наибольшее проверяемое количество столбцов
+ * @param topK количество возвращаемых кандидатов
+ * @return лучшие кандидаты по убыванию оценки
+ * @details Поток w проверяет cols = w + 1, w + 1 + W, ... и ведет свой
+ * список лучших с емкостью topK + 1, выделенной до начала перебора;
+ * списки объединяются после завершения всех потоков
+ * @throw cipher_error если шифртекст пуст или maxCols, topK равны нулю
+ */
+ 
+vector<columnCandidate> tableSolver::solve(const uint8_t* cipher, size_t n, size_t maxCols,
+                                           size_t topK) const
+{
+    if (n == 0)
+        throw cipher_error("Empty cipher text");
+    if (maxCols == 0 || topK == 0)
+        throw cipher_error("Invalid solver limits");
+    size_t count = min(maxCols, n);
+    size_t workers = pool ? min<size_t>(pool->size(), count) : 1;
+    vector<vector<columnCandidate>> best(workers);
+    for (auto& top : best)
+        top.reserve(topK + 1);
+    
+    auto run = [&](size_t w) {
+        vector<columnCandidate>& top = best[w];
+        for (size_t cols = w + 1; cols <= count; cols += workers) {
+            columnCandidate cand{int(cols), scoreColumns(cipher, n, cols)};
+            if (top.size() == topK && !betterCandidate(cand, top.back()))
+                continue;
+            top.insert(upper_bound(top.begin(), top.end(), cand, betterCandidate), cand);
+            if (top.size() > topK)
+                top.pop_back();
+        }
+    };
+    if (workers > 1) {
+        pool->parallelFor(workers, run);
+    } else {
+        run(0);
+    }
+    
+    vector<columnCandidate> merged;
+    for (const auto& top : best)
+        merged.insert(merged.end(), top.begin(), top.end());
+    sort(merged.begin(), merged.end(), betterCandidate);
+    if (merged.size() > topK)
+        merged.resize(topK);
+    return merged;
+}
+
+/**
+ * @brief Подбор количества столбцов по шифртексту в UTF-8
+ * @param cipher шифртекст из прописных букв
+ * @param maxCols наибольшее проверяемое количество столбцов
+ * @param topK количество возвращаемых кандидатов
+ * @return лучшие кандидаты по убыванию оценки
+ * @details Ошибки разбора сообщаются теми же текстами и с тем же приоритетом
+ * пробелов, что и в Table::decodeCipher
+ * @throw cipher_error если шифртекст невалиден или maxCols, topK равны нулю
+ */
+ 
+vector<columnCandidate> tableSolver::solve(string_view cipher, size_t maxCols, size_t topK) const
+{
+    letterBuffer letters(cipher.size() / RU_UTF8_LETTER);
+    ruDecodeResult res = ruDecodeCipher(cipher.data(), cipher.size(), letters.data());
+    if (res.status == RU_TEXT_INVALID) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(cipher.data());
+        for (size_t pos = res.errorPos; pos < cipher.size();) {
+            wchar_t c;
+            pos += ruUtf8Next(p + pos, cipher.size() - pos, c);
+            if (ruClassify(c) == RU_CLASS_SPACE)
+                throw cipher_error("Whitespace in cipher text");
+        }
+        throw cipher_error("Invalid cipher text");
+    }
+    if (res.status == RU_TEXT_SPACE)
+        throw cipher_error("Whitespace in cipher text");
+    return solve(letters.data(), res.letters, maxCols, topK);
+}
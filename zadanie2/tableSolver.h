@@ -0,0 +1,157 @@
+/**
+ * @file tableSolver.h
+ * @author Мезин Андрей Андреевич
+ * @version 1.0
+ * @date 2025
+ * @brief Подбор количества столбцов табличной перестановки по шифртексту
+ * @details Для каждого кандидата cols открытый текст не восстанавливается
+ * в буфер: буквы читаются прямо из шифртекста по позициям
+ * tableRoute::forEachCipherPos и сразу оцениваются n-граммной моделью
+ * со скользящим номером n-граммы. Поэтому кандидат не выделяет памяти
+ * и не строит таблицу. Кандидаты распределяются между потоками пула
+ * чередованием, у каждого потока свой заранее выделенный список лучших.
+ * @warning Реализация для русского языка
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "table.h"
+using namespace std;
+
+class threadPool;
+
+/**
+ * @brief n-граммная модель русского текста
+ * @details Файл модели — текст UTF-8, по строке на n-грамму:
+ * буквы n-граммы, пробел и количество вхождений, например "СТВО 41237".
+ * Регистр букв не важен, пустые строки пропускаются, все n-граммы одной
+ * длины от 1 до MAX_ORDER. Оценка n-граммы — десятичный логарифм ее
+ * доли, у отсутствующих — логарифм доли 0,01 вхождения.
+ */
+class ngramModel
+{
+private:
+    size_t order = 0; ///< Длина n-граммы
+    size_t modulus = 1; ///< 33^order — количество возможных n-грамм
+    vector<float> logProb; ///< Оценки по номеру n-граммы sum(l[i] * 33^(order-1-i))
+    
+public:
+    /// Наибольшая длина n-граммы (таблица из 33^4 оценок занимает 4,7 МБ)
+    static const size_t MAX_ORDER = 4;
+    
+    /**
+     * @brief Загрузка модели из файла
+     * @param path путь к файлу модели
+     * @throw cipher_error если файл пуст или строка не соответствует формату
+     * @throw system_error при ошибке ввода-вывода
+     */
+    explicit ngramModel(const string& path);
+    
+    /**
+     * @brief Длина n-граммы
+     * @return n
+     */
+    size_t length() const { return order; }
+    
+    /**
+     * @brief Количество возможных n-грамм
+     * @return 33^n; номер следующей n-граммы равен (номер * 33 + буква) mod 33^n
+     */
+    size_t size() const { return modulus; }
+    
+    /**
+     * @brief Оценка n-граммы по номеру
+     * @param index номер n-граммы меньше size()
+     * @return десятичный логарифм доли
+     */
+    float operator[](size_t index) const { return logProb[index]; }
+    
+    /**
+     * @brief Оценка текста
+     * @param letters номера букв
+     * @param n количество букв
+     * @return сумма оценок всех n-грамм текста
+     */
+    double score(const uint8_t* letters, size_t n) const;
+};
+
+/**
+ * @brief Кандидат на количество столбцов
+ */
+struct columnCandidate {
+    int cols = 0; ///< Количество столбцов
+    double score = 0; ///< Оценка расшифрованного текста моделью
+};
+
+/**
+ * @brief Подбор количества столбцов табличной перестановки
+ * @details Каждый вызов solve копит кандидатов в собственных списках
+ * и только читает модель, поэтому параллельные подборы идут через
+ * один решатель.
+ * @warning Решатель хранит ссылку на модель, модель должна существовать дольше
+ */
+class tableSolver
+{
+private:
+    const ngramModel& model; ///< n-граммная модель
+    shared_ptr<threadPool> pool; ///< Пул потоков (может быть пустым)
+    
+    /**
+     * @brief Оценка одного кандидата без выделения памяти
+     * @param cipher номера букв шифртекста
+     * @param n количество букв
+     * @param cols количество столбцов
+     * @return сумма оценок n-грамм открытого текста для cols
+     */
+    double scoreColumns(const uint8_t* cipher, size_t n, size_t cols) const;
+    
+public:
+    /**
+     * @brief Конструктор
+     * @param m n-граммная модель
+     */
+    explicit tableSolver(const ngramModel& m);
+    
+    /**
+     * @brief Разбор кандидатов на общем пуле потоков
+     * @param p пул потоков, nullptr — однопоточный режим
+     * @details Не синхронизируется с solve в других потоках
+     */
+    void setParallel(shared_ptr<threadPool> p);
+    
+    /**
+     * @brief Разбор кандидатов на собственном пуле
+     * @param threads количество потоков, 0 — по числу ядер, 1 — однопоточный режим
+     */
+    void setParallel(unsigned threads);
+    
+    /**
+     * @brief Подбор количества столбцов по номерам букв шифртекста
+     * @param cipher номера букв
+     * @param n количество букв
+     * @param maxCols наибольшее проверяемое количество столбцов; значения
+     * больше n дают ту же перестановку, что и n, и не проверяются
+     * @param topK количество возвращаемых кандидатов
+     * @return лучшие кандидаты по убыванию оценки (при равенстве — по
+     * возрастанию cols)
+     * @throw cipher_error если шифртекст пуст или maxCols, topK равны нулю
+     */
+    vector<columnCandidate> solve(const uint8_t* cipher, size_t n, size_t maxCols,
+                                  size_t topK = 10) const;
+    
+    /**
+     * @brief Подбор количества столбцов по шифртексту в UTF-8
+     * @param cipher шифртекст из прописных букв
+     * @param maxCols наибольшее проверяемое количество столбцов
+     * @param topK количество возвращаемых кандидатов
+     * @return лучшие кандидаты по убыванию оценки
+     * @throw cipher_error если шифртекст невалиден (правила как у Table::decrypt)
+     * или maxCols, topK равны нулю
+     */
+    vector<columnCandidate> solve(string_view cipher, size_t maxCols, size_t topK = 10) const;
+};
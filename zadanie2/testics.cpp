@@ -9,12 +9,67 @@
 
 #include <UnitTest++/UnitTest++.h>
 #include <string>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
 #include <locale>
 #include <codecvt>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <map>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
 #include "table.h"
+#include "routeTranspose.h"
+#include "tableSolver.h"
+#include "../common/asyncIo.h"
+#include "../common/ruAlphabet.h"
+#include "../common/packedText.h"
+#include "../common/ruUtf8.h"
 
 using namespace std;
 
+/// Счетчик выделений памяти через operator new во всей тестовой программе
+static atomic<size_t> allocationCount(0);
+
+/**
+ * @brief Замена глобального operator new со счетчиком выделений
+ * @param size размер блока
+ * @return выделенный блок
+ */
+ 
+[[gnu::noinline]] void* operator new(size_t size)
+{
+    ++allocationCount;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+/**
+ * @brief Парный operator delete
+ * @param p освобождаемый блок
+ */
+ 
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+/**
+ * @brief Парный operator delete с размером
+ * @param p освобождаемый блок
+ */
+ 
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
 /**
  * @brief Преобразование широкой строки в UTF-8
  * @param ws широкая строка
@@ -195,6 +250,695 @@ SUITE(DecryptTest)
         Table cipher(11);
         CHECK_WIDE_EQUAL(L"ПРИВЕТМИР", cipher.decrypt(L"РИМТЕВИРП"));
     }
+    
+    TEST_FIXTURE(Key3Fixture, ValidateWithoutCipher) {
+        CHECK_EQUAL(size_t(9), cipher->validateOpenText(L"Привет, мир!"));
+        CHECK_EQUAL(size_t(9), cipher->validateCipherText(L"ИТРРЕИПВМ"));
+        CHECK_THROW(cipher->validateOpenText(L"1234"), cipher_error);
+        CHECK_THROW(cipher->validateCipherText(L""), cipher_error);
+        CHECK_THROW(cipher->validateCipherText(L"ИТР РЕИ"), cipher_error);
+        CHECK_THROW(cipher->validateCipherText(L"итр"), cipher_error);
+    }
+}
+
+/**
+ * @brief Эталонное шифрование через построение таблицы
+ * @param text валидированный текст
+ * @param cols количество столбцов
+ * @return текст, считанный сверху вниз, справа налево
+ */
+ 
+wstring gridEncrypt(const wstring& text, size_t cols)
+{
+    size_t rows = (text.size() + cols - 1) / cols;
+    wstring out;
+    for (size_t c = cols; c-- > 0;) {
+        for (size_t r = 0; r < rows; ++r) {
+            if (r * cols + c < text.size())
+                out += text[r * cols + c];
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Тестовый набор для формулы маршрута tableRoute
+ * @details Сравнивает перестановку без таблицы с построением таблицы
+ */
+ 
+SUITE(RouteTest)
+{
+    TEST(MatchesGrid) {
+        wstring alphabet = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+        for (size_t n = 1; n <= 70; ++n) {
+            wstring text;
+            for (size_t i = 0; i < n; ++i)
+                text += alphabet[(i * 7) % alphabet.size()];
+            for (int cols = 1; cols <= 75; ++cols) {
+                Table cipher(cols);
+                wstring enc = cipher.encrypt(text);
+                CHECK_WIDE_EQUAL(gridEncrypt(text, cols), enc);
+                CHECK_WIDE_EQUAL(text, cipher.decrypt(enc));
+            }
+        }
+    }
+    
+    TEST(TiledMatchesSimple) {
+        for (size_t cols : {1, 3, 63, 64, 65, 700, 5000}) {
+            for (size_t n : {1, 100, 20000, 70001}) {
+                tableRoute route(n, cols);
+                vector<int> in(n), simple(n), tiled(n);
+                for (size_t i = 0; i < n; ++i)
+                    in[i] = i;
+                for (bool back : {false, true}) {
+                    routeSimple(in.data(), simple.data(), route, back);
+                    routeTiled(in.data(), tiled.data(), route, back, 0, route.rows, 0, min(cols, n));
+                    CHECK(simple == tiled);
+                }
+            }
+        }
+    }
+    
+    TEST(CipherPosIsPermutation) {
+        tableRoute route(23, 5);
+        vector<bool> seen(23, false);
+        for (size_t i = 0; i < route.n; ++i) {
+            size_t p = route.cipherPos(i);
+            CHECK(p < route.n);
+            CHECK(!seen[p]);
+            seen[p] = true;
+        }
+    }
+}
+
+/**
+ * @brief Тестовый набор для параллельного режима
+ * @details Проверяет совпадение с однопоточным результатом при малом пороге
+ * для деления и по строкам, и по столбцам
+ */
+ 
+SUITE(ParallelTest)
+{
+    TEST(MatchesSingleThread) {
+        wstring text;
+        for (int i = 0; i < 3000; ++i)
+            text += L"Съешь же ещё этих мягких французских булок, да выпей чаю! ";
+        for (int cols : {1, 2, 7, 100, 40000}) {
+            Table single(cols);
+            Table parallel(cols);
+            parallel.setParallel(4, 16);
+            wstring enc = single.encrypt(text);
+            CHECK_WIDE_EQUAL(enc, parallel.encrypt(text));
+            CHECK_WIDE_EQUAL(single.decrypt(enc), parallel.decrypt(enc));
+        }
+    }
+    
+    TEST(ShortTextBelowThreshold) {
+        Table cipher(3);
+        cipher.setParallel(4);
+        CHECK_WIDE_EQUAL(L"ИТРРЕИПВМ", cipher.encrypt(L"ПРИВЕТМИР"));
+    }
+}
+
+/**
+ * @brief Запись строки UTF-8 в файл
+ * @param path путь к файлу
+ * @param text содержимое
+ */
+ 
+void writeFile(const string& path, const string& text)
+{
+    ofstream(path, ios::binary) << text;
+}
+
+/**
+ * @brief Чтение файла целиком
+ * @param path путь к файлу
+ * @return содержимое файла
+ */
+ 
+string readFile(const string& path)
+{
+    ifstream in(path, ios::binary);
+    stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+/**
+ * @brief Тестовый набор для шифрования файлов через отображение в память
+ * @details Малый бюджет памяти заставляет перестановку идти несколькими плитками
+ */
+ 
+SUITE(FileTest)
+{
+    TEST(MatchesStringApi) {
+        wstring text;
+        for (int i = 0; i < 400; ++i)
+            text += L"Съешь же ещё этих мягких булок, 2025! ";
+        writeFile("table_file_test.in", wideToUtf8(text));
+        for (int cols : {1, 3, 5000, 20000}) {
+            Table cipher(cols);
+            cipher.encryptFile("table_file_test.in", "table_file_test.enc", 1 << 20);
+            wstring enc = cipher.encrypt(text);
+            CHECK_EQUAL(wideToUtf8(enc), readFile("table_file_test.enc"));
+            cipher.decryptFile("table_file_test.enc", "table_file_test.dec", 1 << 20);
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(enc)), readFile("table_file_test.dec"));
+        }
+        remove("table_file_test.in");
+        remove("table_file_test.enc");
+        remove("table_file_test.dec");
+    }
+    
+    TEST(InvalidFiles) {
+        Table cipher(3);
+        writeFile("table_file_test.in", "1234, 5678");
+        CHECK_THROW(cipher.encryptFile("table_file_test.in", "table_file_test.out"), cipher_error);
+        writeFile("table_file_test.in", wideToUtf8(L"ИТР РЕИ"));
+        CHECK_THROW(cipher.decryptFile("table_file_test.in", "table_file_test.out"), cipher_error);
+        writeFile("table_file_test.in", wideToUtf8(L"ИТРреи"));
+        CHECK_THROW(cipher.decryptFile("table_file_test.in", "table_file_test.out"), cipher_error);
+        writeFile("table_file_test.in", "");
+        CHECK_THROW(cipher.decryptFile("table_file_test.in", "table_file_test.out"), cipher_error);
+        remove("table_file_test.in");
+    }
+    
+    TEST(SameFileRefused) {
+        Table cipher(3);
+        string text = wideToUtf8(L"ПРИВЕТМИР");
+        writeFile("table_same_test.in", text);
+        CHECK_THROW(cipher.encryptFile("table_same_test.in", "./table_same_test.in"), system_error);
+        CHECK_THROW(cipher.decryptFile("table_same_test.in", "./table_same_test.in"), system_error);
+        CHECK_EQUAL(text, readFile("table_same_test.in"));
+        remove("table_same_test.in");
+    }
+    
+    TEST(MappingErrorsReleaseDescriptor) {
+        // Следующий свободный дескриптор до и после неудачных открытий
+        int before = open("/dev/null", O_RDONLY);
+        close(before);
+        // Каталог открывается, но не отображается
+        CHECK_THROW(mappedFile("."), system_error);
+        // Размер больше допустимого для файла
+        CHECK_THROW(mappedFile("table_map_test.out", size_t(1) << 62), system_error);
+        CHECK(!ifstream("table_map_test.out"));
+        int after = open("/dev/null", O_RDONLY);
+        close(after);
+        CHECK_EQUAL(before, after);
+    }
+}
+
+/**
+ * @brief Тестовый набор для пакетного API
+ * @details Проверяет совпадение с поштучными вызовами encrypt/decrypt
+ */
+ 
+SUITE(BatchTest)
+{
+    TEST(MatchesSingleCalls) {
+        Table cipher(4);
+        vector<wstring> plains = {L"Привет, мир!", L"а", L"С Новым 2024 Годом", L"ЁЖИК"};
+        vector<wstring_view> views(plains.begin(), plains.end());
+        textBatch enc = cipher.encryptBatch(views);
+        CHECK_EQUAL(plains.size(), enc.size());
+        vector<wstring_view> encViews;
+        for (size_t i = 0; i < enc.size(); ++i) {
+            CHECK_WIDE_EQUAL(cipher.encrypt(plains[i]), wstring(enc[i]));
+            encViews.push_back(enc[i]);
+        }
+        textBatch dec = cipher.decryptBatch(encViews);
+        for (size_t i = 0; i < dec.size(); ++i) {
+            CHECK_WIDE_EQUAL(cipher.decrypt(wstring(enc[i])), wstring(dec[i]));
+        }
+    }
+    
+    TEST(InvalidItem) {
+        Table cipher(4);
+        vector<wstring_view> bad = {L"АБВ", L"!!!"};
+        CHECK_THROW(cipher.encryptBatch(bad), cipher_error);
+        vector<wstring_view> badCipher = {L"АБВ", L""};
+        CHECK_THROW(cipher.decryptBatch(badCipher), cipher_error);
+    }
+}
+
+/**
+ * @brief Тестовый набор для API с буфером вызывающего
+ * @details Проверяет результат и отсутствие выделений памяти в установившемся цикле
+ */
+ 
+SUITE(IntoTest)
+{
+    TEST(IntoCallerBuffer) {
+        Table cipher(5);
+        wstring plain = L"Съешь же ещё этих мягких булок, да выпей чаю!";
+        wstring enc = cipher.encrypt(plain);
+        wchar_t out[64];
+        size_t n = cipher.encrypt(plain, out);
+        CHECK_WIDE_EQUAL(enc, wstring(out, n));
+        n = cipher.decrypt(enc, out);
+        CHECK_WIDE_EQUAL(cipher.decrypt(enc), wstring(out, n));
+        CHECK_THROW(cipher.encrypt(plain, span<wchar_t>(out, 3)), cipher_error);
+        CHECK_THROW(cipher.decrypt(enc, span<wchar_t>(out, 3)), cipher_error);
+    }
+    
+    TEST(SteadyStateWithoutAllocations) {
+        Table cipher(5);
+        wstring plain = L"Съешь же ещё этих мягких булок, да выпей чаю!";
+        wchar_t enc[64];
+        wchar_t dec[64];
+        cipher.encrypt(plain, enc);
+        size_t before = allocationCount;
+        for (int i = 0; i < 1000; ++i) {
+            size_t n = cipher.encrypt(plain, enc);
+            cipher.decrypt(wstring_view(enc, n), dec);
+        }
+        CHECK_EQUAL(before, size_t(allocationCount));
+    }
+}
+
+SUITE(StreamTest)
+{
+    TEST(Utf8ChunksMatchWhole) {
+        Table cipher(4);
+        wstring text = L"Съешь же ещё этих мягких булок, €𝄞 да выпей чаю!";
+        string utf8 = wideToUtf8(text);
+        for (size_t step = 1; step <= 5; ++step) {
+            tableStream enc(cipher, false);
+            for (size_t i = 0; i < utf8.size(); i += step)
+                enc.update(utf8.data() + i, min(step, utf8.size() - i));
+            string out;
+            enc.finish(out);
+            CHECK_EQUAL(wideToUtf8(cipher.encrypt(text)), out);
+            
+            tableStream dec(cipher, true);
+            for (size_t i = 0; i < out.size(); i += step)
+                dec.update(out.data() + i, min(step, out.size() - i));
+            string back;
+            dec.finish(back);
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(cipher.encrypt(text))), back);
+        }
+    }
+    
+    TEST(ValidationOrder) {
+        Table cipher(3);
+        string out;
+        tableStream empty(cipher, true);
+        CHECK_THROW(empty.finish(out), cipher_error);
+        tableStream noLetters(cipher, false);
+        noLetters.update("123", 3);
+        CHECK_THROW(noLetters.finish(out), cipher_error);
+        // Недопустимый символ до пробела: все равно сообщается о пробеле
+        tableStream spaced(cipher, true);
+        string bad = wideToUtf8(L"Иб И");
+        CHECK_THROW(spaced.update(bad.data(), bad.size()), cipher_error);
+        tableStream lower(cipher, true);
+        string low = wideToUtf8(L"ИТРреи");
+        lower.update(low.data(), low.size());
+        CHECK_THROW(lower.finish(out), cipher_error);
+        CHECK(out.empty());
+    }
+    
+    TEST(PipelineMatchesStringApi) {
+        wstring text;
+        for (int i = 0; i < 300; ++i)
+            text += L"Ёжик в тумане, 2025! ";
+        writeFile("table_pipe_test.in", wideToUtf8(text));
+        Table cipher(7);
+        for (bool uring : {true, false}) {
+            tableStream enc(cipher, false);
+            filePipeline pipeline(3, 101, uring);
+            pipelineStats stats = pipeline.run("table_pipe_test.in", "table_pipe_test.enc",
+                [&](const char* data, size_t len, bool last, string& out) {
+                    enc.update(data, len);
+                    if (last)
+                        enc.finish(out);
+                });
+            CHECK_EQUAL(wideToUtf8(cipher.encrypt(text)), readFile("table_pipe_test.enc"));
+            CHECK_EQUAL(stats.bytesOut, readFile("table_pipe_test.enc").size());
+        }
+        remove("table_pipe_test.in");
+        remove("table_pipe_test.enc");
+    }
+}
+
+SUITE(StagedTest)
+{
+    TEST(FrameLongerThanTextMatchesStringApi) {
+        wstring text;
+        for (int i = 0; i < 300; ++i)
+            text += L"Ёжик в тумане, 2025! ";
+        string plain = wideToUtf8(text);
+        writeFile("table_staged_test.in", plain);
+        Table cipher(7);
+        stagedPipeline enc(cipher.stages(false), 3, 101);
+        stagedStats stats = enc.run("table_staged_test.in", "table_staged_test.enc");
+        string expected = cipher.encryptUtf8(plain);
+        CHECK_EQUAL(expected, readFile("table_staged_test.enc"));
+        CHECK_EQUAL(expected.size(), stats.bytesOut);
+        stagedPipeline dec(cipher.stages(true), 2, 33);
+        dec.run("table_staged_test.enc", "table_staged_test.dec");
+        CHECK_EQUAL(cipher.decryptUtf8(expected), readFile("table_staged_test.dec"));
+        remove("table_staged_test.in");
+        remove("table_staged_test.enc");
+        remove("table_staged_test.dec");
+    }
+    
+    TEST(WholeFrameMatchesStringApi) {
+        wstring text;
+        for (int i = 0; i < 300; ++i)
+            text += L"Съешь же ещё этих мягких булок! ";
+        string plain = wideToUtf8(text);
+        writeFile("table_staged_test.in", plain);
+        Table cipher(7);
+        stagedPipeline enc(cipher.stages(false, Table::STAGE_WHOLE), 3, 37);
+        enc.run("table_staged_test.in", "table_staged_test.enc");
+        string expected = cipher.encryptUtf8(plain);
+        CHECK_EQUAL(expected, readFile("table_staged_test.enc"));
+        stagedPipeline dec(cipher.stages(true, Table::STAGE_WHOLE), 4, 64);
+        dec.run("table_staged_test.enc", "table_staged_test.dec");
+        CHECK_EQUAL(cipher.decryptUtf8(expected), readFile("table_staged_test.dec"));
+        remove("table_staged_test.in");
+        remove("table_staged_test.enc");
+        remove("table_staged_test.dec");
+    }
+    
+    TEST(FramesPermutedIndependently) {
+        wstring text;
+        for (int i = 0; i < 300; ++i)
+            text += L"Съешь же ещё этих мягких булок! ";
+        string plain = wideToUtf8(text);
+        letterBuffer letters(plain.size());
+        letters.resize(ruDecodeOpen(plain.data(), plain.size(), letters.data()));
+        string upper(RU_UTF8_LETTER * letters.size(), '\0');
+        ruEncodeUpper(letters.data(), letters.size(), &upper[0]);
+        
+        const size_t frame = 50;
+        Table cipher(7);
+        string expected;
+        for (size_t pos = 0; pos < upper.size(); pos += RU_UTF8_LETTER * frame)
+            expected += cipher.encryptUtf8(upper.substr(pos, RU_UTF8_LETTER * frame));
+        writeFile("table_staged_test.in", plain);
+        stagedPipeline enc(cipher.stages(false, frame), 3, 37);
+        enc.run("table_staged_test.in", "table_staged_test.enc");
+        CHECK_EQUAL(expected, readFile("table_staged_test.enc"));
+        stagedPipeline dec(cipher.stages(true, frame), 4, 64);
+        dec.run("table_staged_test.enc", "table_staged_test.dec");
+        CHECK_EQUAL(upper, readFile("table_staged_test.dec"));
+        remove("table_staged_test.in");
+        remove("table_staged_test.enc");
+        remove("table_staged_test.dec");
+    }
+    
+    TEST(ErrorsRemoveOutput) {
+        Table cipher(3);
+        stagedPipeline dec(cipher.stages(true), 2, 16);
+        writeFile("table_staged_test.in", wideToUtf8(wstring(500, L'И') + L"ТР РЕИ"));
+        CHECK_THROW(dec.run("table_staged_test.in", "table_staged_test.out"), cipher_error);
+        CHECK(!ifstream("table_staged_test.out"));
+        writeFile("table_staged_test.in", "");
+        CHECK_THROW(dec.run("table_staged_test.in", "table_staged_test.out"), cipher_error);
+        stagedPipeline enc(cipher.stages(false), 2, 16);
+        writeFile("table_staged_test.in", "1234, 5678");
+        CHECK_THROW(enc.run("table_staged_test.in", "table_staged_test.out"), cipher_error);
+        CHECK(!ifstream("table_staged_test.out"));
+        remove("table_staged_test.in");
+    }
+}
+
+/**
+ * @brief Тестовый набор для API UTF-8 без широких строк
+ * @details Сравнивает encryptUtf8/decryptUtf8 с encrypt/decrypt, в том числе
+ * на параллельном пути и по порядку проверок шифртекста
+ */
+ 
+SUITE(Utf8Test)
+{
+    TEST(MatchesWide) {
+        wstring text;
+        for (int i = 0; i < 5000; ++i)
+            text += wstring(1, RU_UPPER[i % 33]) + (i % 7 ? L"" : L", ё€ ") + RU_LOWER[i % 31];
+        for (int cols : {1, 2, 7, 64, 20000}) {
+            Table cipher(cols);
+            wstring enc = cipher.encrypt(text);
+            CHECK_EQUAL(wideToUtf8(enc), cipher.encryptUtf8(wideToUtf8(text)));
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(enc)), cipher.decryptUtf8(wideToUtf8(enc)));
+            cipher.setParallel(3, 100);
+            CHECK_EQUAL(wideToUtf8(enc), cipher.encryptUtf8(wideToUtf8(text)));
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(enc)), cipher.decryptUtf8(wideToUtf8(enc)));
+        }
+    }
+    
+    TEST(ErrorOrder) {
+        Table cipher(3);
+        CHECK_THROW(cipher.encryptUtf8("12 !"), cipher_error);
+        CHECK_THROW(cipher.decryptUtf8(""), cipher_error);
+        try {
+            cipher.decryptUtf8(wideToUtf8(L"АБ1ВГ Д"));
+            CHECK(false);
+        } catch (const cipher_error& e) {
+            CHECK_EQUAL("Whitespace in cipher text", string(e.what()));
+        }
+        try {
+            cipher.decryptUtf8(wideToUtf8(L"АБ1ВГ\xFFД"));
+            CHECK(false);
+        } catch (const cipher_error& e) {
+            CHECK_EQUAL("Invalid cipher text", string(e.what()));
+        }
+    }
+}
+
+/**
+ * @brief Тестовый набор для упакованного формата
+ * @details Проверяет обратимость через API шифра и проверку шифра и ключа
+ */
+ 
+SUITE(PackedTest)
+{
+    TEST(RoundTripMatchesStringApi) {
+        wstring text;
+        for (int i = 0; i < 3000; ++i)
+            text += wstring(1, RU_UPPER[(i * 5) % 33]) + (i % 11 ? L"" : L" — ");
+        for (int cols : {1, 3, 64, 5000}) {
+            Table cipher(cols);
+            string packed = cipher.encryptPacked(wideToUtf8(text));
+            wstring enc = cipher.encrypt(text);
+            CHECK_EQUAL(PACKED_HEADER + packedBytes(enc.size()), packed.size());
+            CHECK_EQUAL(wideToUtf8(cipher.decrypt(enc)), cipher.decryptPacked(packed));
+        }
+    }
+    
+    TEST(RejectsOtherKeyAndCipher) {
+        string packed = Table(4).encryptPacked("Привет, мир!");
+        CHECK_THROW(Table(5).decryptPacked(packed), cipher_error);
+        string other = packed;
+        other[5] = PACKED_GRONSFELD;
+        CHECK_THROW(Table(4).decryptPacked(other), cipher_error);
+        CHECK_THROW(Table(4).decryptPacked(packed.substr(1)), cipher_error);
+        CHECK_EQUAL(wideToUtf8(L"ПРИВЕТМИР"), Table(4).decryptPacked(packed));
+    }
+}
+
+/**
+ * @brief Тестовый набор для чтения диапазонов
+ * @details Проверяет совпадение с полным расшифрованием и читатель файлов
+ */
+ 
+SUITE(RangeTest)
+{
+    TEST(MatchesFullDecrypt) {
+        wstring text;
+        for (int i = 0; i < 700; ++i)
+            text += RU_UPPER[(i * 11) % 33];
+        for (int cols : {1, 3, 7, 64, 699, 700, 5000}) {
+            Table cipher(cols);
+            wstring enc = cipher.encrypt(text);
+            wstring dec = cipher.decrypt(enc);
+            string enc8 = wideToUtf8(enc);
+            for (size_t off : {size_t(0), size_t(1), size_t(6), size_t(350), size_t(699)}) {
+                for (size_t len : {size_t(0), size_t(1), size_t(8), size_t(1000)}) {
+                    wstring part = dec.substr(off, len);
+                    CHECK(part == cipher.decryptRange(wstring_view(enc), off, len));
+                    CHECK_EQUAL(wideToUtf8(part), cipher.decryptRange(string_view(enc8), off, len));
+                }
+            }
+            CHECK(cipher.decryptRange(wstring_view(enc), enc.size(), 1).empty());
+            CHECK_THROW(cipher.decryptRange(wstring_view(enc), enc.size() + 1, 1), cipher_error);
+        }
+    }
+    
+    TEST(ChecksOnlyGatheredLetters) {
+        // Испорченная первая буква шифртекста стоит в открытом тексте на позиции pos
+        Table cipher(3);
+        wstring enc = cipher.encrypt(L"АБВГДЕЖ");
+        wstring bad = enc;
+        bad[0] = L'!';
+        size_t pos = 0;
+        while (cipher.decrypt(enc)[pos] != enc[0])
+            ++pos;
+        CHECK(cipher.decryptRange(wstring_view(bad), pos + 1, 10) ==
+              cipher.decrypt(enc).substr(pos + 1));
+        CHECK_THROW(cipher.decryptRange(wstring_view(bad), pos, 1), cipher_error);
+        string bad8 = wideToUtf8(enc) + " ";
+        CHECK_THROW(cipher.decryptRange(string_view(bad8), 0, 1), cipher_error);
+        CHECK_THROW(cipher.decryptRange(string_view(), 0, 1), cipher_error);
+    }
+    
+    TEST(ReaderBothFormats) {
+        wstring text;
+        for (int i = 0; i < 500; ++i)
+            text += L"Ёжик в тумане, 2025! ";
+        Table cipher(37);
+        string dec = wideToUtf8(cipher.decrypt(cipher.encrypt(text)));
+        writeFile("table_range_test.enc", wideToUtf8(cipher.encrypt(text)));
+        writeFile("table_range_test.pak", cipher.encryptPacked(wideToUtf8(text)));
+        for (const char* path : {"table_range_test.enc", "table_range_test.pak"}) {
+            tableReader reader(cipher, path);
+            CHECK_EQUAL(string(path).ends_with(".pak"), reader.packed());
+            CHECK_EQUAL(dec.size() / 2, reader.size());
+            for (size_t off : {size_t(0), size_t(5), size_t(1234), reader.size() - 1})
+                CHECK_EQUAL(dec.substr(2 * off, 2 * 77), reader.read(off, 77));
+            CHECK(reader.read(reader.size(), 1).empty());
+            CHECK_THROW(reader.read(reader.size() + 1, 1), cipher_error);
+        }
+        CHECK_THROW(tableReader(Table(36), "table_range_test.pak"), cipher_error);
+        writeFile("table_range_test.enc", "");
+        CHECK_THROW(tableReader(cipher, "table_range_test.enc"), cipher_error);
+        remove("table_range_test.enc");
+        remove("table_range_test.pak");
+    }
+}
+
+/// Русский текст для подбора количества столбцов
+static const char* solverText =
+    "В конце тысяча восемьсот одиннадцатого года, в эпоху нам достопамятную, "
+    "жил в своем поместье добрый помещик. Он славился во всей округе "
+    "гостеприимством и радушием; соседи поминутно ездили к нему поесть, попить, "
+    "поиграть по пяти копеек в бостон с его женою, а некоторые для того, чтоб "
+    "поглядеть на дочку их, стройную, бледную и семнадцатилетнюю девицу. "
+    "Она считалась богатой невестою, и многие прочили ее за себя или за сыновей. "
+    "Девушка была воспитана на французских романах и, следственно, была влюблена. ";
+
+/**
+ * @brief Запись модели триграмм, посчитанных по тексту
+ * @param path путь к файлу модели
+ * @param text текст в UTF-8
+ */
+void writeTrigramModel(const string& path, const string& text)
+{
+    letterBuffer letters(text.size());
+    letters.resize(ruDecodeOpen(text.data(), text.size(), letters.data()));
+    map<wstring, int> counts;
+    for (size_t i = 0; i + 3 <= letters.size(); ++i)
+        ++counts[{RU_UPPER[letters[i]], RU_UPPER[letters[i + 1]], RU_UPPER[letters[i + 2]]}];
+    string model;
+    for (const auto& [gram, count] : counts)
+        model += wideToUtf8(gram) + " " + to_string(count) + "\n";
+    writeFile(path, model);
+}
+
+SUITE(SolverTest)
+{
+    TEST(FindsColumnCount) {
+        writeTrigramModel("table_solver_test.model", solverText);
+        ngramModel model("table_solver_test.model");
+        CHECK_EQUAL(size_t(3), model.length());
+        CHECK_EQUAL(size_t(33 * 33 * 33), model.size());
+        tableSolver solver(model);
+        for (int cols : {2, 7, 13, 40}) {
+            string enc = Table(cols).encryptUtf8(solverText);
+            vector<columnCandidate> top = solver.solve(enc, 60, 5);
+            CHECK_EQUAL(size_t(5), top.size());
+            CHECK_EQUAL(cols, top[0].cols);
+            for (size_t i = 1; i < top.size(); ++i)
+                CHECK(top[i - 1].score >= top[i].score);
+        }
+        string enc = Table(7).encryptUtf8(solverText);
+        CHECK_EQUAL(size_t(3), solver.solve(enc, 3, 10).size());
+        CHECK_EQUAL(size_t(2), solver.solve("АБ", 100, 10).size());
+        remove("table_solver_test.model");
+    }
+    
+    TEST(ParallelMatchesSingleThread) {
+        writeTrigramModel("table_solver_test.model", solverText);
+        ngramModel model("table_solver_test.model");
+        string enc = Table(17).encryptUtf8(string(solverText) + solverText);
+        tableSolver single(model);
+        tableSolver parallel(model);
+        parallel.setParallel(4);
+        vector<columnCandidate> a = single.solve(enc, 200, 20);
+        vector<columnCandidate> b = parallel.solve(enc, 200, 20);
+        CHECK_EQUAL(a.size(), b.size());
+        for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+            CHECK_EQUAL(a[i].cols, b[i].cols);
+            CHECK_EQUAL(a[i].score, b[i].score);
+        }
+        CHECK_EQUAL(17, b[0].cols);
+        remove("table_solver_test.model");
+    }
+    
+    TEST(Errors) {
+        const char* path = "table_solver_test.model";
+        for (const char* bad : {"", "\n\n", "АБ\n", "АБ x\n", "АБ 1\nВ 2\n", "A1 3\n",
+                                "АБВГД 1\n", "АБ -1\n", "АБ 0\n"}) {
+            writeFile(path, bad);
+            CHECK_THROW(ngramModel model(path), cipher_error);
+        }
+        writeFile(path, "аб 3\r\n\r\nВГ 1\r\n");
+        ngramModel model(path);
+        CHECK_EQUAL(size_t(2), model.length());
+        CHECK_CLOSE(log10(0.75), model[1], 1e-6);
+        CHECK_CLOSE(log10(0.25), model[2 * 33 + 3], 1e-6);
+        CHECK_CLOSE(log10(0.0025), model[5], 1e-6);
+        uint8_t letters[] = {0, 1, 0, 1};
+        CHECK_CLOSE(2 * log10(0.75) + log10(0.0025), model.score(letters, 4), 1e-6);
+        tableSolver solver(model);
+        CHECK_THROW(solver.solve("", 10), cipher_error);
+        CHECK_THROW(solver.solve("АБ В", 10), cipher_error);
+        CHECK_THROW(solver.solve("АБв", 10), cipher_error);
+        CHECK_THROW(solver.solve("АБВ", 0), cipher_error);
+        CHECK_THROW(solver.solve("АБВ", 10, 0), cipher_error);
+        for (const auto& [text, message] : {pair<string, string>("АБ1ВГ Д", "Whitespace in cipher text"),
+                                            pair<string, string>("АБ1ВГД", "Invalid cipher text")}) {
+            try {
+                solver.solve(text, 10);
+                CHECK(false);
+            } catch (const cipher_error& e) {
+                CHECK_EQUAL(message, string(e.what()));
+            }
+        }
+        remove(path);
+        CHECK_THROW(ngramModel model(path), system_error);
+    }
+}
+
+SUITE(SharedInstanceTest)
+{
+    TEST(ConstCipherAcrossThreads) {
+        const Table cipher(7);
+        vector<wstring> texts;
+        vector<wstring> expected;
+        for (int i = 0; i < 16; ++i) {
+            texts.push_back(wstring(1 + i * 37, L'А' + i) + L", привет мир " + to_wstring(i));
+            expected.push_back(cipher.encrypt(texts.back()));
+        }
+        atomic<int> mismatches(0);
+        vector<thread> workers;
+        for (int t = 0; t < 8; ++t) {
+            workers.emplace_back([&, t] {
+                wchar_t buf[1024];
+                for (int round = 0; round < 200; ++round) {
+                    size_t i = (t + round) % texts.size();
+                    wstring enc = cipher.encrypt(texts[i]);
+                    size_t n = cipher.decrypt(enc, buf);
+                    if (enc != expected[i] || cipher.decrypt(enc) != wstring(buf, n))
+                        ++mismatches;
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+        CHECK_EQUAL(0, mismatches.load());
+    }
 }
 
 /**